@@ -31,6 +31,8 @@ class QMouseEvent;
 class QWheelEvent;
 class QMatrix4x4;
 template <typename T> class QList;
+class QVector3D;
+class QVector4D;
 
 class QVRDevice;
 class QVRDeviceEvent;
@@ -54,8 +56,14 @@ class QVRProcess;
  * - To signal when your application wants to quit, implement wantExit().
  * - For special process-specific actions, implement initProcess(), exitProcess(),
  *   preRenderProcess(), or postRenderProcess().
+ * - To cull your scene once per process instead of once per view, implement
+ *   updateProcessVisibleSet().
  * - For special window-specific actions, implement initWindow(), exitWindow(),
  *   preRenderWindow(), or postRenderWindow().
+ * - To render all views of a window in a single pass, implement wantLayeredViews().
+ * - To allow rendering windows in parallel threads, implement supportsParallelRendering().
+ * - To render a data set that is distributed across processes into one window
+ *   (sort-last compositing), implement getPartitionBounds().
  * - To support your own navigation scheme, implement it in update(), and call
  *   QVRManager::init() with the appropriate flag to signal that your applications
  *   prefers its own navigation method.
@@ -93,9 +101,49 @@ public:
      * }
      * \endcode
      *
-     * This example renders one or two views sequentially. As an alternative, some
-     * platform-dependent OpenGL extensions allow to render two views at once to reduce
-     * rendering costs.
+     * This example renders one or two views sequentially. As an alternative, an
+     * application can render all views of a window in a single pass: if it returns true
+     * from wantLayeredViews() and \a QVRWindow::layeredViews() confirms this for the window,
+     * then \a textures[0] is a 2D array texture with one layer per view (of identical size),
+     * and \a textures[1] is unused. Layer \a i corresponds to view \a i, i.e. it
+     * uses \a context.frustum(i) and \a context.viewMatrix(i). Such an application
+     * typically attaches all layers to its framebuffer object at once, either via
+     * \c glFramebufferTextureMultiviewOVR() if \c GL_OVR_multiview2 is available, or via
+     * \c glFramebufferTexture() as a fallback, in which case it selects the layer in its
+     * shaders via \c gl_Layer (for example from instanced rendering). For windows in
+     * which \a QVRWindow::layeredViews() is false, it must render the views separately
+     * as shown above.
+     *
+     * Windows that are split into tiles across processes (see \a QVRWindowConfig::tileProcessIds())
+     * need no special handling: each process gets a context whose frusta and texture sizes
+     * cover only its own tile, and the tile proxy windows of the helper processes are
+     * rendered like any other window.
+     * The exception is sort-last compositing (see \a QVRWindowConfig::tileCompositing()):
+     * there, each process renders only its own data partition, and must use
+     * \a QVRWindow::depthTexture() of each view as the depth attachment of its
+     * framebuffer object. The same applies to windows with depth-based reprojection
+     * (see \a QVRWindowConfig::reprojection()), where libqvr uses the depth to warp
+     * stale frames to a newer observer pose, and to windows with temporal upscaling
+     * (see \a QVRWindowConfig::temporalUpscaling()), where it uses the depth to
+     * reproject the samples of previous frames.
+     *
+     * For windows of display-only processes (see \a QVRProcessConfig::displayOnly()),
+     * this function is never called. Instead, the main process calls it for the
+     * corresponding stream source windows (see \a QVRWindowConfig::streamTargetId()).
+     *
+     * If parallel rendering is enabled for the process (see \a QVRProcessConfig::parallelRendering())
+     * and the application supports it (see supportsParallelRendering()),
+     * this function is called concurrently for different windows, each from its own
+     * worker thread with its own OpenGL context. In this case:
+     * - The function must not modify application state that other windows read; all such
+     *   changes belong into update() or preRenderProcess().
+     * - Shareable OpenGL objects (textures, buffers, shaders and programs) created in
+     *   initProcess() or initWindow() can be used, but container objects (framebuffer objects
+     *   and vertex array objects) cannot be shared between contexts and must be created per
+     *   window from within this function.
+     * - preRenderWindow() and postRenderWindow() are still called from the main thread with
+     *   the main context; postRenderWindow() is called only after all windows have finished
+     *   rendering.
      */
     virtual void render(QVRWindow* w, const QVRRenderContext& context, const unsigned int* textures) = 0;
 
@@ -172,6 +220,21 @@ public:
      */
     virtual void preRenderProcess(QVRProcess* p) { Q_UNUSED(p); }
 
+    /*!
+     * \brief Determine the set of visible objects once per frame on each process.
+     * \param p                 The process
+     * \param cullingPlanes     The planes of a conservative volume containing all views of the process
+     * \param cullingPlaneCount The number of planes in \a cullingPlanes
+     *
+     * This function is called once for each process before each frame, after the render contexts
+     * of all windows of the process were computed and before the first window is rendered.
+     * An application can cull its scene against \a cullingPlanes here (e.g. with
+     * \a QVRFrustum::cullSpheres()), and then only test the resulting small set of objects against
+     * the culling planes of each view in \a render() (see \a QVRRenderContext::getCullingPlanes()).
+     * The planes are also available via \a QVRRenderContext::processCullingPlanes().
+     */
+    virtual void updateProcessVisibleSet(QVRProcess* p, const QVector4D* cullingPlanes, int cullingPlaneCount) { Q_UNUSED(p); Q_UNUSED(cullingPlanes); Q_UNUSED(cullingPlaneCount); }
+
     /*!
      * \brief Perform actions once after each frame on each process.
      * \param p         The process
@@ -180,6 +243,53 @@ public:
      */
     virtual void postRenderProcess(QVRProcess* p) { Q_UNUSED(p); }
 
+    /*!
+     * \brief Declare the bounds of the data partition of a process.
+     * \param p             The process
+     * \param minCorner     The minimum corner of the bounding box
+     * \param maxCorner     The maximum corner of the bounding box
+     *
+     * For windows with sort-last compositing (see \a QVRWindowConfig::tileCompositing()),
+     * each participating process renders only the part of the data set that it holds.
+     * Return true and set the axis-aligned bounding box of that part, in the same
+     * virtual world coordinates that \a QVRRenderContext::viewMatrix() expects, so that
+     * libqvr only transfers the screen area that the partition covers. Return false
+     * if the bounds are unknown; the whole window is transferred then.
+     *
+     * In these windows, render() must use \a QVRWindow::depthTexture() as the depth
+     * attachment of its framebuffer object, since the depth values are composited, too.
+     *
+     * Called once per frame on each process that participates in sort-last compositing,
+     * after updateProcessVisibleSet().
+     */
+    virtual bool getPartitionBounds(QVRProcess* p, QVector3D& minCorner, QVector3D& maxCorner)
+    { Q_UNUSED(p); Q_UNUSED(minCorner); Q_UNUSED(maxCorner); return false; }
+
+    /*!
+     * \brief Request layered view textures for a window.
+     * \param w         The window
+     *
+     * Return true if render() can handle a 2D array texture that holds all views of
+     * window \a w as layers. libqvr honors this request only for output modes in which
+     * it processes the views itself; check \a QVRWindow::layeredViews() to find out
+     * whether a window uses layered views.
+     *
+     * Called once per window at initialization time, before initWindow().
+     */
+    virtual bool wantLayeredViews(QVRWindow* w) { Q_UNUSED(w); return false; }
+
+    /*!
+     * \brief Declare support for parallel rendering.
+     *
+     * Return true if render() meets the requirements of parallel rendering described
+     * there, in particular if it creates its framebuffer objects and vertex array
+     * objects per window. A process with \a QVRProcessConfig::parallelRendering()
+     * enabled fails to initialize if this function returns false.
+     *
+     * Called once per process at initialization time, after initWindow().
+     */
+    virtual bool supportsParallelRendering() { return false; }
+
     /*!
      * \brief Initialize a window.
      * \param w         The window
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#include <cstring>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QStringList>
+#include <QSize>
+#include <QFile>
+#include <QImage>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+#include "capture.hpp"
+#include "logging.hpp"
+
+
+// Number of pixel pack buffers per capture stream
+static const int QVRCaptureSlotsPerStream = 3;
+// Number of completed frames that may wait for the writer
+static const int QVRCaptureMaxQueuedFrames = 8;
+
+struct QVRCaptureFrame
+{
+    int stream;
+    qint64 frame;
+    int width, height;
+    QByteArray rgba; // top row first
+};
+
+class QVRCaptureWriter : public QThread
+{
+private:
+    QVRCaptureFormat _format;
+    QStringList _names;
+    float _fps;
+    QVector<QFile*> _videos;
+    QVector<QSize> _videoSizes; // fixed by the Y4M header
+    QMutex _mutex;
+    QWaitCondition _condition;
+    QQueue<QVRCaptureFrame> _queue;
+    bool _exitWanted;
+
+    void writePNG(const QVRCaptureFrame& f);
+    void writeY4M(const QVRCaptureFrame& f);
+
+public:
+    // statistics; only read after the thread finished
+    qint64 writtenFrames;
+    int queueDrops;
+    int sizeDrops;
+    int errors;
+
+    QVRCaptureWriter(QVRCaptureFormat format, const QStringList& names, float fps);
+    ~QVRCaptureWriter();
+
+    // Returns false if the frame was dropped because the queue is full
+    bool enqueue(const QVRCaptureFrame& f);
+    // Write all remaining frames and stop the thread
+    void finish();
+
+protected:
+    void run() override;
+};
+
+QVRCaptureWriter::QVRCaptureWriter(QVRCaptureFormat format, const QStringList& names, float fps) :
+    _format(format), _names(names), _fps(fps), _videos(names.size(), NULL), _videoSizes(names.size()), _exitWanted(false),
+    writtenFrames(0), queueDrops(0), sizeDrops(0), errors(0)
+{
+}
+
+QVRCaptureWriter::~QVRCaptureWriter()
+{
+    for (int i = 0; i < _videos.size(); i++)
+        delete _videos[i];
+}
+
+bool QVRCaptureWriter::enqueue(const QVRCaptureFrame& f)
+{
+    _mutex.lock();
+    bool accepted = (_queue.size() < QVRCaptureMaxQueuedFrames);
+    if (accepted) {
+        _queue.enqueue(f);
+        _condition.wakeOne();
+    } else {
+        queueDrops++;
+    }
+    _mutex.unlock();
+    return accepted;
+}
+
+void QVRCaptureWriter::finish()
+{
+    _mutex.lock();
+    _exitWanted = true;
+    _condition.wakeOne();
+    _mutex.unlock();
+    wait();
+}
+
+void QVRCaptureWriter::run()
+{
+    for (;;) {
+        _mutex.lock();
+        while (_queue.isEmpty() && !_exitWanted)
+            _condition.wait(&_mutex);
+        if (_queue.isEmpty()) {
+            _mutex.unlock();
+            break;
+        }
+        QVRCaptureFrame f = _queue.dequeue();
+        _mutex.unlock();
+        if (_format == QVR_Capture_Y4M)
+            writeY4M(f);
+        else
+            writePNG(f);
+    }
+    for (int i = 0; i < _videos.size(); i++)
+        if (_videos[i])
+            _videos[i]->close();
+}
+
+void QVRCaptureWriter::writePNG(const QVRCaptureFrame& f)
+{
+    QString name = QString("%1-%2.png").arg(_names[f.stream]).arg(f.frame, 6, 10, QChar('0'));
+    QImage img(reinterpret_cast<const uchar*>(f.rgba.constData()), f.width, f.height,
+            4 * f.width, QImage::Format_RGBA8888);
+    if (img.save(name, "PNG")) {
+        writtenFrames++;
+    } else {
+        if (errors == 0)
+            QVR_WARNING("cannot write capture image %s", qPrintable(name));
+        errors++;
+    }
+}
+
+void QVRCaptureWriter::writeY4M(const QVRCaptureFrame& f)
+{
+    QFile*& video = _videos[f.stream];
+    if (!video) {
+        video = new QFile(_names[f.stream] + ".y4m");
+        if (!video->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QVR_WARNING("cannot open capture video %s", qPrintable(video->fileName()));
+        } else {
+            QByteArray header = QString("YUV4MPEG2 W%1 H%2 F%3:1000 Ip A1:1 C444\n")
+                .arg(f.width).arg(f.height).arg(qRound(_fps * 1000.0f)).toLatin1();
+            video->write(header);
+            _videoSizes[f.stream] = QSize(f.width, f.height);
+        }
+    }
+    if (!video->isOpen()) {
+        errors++;
+        return;
+    }
+    if (_videoSizes[f.stream] != QSize(f.width, f.height)) {
+        if (sizeDrops == 0)
+            QVR_WARNING("capture video %s: dropping frames that do not match the initial frame size",
+                    qPrintable(video->fileName()));
+        sizeDrops++;
+        return;
+    }
+    // Convert to Y'CbCr 4:4:4 (BT.601, limited range)
+    int n = f.width * f.height;
+    QByteArray planes(3 * n, Qt::Uninitialized);
+    uchar* y = reinterpret_cast<uchar*>(planes.data());
+    uchar* cb = y + n;
+    uchar* cr = cb + n;
+    const uchar* rgba = reinterpret_cast<const uchar*>(f.rgba.constData());
+    for (int i = 0; i < n; i++) {
+        int r = rgba[4 * i + 0];
+        int g = rgba[4 * i + 1];
+        int b = rgba[4 * i + 2];
+        y[i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+        cb[i] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+        cr[i] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    }
+    video->write("FRAME\n", 6);
+    if (video->write(planes) == planes.size()) {
+        writtenFrames++;
+    } else {
+        if (errors == 0)
+            QVR_WARNING("cannot write capture video %s", qPrintable(video->fileName()));
+        errors++;
+    }
+}
+
+QVRCapture::QVRCapture(const QString& windowId, QVRCaptureMode mode, QVRCaptureFormat format,
+        const QString& prefix, int streamCount, float framesPerSecond) :
+    _windowId(windowId),
+    _writer(NULL),
+    _streamCount(streamCount),
+    _slots(streamCount * QVRCaptureSlotsPerStream),
+    _nextSlot(streamCount, 0),
+    _frameCounter(streamCount, 0),
+    _gpuDrops(0)
+{
+    for (int i = 0; i < _slots.size(); i++) {
+        _slots[i].pbo = 0;
+        _slots[i].fence = NULL;
+        _slots[i].width = -1;
+        _slots[i].height = -1;
+        _slots[i].frame = -1;
+    }
+    QStringList names;
+    for (int s = 0; s < streamCount; s++) {
+        if (mode == QVR_Capture_Views)
+            names.append(prefix + QString("-view%1").arg(s));
+        else
+            names.append(prefix);
+    }
+    _writer = new QVRCaptureWriter(format, names, framesPerSecond);
+    _writer->start(QThread::LowPriority);
+}
+
+QVRCapture::~QVRCapture()
+{
+    _writer->finish();
+    qint64 captured = 0;
+    for (int s = 0; s < _streamCount; s++)
+        captured += _frameCounter[s];
+    QVR_INFO("capture of window %s: %lld frames, %lld written, %d dropped during readback, "
+            "%d dropped by the writer, %d dropped for size changes, %d write errors",
+            qPrintable(_windowId), captured, _writer->writtenFrames, _gpuDrops,
+            _writer->queueDrops, _writer->sizeDrops, _writer->errors);
+    delete _writer;
+}
+
+void QVRCapture::collect(QOpenGLExtraFunctions* gl, int stream, bool wait)
+{
+    // Visit the slots of the stream from oldest to newest; fences signal in order
+    for (int k = 0; k < QVRCaptureSlotsPerStream; k++) {
+        Slot& s = _slots[stream * QVRCaptureSlotsPerStream
+            + (_nextSlot[stream] + k) % QVRCaptureSlotsPerStream];
+        if (!s.fence)
+            continue;
+        GLsync fence = static_cast<GLsync>(s.fence);
+        GLenum r = gl->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (wait && r == GL_TIMEOUT_EXPIRED)
+            r = gl->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if (r == GL_TIMEOUT_EXPIRED)
+            break;
+        gl->glDeleteSync(fence);
+        s.fence = NULL;
+        if (r == GL_WAIT_FAILED) {
+            _gpuDrops++;
+            continue;
+        }
+        QVRCaptureFrame f;
+        f.stream = stream;
+        f.frame = s.frame;
+        f.width = s.width;
+        f.height = s.height;
+        int rowSize = 4 * s.width;
+        gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        const uchar* data = static_cast<const uchar*>(gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                    0, rowSize * s.height, GL_MAP_READ_BIT));
+        if (data) {
+            // OpenGL stores the bottom row first
+            f.rgba.resize(rowSize * s.height);
+            for (int y = 0; y < s.height; y++)
+                std::memcpy(f.rgba.data() + y * rowSize, data + (s.height - 1 - y) * rowSize, rowSize);
+            gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            _writer->enqueue(f);
+        } else {
+            _gpuDrops++;
+        }
+        gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+void QVRCapture::capture(int stream, int width, int height)
+{
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    collect(gl, stream, false);
+    qint64 frame = _frameCounter[stream]++;
+    Slot& s = _slots[stream * QVRCaptureSlotsPerStream + _nextSlot[stream]];
+    if (s.fence) {
+        // all buffers of this stream are still in flight
+        _gpuDrops++;
+        return;
+    }
+    if (s.pbo == 0)
+        gl->glGenBuffers(1, &s.pbo);
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    if (s.width != width || s.height != height) {
+        gl->glBufferData(GL_PIXEL_PACK_BUFFER, 4 * width * height, NULL, GL_STREAM_READ);
+        s.width = width;
+        s.height = height;
+    }
+    gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    s.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.frame = frame;
+    _nextSlot[stream] = (_nextSlot[stream] + 1) % QVRCaptureSlotsPerStream;
+}
+
+void QVRCapture::exitGL()
+{
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    for (int stream = 0; stream < _streamCount; stream++)
+        collect(gl, stream, true);
+    for (int i = 0; i < _slots.size(); i++) {
+        if (_slots[i].pbo != 0) {
+            gl->glDeleteBuffers(1, &(_slots[i].pbo));
+            _slots[i].pbo = 0;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef QVR_CAPTURE_HPP
+#define QVR_CAPTURE_HPP
+
+#include <QString>
+#include <QVector>
+
+#include "config.hpp"
+
+class QOpenGLExtraFunctions;
+class QVRCaptureWriter;
+
+
+/* Asynchronous capture of window contents, used by QVRWindow from its window
+ * thread. Each capture stream (the window output, or one view) reads back into
+ * a ring of pixel pack buffers. A buffer is mapped only after its fence has
+ * signaled, so the window thread never waits for the GPU. Completed frames go
+ * to a writer thread that writes PNG image sequences or Y4M videos.
+ *
+ * Capture never blocks rendering or presentation; instead, a frame is dropped
+ * when all buffers of its stream are still in flight, or when the writer falls
+ * behind. Dropped frames are counted and reported at exit.
+ * These interfaces are only used internally and never exposed to applications. */
+
+class QVRCapture
+{
+private:
+    struct Slot {
+        unsigned int pbo;
+        void* fence;       // GLsync; NULL if the slot is free
+        int width, height;
+        qint64 frame;
+    };
+    QString _windowId;
+    QVRCaptureWriter* _writer;
+    int _streamCount;
+    QVector<Slot> _slots; // _slotsPerStream slots for each stream
+    QVector<int> _nextSlot;
+    QVector<qint64> _frameCounter;
+    int _gpuDrops;
+
+    void collect(QOpenGLExtraFunctions* gl, int stream, bool wait);
+
+public:
+    // Start the writer thread. The file names are derived from the prefix.
+    QVRCapture(const QString& windowId, QVRCaptureMode mode, QVRCaptureFormat format,
+            const QString& prefix, int streamCount, float framesPerSecond);
+    // Stop the writer thread after it has written all queued frames.
+    ~QVRCapture();
+
+    // Read back a frame of the given stream from the read buffer of the
+    // current read framebuffer. The frame is dropped if the ring of the
+    // stream is full. Requires a current OpenGL context.
+    void capture(int stream, int width, int height);
+    // Collect all frames that are still in flight, and delete the buffers.
+    // Requires the same OpenGL context as capture().
+    void exitGL();
+};
+
+#endif
@@ -57,7 +57,8 @@ QVRObserverConfig::QVRObserverConfig() :
     _initialEyeDistance(defaultEyeDistance),
     _initialTrackingPosition(QVector3D(0.0f, defaultEyeHeight, 0.0f)),
     _initialTrackingForwardDirection(QVector3D(0.0f, 0.0f, -1.0f)),
-    _initialTrackingUpDirection(QVector3D(0.0f, 1.0f, 0.0f))
+    _initialTrackingUpDirection(QVector3D(0.0f, 1.0f, 0.0f)),
+    _predictionHorizon(0.0f)
 {
 }
 
@@ -76,7 +77,23 @@ QVRWindowConfig::QVRWindowConfig() :
     _screenCornerTopLeft(QVector3D(0.0f, 0.0f, 0.0f)),
     _screenIsGivenByCenter(true),
     _screenCenter(QVector3D(0.0f, 0.0f, -0.5f)),
-    _renderResolutionFactor(1.0f)
+    _renderResolutionFactor(1.0f),
+    _textureBuffers(1),
+    _renderDivisor(1),
+    _presentLatest(false),
+    _reprojection(QVR_Reprojection_None),
+    _temporalUpscaling(false),
+    _captureMode(QVR_Capture_None),
+    _captureFormat(QVR_Capture_PNG),
+    _capturePrefix(),
+    _tileProcessIds(),
+    _tileCompositing(QVR_Tile_Columns),
+    _tileOwnerId(),
+    _tileOwnerIndex(-1),
+    _tileIndex(0),
+    _streamTargetId(),
+    _streamProcessIndex(-1),
+    _streamWindowIndex(-1)
 {
 }
 
@@ -88,6 +105,10 @@ QVRProcessConfig::QVRProcessConfig() :
     _display(),
     _syncToVBlank(true),
     _decoupledRendering(false),
+    _lateLatching(false),
+    _singlePresentationThread(false),
+    _parallelRendering(false),
+    _displayOnly(false),
     _windowConfigs()
 {
 }
@@ -315,21 +336,22 @@ bool QVRConfig::readFromFile(const QString& filename)
             } else if (cmd == "tracking" && arglist.length() >= 1
                     && (arglist[0] == "none" || arglist[0] == "static" || arglist[0] == "vrpn"
                         || arglist[0] == "oculus" || arglist[0] == "openvr"
-                        || arglist[0] == "googlevr")) {
+                        || arglist[0] == "googlevr" || arglist[0] == "synthetic")) {
                 deviceConfig._trackingType = (
                         arglist[0] == "none" ? QVR_Device_Tracking_None
                         : arglist[0] == "static" ? QVR_Device_Tracking_Static
                         : arglist[0] == "vrpn" ? QVR_Device_Tracking_VRPN
                         : arglist[0] == "oculus" ? QVR_Device_Tracking_Oculus
                         : arglist[0] == "openvr" ? QVR_Device_Tracking_OpenVR
-                        : QVR_Device_Tracking_GoogleVR);
+                        : arglist[0] == "googlevr" ? QVR_Device_Tracking_GoogleVR
+                        : QVR_Device_Tracking_Synthetic);
                 deviceConfig._trackingParameters = QStringList(arglist.mid(1)).join(' ');
                 continue;
             } else if (cmd == "buttons" && arglist.length() >= 1
                     && (arglist[0] == "none" || arglist[0] == "static"
                         || arglist[0] == "gamepad" || arglist[0] == "vrpn"
                         || arglist[0] == "oculus" || arglist[0] == "openvr"
-                        || arglist[0] == "googlevr")) {
+                        || arglist[0] == "googlevr" || arglist[0] == "synthetic")) {
                 deviceConfig._buttonsType = (
                         arglist[0] == "none" ? QVR_Device_Buttons_None
                         : arglist[0] == "static" ? QVR_Device_Buttons_Static
@@ -337,14 +359,15 @@ bool QVRConfig::readFromFile(const QString& filename)
                         : arglist[0] == "vrpn" ? QVR_Device_Buttons_VRPN
                         : arglist[0] == "oculus" ? QVR_Device_Buttons_Oculus
                         : arglist[0] == "openvr" ? QVR_Device_Buttons_OpenVR
-                        : QVR_Device_Buttons_GoogleVR);
+                        : arglist[0] == "googlevr" ? QVR_Device_Buttons_GoogleVR
+                        : QVR_Device_Buttons_Synthetic);
                 deviceConfig._buttonsParameters = QStringList(arglist.mid(1)).join(' ');
                 continue;
             } else if (cmd == "analogs" && arglist.length() >= 1
                     && (arglist[0] == "none" || arglist[0] == "static"
                         || arglist[0] == "gamepad" || arglist[0] == "vrpn"
                         || arglist[0] == "oculus" || arglist[0] == "openvr"
-                        || arglist[0] == "googlevr")) {
+                        || arglist[0] == "googlevr" || arglist[0] == "synthetic")) {
                 deviceConfig._analogsType = (
                         arglist[0] == "none" ? QVR_Device_Analogs_None
                         : arglist[0] == "static" ? QVR_Device_Analogs_Static
@@ -352,7 +375,8 @@ bool QVRConfig::readFromFile(const QString& filename)
                         : arglist[0] == "vrpn" ? QVR_Device_Analogs_VRPN
                         : arglist[0] == "oculus" ? QVR_Device_Analogs_Oculus
                         : arglist[0] == "openvr" ? QVR_Device_Analogs_OpenVR
-                        : QVR_Device_Analogs_GoogleVR);
+                        : arglist[0] == "googlevr" ? QVR_Device_Analogs_GoogleVR
+                        : QVR_Device_Analogs_Synthetic);
                 deviceConfig._analogsParameters = QStringList(arglist.mid(1)).join(' ');
                 continue;
             }
@@ -430,6 +454,9 @@ bool QVRConfig::readFromFile(const QString& filename)
                 observerConfig._initialTrackingUpDirection.setY(arglist[1].toFloat());
                 observerConfig._initialTrackingUpDirection.setZ(arglist[2].toFloat());
                 continue;
+            } else if (cmd == "prediction" && arglist.size() == 1) {
+                observerConfig._predictionHorizon = (arg == "off" ? 0.0f : arg == "auto" ? -1.0f : arg.toFloat());
+                continue;
             }
         }
         if (processIndex >= 0) {
@@ -495,6 +522,26 @@ bool QVRConfig::readFromFile(const QString& filename)
                     processConfig._decoupledRendering = (arg == "true");
                     continue;
                 }
+                if (cmd == "late_latching" && arglist.length() == 1
+                        && (arg == "true" || arg == "false")) {
+                    processConfig._lateLatching = (arg == "true");
+                    continue;
+                }
+                if (cmd == "single_presentation_thread" && arglist.length() == 1
+                        && (arg == "true" || arg == "false")) {
+                    processConfig._singlePresentationThread = (arg == "true");
+                    continue;
+                }
+                if (cmd == "parallel_rendering" && arglist.length() == 1
+                        && (arg == "true" || arg == "false")) {
+                    processConfig._parallelRendering = (arg == "true");
+                    continue;
+                }
+                if (cmd == "display_only" && arglist.length() == 1
+                        && (arg == "true" || arg == "false")) {
+                    processConfig._displayOnly = (arg == "true");
+                    continue;
+                }
             } else {
                 // window properties:
                 if (cmd == "observer" && arglist.length() == 1) {
@@ -518,7 +565,8 @@ bool QVRConfig::readFromFile(const QString& filename)
                             || (arglist.length() == 1 && arglist[0] == "amber_blue")
                             || (arglist.length() == 1 && arglist[0] == "oculus")
                             || (arglist.length() == 1 && arglist[0] == "openvr")
-                            || (arglist.length() == 1 && arglist[0] == "googlevr"))) {
+                            || (arglist.length() == 1 && arglist[0] == "googlevr")
+                            || (arglist.length() >= 1 && arglist[0] == "offscreen"))) {
                     windowConfig._outputMode = (
                             arglist[0] == "center" ? QVR_Output_Center
                             : arglist[0] == "left" ? QVR_Output_Left
@@ -529,6 +577,7 @@ bool QVRConfig::readFromFile(const QString& filename)
                             : arglist[0] == "amber_blue" ? QVR_Output_Amber_Blue
                             : arglist[0] == "oculus" ? QVR_Output_Oculus
                             : arglist[0] == "openvr" ? QVR_Output_OpenVR
+                            : arglist[0] == "offscreen" ? QVR_Output_Offscreen
                             : QVR_Output_GoogleVR);
                     if (arglist.length() > 1)
                         windowConfig._outputPlugin = arglist.mid(1).join(' ');
@@ -585,6 +634,59 @@ bool QVRConfig::readFromFile(const QString& filename)
                     windowConfig._renderResolutionFactor = arg.toFloat();
                     continue;
                 }
+                if (cmd == "texture_buffers" && arglist.length() == 1
+                        && (arg == "1" || arg == "2" || arg == "3")) {
+                    windowConfig._textureBuffers = arg.toInt();
+                    continue;
+                }
+                if (cmd == "render_divisor" && arglist.length() == 1 && arg.toInt() >= 1) {
+                    windowConfig._renderDivisor = arg.toInt();
+                    continue;
+                }
+                if (cmd == "present_latest" && arglist.length() == 1
+                        && (arg == "true" || arg == "false")) {
+                    windowConfig._presentLatest = (arg == "true");
+                    continue;
+                }
+                if (cmd == "reprojection" && arglist.length() == 1
+                        && (arg == "none" || arg == "rotation" || arg == "depth")) {
+                    windowConfig._reprojection = (
+                            arg == "rotation" ? QVR_Reprojection_Rotation
+                            : arg == "depth" ? QVR_Reprojection_Depth
+                            : QVR_Reprojection_None);
+                    continue;
+                }
+                if (cmd == "temporal_upscaling" && arglist.length() == 1
+                        && (arg == "true" || arg == "false")) {
+                    windowConfig._temporalUpscaling = (arg == "true");
+                    continue;
+                }
+                if (cmd == "capture" && arglist.length() == 1
+                        && (arg == "none" || arg == "output" || arg == "views")) {
+                    windowConfig._captureMode = (
+                            arg == "output" ? QVR_Capture_Output
+                            : arg == "views" ? QVR_Capture_Views
+                            : QVR_Capture_None);
+                    continue;
+                }
+                if (cmd == "capture_format" && arglist.length() == 1
+                        && (arg == "png" || arg == "y4m")) {
+                    windowConfig._captureFormat = (arg == "y4m" ? QVR_Capture_Y4M : QVR_Capture_PNG);
+                    continue;
+                }
+                if (cmd == "capture_prefix" && arglist.length() == 1) {
+                    windowConfig._capturePrefix = arg;
+                    continue;
+                }
+                if (cmd == "tile_processes" && arglist.length() >= 1) {
+                    windowConfig._tileProcessIds = arglist;
+                    continue;
+                }
+                if (cmd == "tile_compositing" && arglist.length() == 1
+                        && (arg == "columns" || arg == "depth")) {
+                    windowConfig._tileCompositing = (arg == "depth" ? QVR_Tile_Depth : QVR_Tile_Columns);
+                    continue;
+                }
             }
         }
         QVR_FATAL("config file %s: invalid line %d", qPrintable(filename), lineCounter);
@@ -694,6 +796,134 @@ bool QVRConfig::readFromFile(const QString& filename)
             }
         }
     }
+    // reprojection re-presents stale frames, so it implies present_latest
+    for (int i = 0; i < _processConfigs.size(); i++) {
+        for (int j = 0; j < _processConfigs[i]._windowConfigs.size(); j++) {
+            QVRWindowConfig& windowConfig = _processConfigs[i]._windowConfigs[j];
+            if (windowConfig._reprojection == QVR_Reprojection_None)
+                continue;
+            if (!windowConfig._outputPlugin.isEmpty()
+                    || windowConfig._outputMode == QVR_Output_Oculus
+                    || windowConfig._outputMode == QVR_Output_OpenVR
+                    || windowConfig._outputMode == QVR_Output_GoogleVR
+                    || windowConfig._outputMode == QVR_Output_Offscreen) {
+                QVR_FATAL("config file %s: window %s: reprojection is not supported for this output",
+                        qPrintable(filename), qPrintable(windowConfig._id));
+                return false;
+            }
+            windowConfig._presentLatest = true;
+        }
+    }
+    // temporal upscaling needs the views and their depth in the output stage
+    for (int i = 0; i < _processConfigs.size(); i++) {
+        for (int j = 0; j < _processConfigs[i]._windowConfigs.size(); j++) {
+            const QVRWindowConfig& windowConfig = _processConfigs[i]._windowConfigs[j];
+            if (!windowConfig._temporalUpscaling)
+                continue;
+            if (!windowConfig._outputPlugin.isEmpty()
+                    || windowConfig._outputMode == QVR_Output_Oculus
+                    || windowConfig._outputMode == QVR_Output_OpenVR
+                    || windowConfig._outputMode == QVR_Output_GoogleVR
+                    || !windowConfig._tileProcessIds.isEmpty()
+                    || _processConfigs[i]._displayOnly) {
+                QVR_FATAL("config file %s: window %s: temporal upscaling is not supported for this window",
+                        qPrintable(filename), qPrintable(windowConfig._id));
+                return false;
+            }
+        }
+    }
+    // add a tile proxy window to each helper process of a tiled window
+    for (int i = 0; i < _processConfigs.size(); i++) {
+        for (int j = 0; j < _processConfigs[i]._windowConfigs.size(); j++) {
+            const QVRWindowConfig& windowConfig = _processConfigs[i]._windowConfigs[j];
+            if (windowConfig._tileProcessIds.isEmpty() || !windowConfig._tileOwnerId.isEmpty())
+                continue;
+            if (i != 0) {
+                QVR_FATAL("config file %s: window %s: only windows of the main process can be tiled",
+                        qPrintable(filename), qPrintable(windowConfig._id));
+                return false;
+            }
+            if (!windowConfig._outputPlugin.isEmpty()
+                    || windowConfig._outputMode == QVR_Output_Oculus
+                    || windowConfig._outputMode == QVR_Output_OpenVR
+                    || windowConfig._outputMode == QVR_Output_GoogleVR) {
+                QVR_FATAL("config file %s: window %s: tiling is not supported for this output",
+                        qPrintable(filename), qPrintable(windowConfig._id));
+                return false;
+            }
+            for (int t = 0; t < windowConfig._tileProcessIds.size(); t++) {
+                const QString& tileProcessId = windowConfig._tileProcessIds[t];
+                int p;
+                for (p = 1; p < _processConfigs.size(); p++) {
+                    if (_processConfigs[p]._id == tileProcessId)
+                        break;
+                }
+                if (p == _processConfigs.size() || windowConfig._tileProcessIds.indexOf(tileProcessId) != t) {
+                    QVR_FATAL("config file %s: window %s: invalid tile process %s",
+                            qPrintable(filename), qPrintable(windowConfig._id), qPrintable(tileProcessId));
+                    return false;
+                }
+                if (_processConfigs[p]._decoupledRendering || _processConfigs[p]._displayOnly) {
+                    QVR_FATAL("config file %s: window %s: tile process %s must not use decoupled rendering "
+                            "and must not be display-only",
+                            qPrintable(filename), qPrintable(windowConfig._id), qPrintable(tileProcessId));
+                    return false;
+                }
+                QVRWindowConfig proxyConfig = windowConfig;
+                proxyConfig._id = windowConfig._id + "-tile" + QString::number(t + 1);
+                proxyConfig._initialFullscreen = false;
+                proxyConfig._textureBuffers = 1;
+                proxyConfig._presentLatest = false;
+                proxyConfig._reprojection = QVR_Reprojection_None;
+                proxyConfig._temporalUpscaling = false;
+                proxyConfig._captureMode = QVR_Capture_None;
+                proxyConfig._tileProcessIds = QStringList();
+                proxyConfig._tileOwnerId = windowConfig._id;
+                proxyConfig._tileOwnerIndex = j;
+                proxyConfig._tileIndex = t + 1;
+                _processConfigs[p]._windowConfigs.append(proxyConfig);
+            }
+        }
+    }
+    // add a stream source window to the main process for each window of a display-only process
+    if (_processConfigs[0]._displayOnly) {
+        QVR_FATAL("config file %s: the main process cannot be display-only", qPrintable(filename));
+        return false;
+    }
+    for (int i = 1; i < _processConfigs.size(); i++) {
+        if (!_processConfigs[i]._displayOnly)
+            continue;
+        if (_processConfigs[i]._decoupledRendering || _processConfigs[i]._parallelRendering) {
+            QVR_FATAL("config file %s: display-only process %s must not use decoupled or parallel rendering",
+                    qPrintable(filename), qPrintable(_processConfigs[i]._id));
+            return false;
+        }
+        for (int j = 0; j < _processConfigs[i]._windowConfigs.size(); j++) {
+            const QVRWindowConfig& windowConfig = _processConfigs[i]._windowConfigs[j];
+            if (windowConfig._outputMode == QVR_Output_Oculus
+                    || windowConfig._outputMode == QVR_Output_OpenVR
+                    || windowConfig._outputMode == QVR_Output_GoogleVR) {
+                QVR_FATAL("config file %s: window %s: display-only processes do not support this output",
+                        qPrintable(filename), qPrintable(windowConfig._id));
+                return false;
+            }
+            QVRWindowConfig sourceConfig = windowConfig;
+            sourceConfig._id = windowConfig._id + "-stream";
+            sourceConfig._outputPlugin = QString();
+            sourceConfig._initialDisplayScreen = -1;
+            sourceConfig._initialFullscreen = false;
+            sourceConfig._textureBuffers = 1;
+            sourceConfig._presentLatest = false;
+            sourceConfig._reprojection = QVR_Reprojection_None;
+            sourceConfig._temporalUpscaling = false;
+            sourceConfig._captureMode = QVR_Capture_None;
+            sourceConfig._tileCompositing = QVR_Tile_Columns;
+            sourceConfig._streamTargetId = windowConfig._id;
+            sourceConfig._streamProcessIndex = i;
+            sourceConfig._streamWindowIndex = j;
+            _processConfigs[0]._windowConfigs.append(sourceConfig);
+        }
+    }
     QSet<QString> windowIds;
     for (int i = 0; i < _processConfigs.size(); i++) {
         for (int j = 0; j < _processConfigs[i].windowConfigs().size(); j++) {
@@ -25,6 +25,7 @@
 #define QVR_CONFIG_HPP
 
 #include <QString>
+#include <QStringList>
 #include <QQuaternion>
 #include <QPoint>
 #include <QSize>
@@ -49,6 +50,8 @@ typedef enum {
     QVR_Device_Tracking_OpenVR,
     /*! \brief A device with position and orientation tracked via Google VR (Cardboard, Daydream). */
     QVR_Device_Tracking_GoogleVR,
+    /*! \brief A device with a scripted position and orientation, for load testing without hardware. */
+    QVR_Device_Tracking_Synthetic
 } QVRDeviceTrackingType;
 
 /*!
@@ -68,7 +71,9 @@ typedef enum {
     /*! \brief A device with digital buttons queried via OpenVR (HTC Vive). */
     QVR_Device_Buttons_OpenVR,
     /*! \brief A device with digital buttons queried via Google VR. */
-    QVR_Device_Buttons_GoogleVR
+    QVR_Device_Buttons_GoogleVR,
+    /*! \brief A device with digital buttons that change randomly, for load testing without hardware. */
+    QVR_Device_Buttons_Synthetic
 } QVRDeviceButtonsType;
 
 /*!
@@ -88,7 +93,9 @@ typedef enum {
     /*! \brief A device with analog joystick elements queried via OpenVR (HTC Vive). */
     QVR_Device_Analogs_OpenVR,
     /*! \brief A device with analog joystick elements queried via Google VR. */
-    QVR_Device_Analogs_GoogleVR
+    QVR_Device_Analogs_GoogleVR,
+    /*! \brief A device with analog joystick elements that change continuously, for load testing without hardware. */
+    QVR_Device_Analogs_Synthetic
 } QVRDeviceAnalogsType;
 
 /*!
@@ -252,9 +259,55 @@ typedef enum {
     /*! \brief Output a stereoscopic view for the HTC Vive head-mounted display. */
     QVR_Output_OpenVR = 8,
     /*! \brief Output a stereoscopic view for Google VR devices (Cardboard, Daydream). */
-    QVR_Output_GoogleVR = 9
+    QVR_Output_GoogleVR = 9,
+    /*! \brief Output a monoscopic view for \a QVR_Eye_Center into an offscreen framebuffer, without a visible window. */
+    QVR_Output_Offscreen = 10
 } QVROutputMode;
 
+/*!
+ * \brief Capture of window contents, see \a QVRWindowConfig::captureMode().
+ */
+typedef enum {
+    /*! \brief No capture. */
+    QVR_Capture_None,
+    /*! \brief Capture the final output of the window. */
+    QVR_Capture_Output,
+    /*! \brief Capture the view textures that the application renders into. */
+    QVR_Capture_Views
+} QVRCaptureMode;
+
+/*!
+ * \brief File format of captured window contents.
+ */
+typedef enum {
+    /*! \brief A sequence of PNG images. */
+    QVR_Capture_PNG,
+    /*! \brief A raw YUV4MPEG2 video (Y'CbCr 4:4:4). */
+    QVR_Capture_Y4M
+} QVRCaptureFormat;
+
+/*!
+ * \brief Reprojection of stale frames, see \a QVRWindowConfig::reprojection().
+ */
+typedef enum {
+    /*! \brief Present stale frames as they are. */
+    QVR_Reprojection_None,
+    /*! \brief Reproject stale frames to the newest pose, assuming that the scene is far away. */
+    QVR_Reprojection_Rotation,
+    /*! \brief Reproject stale frames to the newest pose, based on the depth of the scene. */
+    QVR_Reprojection_Depth
+} QVRReprojection;
+
+/*!
+ * \brief Compositing of the tiles of a window that is rendered by several processes.
+ */
+typedef enum {
+    /*! \brief Sort-first: each process renders a column of the window, and the columns are put side by side. */
+    QVR_Tile_Columns,
+    /*! \brief Sort-last: each process renders its data partition into the whole window, and the results are depth-composited. */
+    QVR_Tile_Depth
+} QVRTileCompositing;
+
 /*!
  * \brief Types of inter-process communication that can be used if multiple processes
  * are configured.
@@ -332,6 +385,19 @@ public:
      *
      * For \a QVR_Device_Tracking_GoogleVR, the parameter string must be one of "head",
      * "eye-left", "eye-right", "daydream".
+     *
+     * For \a QVR_Device_Tracking_Synthetic, the parameter string describes a scripted
+     * motion and is one of the following:
+     * - `orbit [<radius> [<period>]]`: circle around the origin at eye height with the given
+     *   radius in meters (default 1) and period in seconds (default 10), looking along the path.
+     * - `randomwalk [<speed> [<bound>]]`: wander at eye height with the given speed in meters
+     *   per second (default 0.5), staying within the given distance from the origin (default 2).
+     * - `curve <filename>`: follow a recorded curve, looping at its end. Each line of the file
+     *   has the form `<t> <pos-x> <pos-y> <pos-z> <pitch> <yaw> <roll>` with the time in seconds;
+     *   poses are interpolated between lines.
+     *
+     * Each synthetic device starts at a different phase of its motion, derived from its index,
+     * so that many devices sharing the same parameters do not move in lockstep.
      */
     const QString& trackingParameters() const { return _trackingParameters; }
 
@@ -378,6 +444,12 @@ public:
      * when the analog value of their direction exceeds 0.5.
      *
      * For \a QVR_Device_Buttons_GoogleVR, the parameter string is either "touch" or "daydream".
+     *
+     * For \a QVR_Device_Buttons_Synthetic, the parameter string is of the form
+     * `[<rate> [<name0> [<name1> [...]]]]` where `<rate>` is the mean number of state
+     * changes per button and second (default 1) and the optional button name list defines
+     * the buttons as for VRPN. Without names, there will be 8 buttons: up, down, left, right,
+     * a, b, x, y. Button changes are pseudo-random but reproducible for a given device index.
      */
     const QString& buttonsParameters() const { return _buttonsParameters; }
 
@@ -421,6 +493,12 @@ public:
      * or "controller-1". There will be 3 analogs: axis-y, axis-x, trigger.
      *
      * For \a QVR_Device_Analogs_GoogleVR, the parameter string must currently be "daydream".
+     *
+     * For \a QVR_Device_Analogs_Synthetic, the parameter string is of the form
+     * `[<rate> [<name0> [<name1> [...]]]]` where `<rate>` is the frequency in Hz at which
+     * each analog element sweeps through its value range (default 0.5) and the optional name
+     * list defines the analog elements as for VRPN. Without names, there will be 3 analog
+     * elements: axis-y, axis-x, trigger.
      */
     const QString& analogsParameters() const { return _analogsParameters; }
 };
@@ -448,6 +526,8 @@ private:
     QVector3D _initialTrackingPosition;
     QVector3D _initialTrackingForwardDirection;
     QVector3D _initialTrackingUpDirection;
+    // Pose prediction horizon in seconds; 0 means off, negative values mean automatic
+    float _predictionHorizon;
 
     friend class QVRConfig;
 
@@ -522,6 +602,16 @@ public:
 
     /*! \brief Returns the initial tracking orientation, computed from forward and up direction. */
     QQuaternion initialTrackingOrientation() const { return QQuaternion::fromDirection(-initialTrackingForwardDirection(), initialTrackingUpDirection()); }
+
+    /*! \brief Returns the pose prediction horizon in seconds.
+     *
+     * For \a QVR_Tracking_Device, the tracking poses of the observer are extrapolated
+     * by this amount of time using the velocity and angular velocity of the tracking
+     * devices, to compensate for the latency between tracking and display.
+     * A value of zero disables prediction, and a negative value means that the horizon
+     * is estimated automatically from the measured latency between the tracking sample
+     * and the buffer swap. */
+    float predictionHorizon() const { return _predictionHorizon; }
 };
 
 /*!
@@ -567,6 +657,30 @@ private:
     QVector3D _screenCenter;
     // Factor for optional lower-resolution rendering
     float _renderResolutionFactor;
+    // Number of view texture sets (1 = present in lockstep with rendering)
+    int _textureBuffers;
+    // Render this window only every k-th frame
+    int _renderDivisor;
+    // Whether the window thread presents at its own display rate
+    bool _presentLatest;
+    // Reprojection of stale frames to the newest pose
+    QVRReprojection _reprojection;
+    // Temporal upscaling of the view textures to the output resolution
+    bool _temporalUpscaling;
+    // Capture of window contents
+    QVRCaptureMode _captureMode;
+    QVRCaptureFormat _captureFormat;
+    QString _capturePrefix;
+    // Sort-first tiling: helper processes of a tiled window, or the owner of a tile proxy window
+    QStringList _tileProcessIds;
+    QVRTileCompositing _tileCompositing;
+    QString _tileOwnerId;
+    int _tileOwnerIndex;
+    int _tileIndex;
+    // Pixel streaming: the display-only window that this stream source window renders for
+    QString _streamTargetId;
+    int _streamProcessIndex;
+    int _streamWindowIndex;
 
     friend class QVRConfig;
 
@@ -619,6 +733,133 @@ public:
      * into a 400x300 texture which is then upscaled to 800x600 for display.
      */
     float renderResolutionFactor() const { return _renderResolutionFactor; }
+    /*! \brief Returns the number of view texture sets used by this window (1 to 3).
+     *
+     * With one set, the window thread presents a frame while the application
+     * waits for it before rendering the next frame. With two or three sets, the
+     * application renders the next frame into a free set while the window thread
+     * still presents the previous one, and the window thread always presents the
+     * newest completed set. This is not supported for Oculus, OpenVR, and GoogleVR
+     * windows.
+     */
+    int textureBuffers() const { return _textureBuffers; }
+    /*! \brief Returns the render divisor.
+     *
+     * The application renders into this window only in every k-th frame,
+     * where k is the render divisor. This is useful for example for operator
+     * console windows that do not need to be updated at full rate.
+     */
+    int renderDivisor() const { return _renderDivisor; }
+    /*! \brief Returns whether this window presents the latest frame at its own display rate.
+     *
+     * In this mode, the window thread does not swap buffers in lockstep with the
+     * other windows of the process, but continuously presents the newest frame
+     * that the application completed, at the rate of its own display. This
+     * implies at least two texture buffers; see textureBuffers().
+     */
+    bool presentLatest() const { return _presentLatest; }
+    /*! \brief Returns how this window reprojects frames that it presents again.
+     *
+     * If the application takes longer than a display refresh interval to render a
+     * frame, the window thread presents the previous frame again; see presentLatest().
+     * With reprojection, it warps that frame to the observer pose at presentation
+     * time, so that head motion does not stall. For observers tracked by VRPN
+     * devices, the window thread queries this pose itself; otherwise it extrapolates
+     * the last known pose. Rotational reprojection treats the scene as if it
+     * was infinitely far away. Depth-based reprojection additionally takes parallax
+     * into account; this requires the application to render depth into
+     * \a QVRWindow::depthTexture(). Areas that were not visible in the old frame
+     * remain black.
+     *
+     * Reprojection implies presentLatest(). It is not supported for Oculus, OpenVR,
+     * GoogleVR, and offscreen windows, and for output plugins. Depth-based
+     * reprojection falls back to rotational reprojection for tiled windows,
+     * display-only windows, and layered views.
+     */
+    QVRReprojection reprojection() const { return _reprojection; }
+    /*! \brief Returns whether this window upscales its views temporally.
+     *
+     * With temporal upscaling, the application renders at the render resolution
+     * (see renderResolutionFactor()) with a frustum that is shifted by a different
+     * sub-pixel jitter in each frame (see \a QVRRenderContext::jitter()). The window
+     * accumulates the samples of successive frames at the output resolution. It
+     * reprojects the accumulated result to the current pose based on the depth that
+     * the application renders into \a QVRWindow::depthTexture(), and rejects
+     * outdated colors based on the neighborhood of each pixel in the current frame.
+     * The motion of animated objects is not taken into account beyond that.
+     *
+     * Temporal upscaling is not supported for Oculus, OpenVR, and GoogleVR windows,
+     * for output plugins, for tiled windows, and for windows of display-only processes.
+     * Layered views are not used for windows with temporal upscaling.
+     */
+    bool temporalUpscaling() const { return _temporalUpscaling; }
+    /*! \brief Returns what to capture from this window.
+     *
+     * Captured frames are read back asynchronously and written to files in
+     * captureFormat() by a separate thread. Capturing never blocks rendering or
+     * presentation; frames are dropped instead if the GPU readback or the writer
+     * falls behind, and the numbers of dropped frames are logged at exit.
+     * Capturing the output is not supported for Oculus and GoogleVR windows.
+     */
+    QVRCaptureMode captureMode() const { return _captureMode; }
+    /*! \brief Returns the file format of captured frames. */
+    QVRCaptureFormat captureFormat() const { return _captureFormat; }
+    /*! \brief Returns the prefix of the capture file names.
+     *
+     * PNG images are named \c prefix-000000.png, \c prefix-000001.png and so on, and
+     * a Y4M video is named \c prefix.y4m. When capturing views, \c -view0 or \c -view1
+     * is appended to the prefix. If the prefix is empty, \c qvr-capture-<window id> is used.
+     */
+    const QString& capturePrefix() const { return _capturePrefix; }
+    /*! \brief Returns the ids of the child processes that help to render this window.
+     *
+     * A window of the main process can be split into vertical tiles: the main
+     * process renders the leftmost tile, and each listed process renders one of
+     * the following tiles. The tiles are sent back to the main process and
+     * composited into the view textures of the window before its output stage.
+     * The tile widths are balanced continuously based on the render times of the
+     * tiles in the previous frame.
+     *
+     * For each helper process, a tile proxy window is added to its configuration;
+     * see tileOwnerId(). Helper processes must not use decoupled rendering, and
+     * tiling is only supported for output modes without HMDs and output plugins.
+     */
+    const QStringList& tileProcessIds() const { return _tileProcessIds; }
+    /*! \brief Returns how the tiles of this window are composited.
+     *
+     * With sort-first compositing (the default), the window is split into columns
+     * as described for tileProcessIds(). With sort-last compositing, each process
+     * renders the whole window, but only the part of the data set that it holds,
+     * into a color and a depth texture (see \a QVRWindow::depthTexture()). The
+     * main process then composites the results based on depth. Each process
+     * declares the bounds of its data partition via \a QVRApp::getPartitionBounds(),
+     * and only the screen area covered by these bounds is transferred.
+     * Sort-last compositing requires desktop OpenGL.
+     */
+    QVRTileCompositing tileCompositing() const { return _tileCompositing; }
+    /*! \brief Returns the id of the tiled window that this tile proxy window renders a tile of.
+     *
+     * Tile proxy windows are never shown. They only provide a window for the
+     * application to render its tile into; see tileProcessIds(). For all other
+     * windows, this is empty.
+     */
+    const QString& tileOwnerId() const { return _tileOwnerId; }
+    /*! \brief Returns the index of the tiled window in the main process, or -1 if this is not a tile proxy window. */
+    int tileOwnerIndex() const { return _tileOwnerIndex; }
+    /*! \brief Returns the index of the tile that this tile proxy window renders (0 for the tiled window itself). */
+    int tileIndex() const { return _tileIndex; }
+    /*! \brief Returns the id of the window that this stream source window renders for.
+     *
+     * The windows of a display-only process (see \a QVRProcessConfig::displayOnly())
+     * are rendered by the main process. For each of them, the main process gets a
+     * stream source window that is never shown, and whose rendered views are streamed
+     * to the display-only process. For all other windows, this is empty.
+     */
+    const QString& streamTargetId() const { return _streamTargetId; }
+    /*! \brief Returns the index of the display-only process that this stream source window renders for, or -1. */
+    int streamProcessIndex() const { return _streamProcessIndex; }
+    /*! \brief Returns the index of the window in the display-only process that this stream source window renders for, or -1. */
+    int streamWindowIndex() const { return _streamWindowIndex; }
 };
 
 /*!
@@ -650,6 +891,14 @@ private:
     bool _syncToVBlank;
     // Whether the rendering of this child process is decoupled from the main process
     bool _decoupledRendering;
+    // Whether this process re-reads tracking poses right before rendering
+    bool _lateLatching;
+    // Whether one thread presents all windows of this process with one context
+    bool _singlePresentationThread;
+    // Whether the windows of this process are rendered by parallel worker threads
+    bool _parallelRendering;
+    // Whether the windows of this child process are rendered by the main process
+    bool _displayOnly;
     // The windows driven by this process.
     QList<QVRWindowConfig> _windowConfigs;
 
@@ -698,6 +947,42 @@ public:
     bool syncToVBlank() const { return _syncToVBlank; }
     /*! \brief Returns whether the rendering of this child process is decoupled from the main process. */
     bool decoupledRendering() const { return _decoupledRendering; }
+    /*! \brief Returns whether this process re-reads the poses of the tracking devices it owns
+     * right before computing the render contexts of its windows. This reduces the latency of
+     * tracking. Only observers that no other process renders are latched, since windows of
+     * different processes would otherwise use different poses.
+     * Late latching is skipped while replaying a recording (see \a QVRManager). */
+    bool lateLatching() const { return _lateLatching; }
+    /*! \brief Returns whether this process presents its windows from a single thread.
+     *
+     * By default, each window has its own presentation thread with its own OpenGL
+     * context. With many windows on one GPU, switching between these contexts
+     * can be expensive. With a single presentation thread, one context presents
+     * all windows of this process one after the other. This applies to windows
+     * with output modes other than `stereo`, `oculus`, `openvr`, and `googlevr`;
+     * windows with these output modes keep their own threads. Only the first window
+     * on the shared thread syncs to vblank, so that the buffer swaps of the following
+     * windows do not wait for further vertical blanks. */
+    bool singlePresentationThread() const { return _singlePresentationThread; }
+    /*! \brief Returns whether this process renders its windows in parallel.
+     *
+     * If this is enabled, each window of this process gets a render worker thread
+     * with its own OpenGL context that shares objects with the main context, and
+     * \a QVRApp::render() is called concurrently for different windows. See
+     * \a QVRApp::render() for the resulting requirements on the application, which
+     * must declare that it meets them via \a QVRApp::supportsParallelRendering(). */
+    bool parallelRendering() const { return _parallelRendering; }
+    /*! \brief Returns whether this child process only displays windows that the main process renders.
+     *
+     * This is useful for display computers with weak GPUs. The main process renders
+     * the views of all windows of a display-only process (see \a QVRWindowConfig::streamTargetId())
+     * and streams the resulting images to it, via shared memory for local processes and
+     * compressed via TCP for remote processes. Each image is tagged with its frame number,
+     * and the display-only process only presents images of the current frame.
+     * \a QVRApp::render() is never called for windows of a display-only process.
+     * Display-only processes must not use decoupled or parallel rendering, and their
+     * windows must not use the output modes `oculus`, `openvr`, and `googlevr`. */
+    bool displayOnly() const { return _displayOnly; }
     /*! \brief Returns the configurations of the windows on this process. */
     const QList<QVRWindowConfig>& windowConfigs() const { return _windowConfigs; }
 };
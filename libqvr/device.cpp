@@ -23,7 +23,11 @@
  */
 
 #include <cstring>
+#include <cmath>
 #include <QtMath>
+#include <QFile>
+#include <QTextStream>
+#include <QRandomGenerator>
 
 #include "manager.hpp"
 #include "device.hpp"
@@ -53,6 +57,17 @@ struct QVRDeviceInternals {
     qint64 lastTimestamp;
     QVector3D lastPosition;
     QQuaternion lastOrientation;
+    // Synthetic devices for load testing.
+    int syntheticMotion; // -1 = none, 0 = orbit, 1 = random walk, 2 = curve
+    float syntheticParameters[2]; // orbit: radius, period; random walk: speed, bound
+    float syntheticPhase; // in [0,1), derived from the device index
+    float syntheticHeading; // random walk: current heading in radians
+    QVector<float> syntheticCurve; // curve: 7 floats per key (t, pos-x, pos-y, pos-z, pitch, yaw, roll)
+    float syntheticButtonRate; // mean state changes per button and second
+    float syntheticAnalogRate; // sweeps per analog element and second
+    quint32 syntheticAnalogsUnipolar; // bit i set = analog i has values in [0,1] instead of [-1,1]
+    qint64 syntheticTimestamp; // time of last synthetic update, or -1
+    QRandomGenerator syntheticRandom;
 #ifdef HAVE_QGAMEPAD
     QGamepad* buttonsGamepad; // these pointers might actually...
     QGamepad* analogsGamepad; // ...point to the same gamepad object!
@@ -63,8 +78,10 @@ struct QVRDeviceInternals {
     QVector3D* vrpnVelocityPtr; // pointer to _velocity
     QVector3D* vrpnAngularVelocityPtr; // pointer to _angularVelocity;
     bool vrpnHaveVelocity;
-    QVector<bool>* vrpnButtonsPtr; // pointer to _buttons
-    QVector<float>* vrpnAnalogsPtr; // pointer to _analogs
+    bool* vrpnButtonsPtr; // pointer to _buttons
+    int* vrpnButtonCountPtr; // pointer to _buttonCount
+    float* vrpnAnalogsPtr; // pointer to _analogs
+    int* vrpnAnalogCountPtr; // pointer to _analogCount
     vrpn_Tracker_Remote* vrpnTrackerRemote;
     vrpn_Button_Remote* vrpnButtonRemote;
     vrpn_Analog_Remote* vrpnAnalogRemote;
@@ -84,6 +101,32 @@ struct QVRDeviceInternals {
 #endif
 };
 
+static bool QVRSyntheticCurveFromFile(const QString& filename, QVector<float>& curve)
+{
+    QFile f(filename);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QTextStream in(&f);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        QStringList values = line.split(' ', Qt::SkipEmptyParts);
+        if (values.length() != 7)
+            return false;
+        for (int i = 0; i < 7; i++) {
+            bool ok;
+            float v = values[i].toFloat(&ok);
+            if (!ok)
+                return false;
+            curve.append(v);
+        }
+        if (curve.size() > 7 && curve[curve.size() - 7] <= curve[curve.size() - 14])
+            return false; // time must be strictly increasing
+    }
+    return (curve.size() >= 2 * 7);
+}
+
 static QVector3D QVRAngularVelocityFromDiffQuaternion(const QQuaternion& q, double seconds)
 {
     QVector3D axis;
@@ -111,15 +154,15 @@ void QVRVrpnTrackerVelocityChangeHandler(void* userdata, const vrpn_TRACKERVELCB
 void QVRVrpnButtonChangeHandler(void* userdata, const vrpn_BUTTONCB info)
 {
     struct QVRDeviceInternals* d = reinterpret_cast<struct QVRDeviceInternals*>(userdata);
-    if (info.button >= 0 && info.button < d->vrpnButtonsPtr->size())
-        (*(d->vrpnButtonsPtr))[info.button] = info.state;
+    if (info.button >= 0 && info.button < *(d->vrpnButtonCountPtr))
+        d->vrpnButtonsPtr[info.button] = info.state;
 }
 void QVRVrpnAnalogChangeHandler(void* userdata, const vrpn_ANALOGCB info)
 {
     struct QVRDeviceInternals* d = reinterpret_cast<struct QVRDeviceInternals*>(userdata);
-    for (int i = 0; i < d->vrpnAnalogsPtr->size(); i++) {
+    for (int i = 0; i < *(d->vrpnAnalogCountPtr); i++) {
         if (i < info.num_channel)
-            (*(d->vrpnAnalogsPtr))[i] = info.channel[i];
+            d->vrpnAnalogsPtr[i] = info.channel[i];
     }
 }
 #endif
@@ -209,23 +252,46 @@ static const int QVRDeviceMaxAnalogs = QVR_Analog_Unknown;
 
 QVRDevice::QVRDevice() :
     _index(-1),
+    _buttonCount(0),
+    _analogCount(0),
     _internals(NULL)
 {
-    for (int i = 0; i < QVRDeviceMaxButtons; i++)
+    for (int i = 0; i < QVRDeviceMaxButtons; i++) {
         _buttonsMap[i] = -1;
-    for (int i = 0; i < QVRDeviceMaxAnalogs; i++)
+        _buttons[i] = false;
+    }
+    for (int i = 0; i < QVRDeviceMaxAnalogs; i++) {
         _analogsMap[i] = -1;
+        _analogs[i] = 0.0f;
+    }
 }
 
 QVRDevice::QVRDevice(int deviceIndex) :
-    _index(deviceIndex)
+    _index(deviceIndex),
+    _buttonCount(0),
+    _analogCount(0)
 {
-    for (int i = 0; i < QVRDeviceMaxButtons; i++)
+    for (int i = 0; i < QVRDeviceMaxButtons; i++) {
         _buttonsMap[i] = -1;
-    for (int i = 0; i < QVRDeviceMaxAnalogs; i++)
+        _buttons[i] = false;
+    }
+    for (int i = 0; i < QVRDeviceMaxAnalogs; i++) {
         _analogsMap[i] = -1;
+        _analogs[i] = 0.0f;
+    }
     _internals = new struct QVRDeviceInternals;
     _internals->currentTimestamp = -1;
+    _internals->syntheticMotion = -1;
+    _internals->syntheticParameters[0] = 0.0f;
+    _internals->syntheticParameters[1] = 0.0f;
+    // golden ratio sequence: spreads the phases of many devices evenly
+    _internals->syntheticPhase = std::fmod(deviceIndex * 0.618034f, 1.0f);
+    _internals->syntheticHeading = _internals->syntheticPhase * 2.0f * float(M_PI);
+    _internals->syntheticButtonRate = 0.0f;
+    _internals->syntheticAnalogRate = 0.0f;
+    _internals->syntheticAnalogsUnipolar = 0;
+    _internals->syntheticTimestamp = -1;
+    _internals->syntheticRandom.seed(deviceIndex + 1);
 #ifdef HAVE_QGAMEPAD
     _internals->buttonsGamepad = NULL;
     _internals->analogsGamepad = NULL;
@@ -236,8 +302,10 @@ QVRDevice::QVRDevice(int deviceIndex) :
     _internals->vrpnVelocityPtr = &_velocity;
     _internals->vrpnAngularVelocityPtr = &_angularVelocity;
     _internals->vrpnHaveVelocity = false;
-    _internals->vrpnButtonsPtr = &_buttons;
-    _internals->vrpnAnalogsPtr = &_analogs;
+    _internals->vrpnButtonsPtr = _buttons;
+    _internals->vrpnButtonCountPtr = &_buttonCount;
+    _internals->vrpnAnalogsPtr = _analogs;
+    _internals->vrpnAnalogCountPtr = &_analogCount;
     _internals->vrpnTrackerRemote = NULL;
     _internals->vrpnAnalogRemote = NULL;
     _internals->vrpnButtonRemote = NULL;
@@ -336,6 +404,31 @@ QVRDevice::QVRDevice(int deviceIndex) :
         }
 #endif
         break;
+    case QVR_Device_Tracking_Synthetic:
+        if (QVRManager::processIndex() == config().processIndex()) {
+            QStringList args = config().trackingParameters().split(' ', Qt::SkipEmptyParts);
+            QString motion = (args.length() >= 1 ? args[0] : QString("orbit"));
+            if (motion == "orbit" && args.length() <= 3) {
+                _internals->syntheticMotion = 0;
+                _internals->syntheticParameters[0] = (args.length() >= 2 ? args[1].toFloat() : 1.0f);
+                _internals->syntheticParameters[1] = (args.length() >= 3 ? args[2].toFloat() : 10.0f);
+                if (_internals->syntheticParameters[1] <= 0.0f)
+                    _internals->syntheticParameters[1] = 10.0f;
+            } else if (motion == "randomwalk" && args.length() <= 3) {
+                _internals->syntheticMotion = 1;
+                _internals->syntheticParameters[0] = (args.length() >= 2 ? args[1].toFloat() : 0.5f);
+                _internals->syntheticParameters[1] = (args.length() >= 3 ? args[2].toFloat() : 2.0f);
+                _position = QVector3D(0.0f, QVRObserverConfig::defaultEyeHeight, 0.0f);
+            } else if (motion == "curve" && args.length() == 2) {
+                if (QVRSyntheticCurveFromFile(args[1], _internals->syntheticCurve))
+                    _internals->syntheticMotion = 2;
+                else
+                    QVR_WARNING("device %s: cannot read synthetic tracking curve %s", qPrintable(id()), qPrintable(args[1]));
+            } else {
+                QVR_WARNING("device %s: invalid synthetic tracking parameter", qPrintable(id()));
+            }
+        }
+        break;
     }
 
     switch (config().buttonsType()) {
@@ -345,8 +438,8 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QStringList args = config().buttonsParameters().split(' ', Qt::SkipEmptyParts);
             int n = qMin(QVRDeviceMaxButtons, args.length() / 2);
-            _buttons.resize(n);
-            for (int i = 0; i < _buttons.length(); i++) {
+            _buttonCount = n;
+            for (int i = 0; i < _buttonCount; i++) {
                 QString name = args[2 * i + 0];
                 QVRButton btn;
                 if (QVRButtonFromName(name, &btn))
@@ -369,7 +462,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     QVR_DEBUG("device %s uses gamepad %d for buttons", qPrintable(id()), padId);
                 }
             }
-            _buttons.resize(18);
+            _buttonCount = 18;
             _buttonsMap[QVR_Button_L1] = 0;
             _buttonsMap[QVR_Button_L2] = 1;
             _buttonsMap[QVR_Button_L3] = 2;
@@ -397,13 +490,13 @@ QVRDevice::QVRDevice(int deviceIndex) :
             QStringList args = config().buttonsParameters().split(' ', Qt::SkipEmptyParts);
             QString name = (args.length() >= 1 ? args[0] : config().buttonsParameters());
             if (args.length() > 1) {
-                _buttons.resize(qMin(QVRDeviceMaxButtons, args.length() - 1));
+                _buttonCount = qMin(QVRDeviceMaxButtons, args.length() - 1);
                 QVRButton btn;
-                for (int i = 0; i < _buttons.length(); i++)
+                for (int i = 0; i < _buttonCount; i++)
                     if (QVRButtonFromName(args[i + 1], &btn))
                         _buttonsMap[btn] = i;
             } else {
-                _buttons.resize(QVRDeviceMaxButtons);
+                _buttonCount = QVRDeviceMaxButtons;
             }
             if (QVRManager::processIndex() == config().processIndex()) {
                 _internals->vrpnButtonRemote = new vrpn_Button_Remote(qPrintable(name));
@@ -418,7 +511,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QString arg = config().buttonsParameters().trimmed();
             if (arg == "xbox") {
-                _buttons.resize(12);
+                _buttonCount = 12;
                 _buttonsMap[QVR_Button_Up] = 0;
                 _buttonsMap[QVR_Button_Down] = 1;
                 _buttonsMap[QVR_Button_Left] = 2;
@@ -436,7 +529,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     _internals->oculusButtonsEntity = 0;
                 }
             } else if (arg == "controller-left") {
-                _buttons.resize(8);
+                _buttonCount = 8;
                 _buttonsMap[QVR_Button_Up] = 0;
                 _buttonsMap[QVR_Button_Down] = 1;
                 _buttonsMap[QVR_Button_Left] = 2;
@@ -450,7 +543,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     _internals->oculusButtonsEntity = 1;
                 }
             } else if (arg == "controller-right") {
-                _buttons.resize(8);
+                _buttonCount = 8;
                 _buttonsMap[QVR_Button_Up] = 0;
                 _buttonsMap[QVR_Button_Down] = 1;
                 _buttonsMap[QVR_Button_Left] = 2;
@@ -474,7 +567,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QString arg = config().buttonsParameters().trimmed();
             if (arg == "controller-0") {
-                _buttons.resize(6);
+                _buttonCount = 6;
                 _buttonsMap[QVR_Button_Up] = 0;
                 _buttonsMap[QVR_Button_Down] = 1;
                 _buttonsMap[QVR_Button_Left] = 2;
@@ -486,7 +579,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     _internals->openVrButtonsEntity = 0;
                 }
             } else if (arg == "controller-1") {
-                _buttons.resize(6);
+                _buttonCount = 6;
                 _buttonsMap[QVR_Button_Up] = 0;
                 _buttonsMap[QVR_Button_Down] = 1;
                 _buttonsMap[QVR_Button_Left] = 2;
@@ -508,10 +601,10 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QString arg = config().buttonsParameters().trimmed();
             if (arg == "touch") {
-                _buttons.resize(1);
+                _buttonCount = 1;
                 _buttonsMap[QVR_Button_Trigger] = 0;
             } else if (arg == "daydream") {
-                _buttons.resize(3);
+                _buttonCount = 3;
                 _buttonsMap[QVR_Button_Trigger] = 0;
                 _buttonsMap[QVR_Button_Menu] = 1;
                 _buttonsMap[QVR_Button_Select] = 2;
@@ -521,6 +614,20 @@ QVRDevice::QVRDevice(int deviceIndex) :
         }
 #endif
         break;
+    case QVR_Device_Buttons_Synthetic:
+        {
+            QStringList args = config().buttonsParameters().split(' ', Qt::SkipEmptyParts);
+            _internals->syntheticButtonRate = (args.length() >= 1 ? args[0].toFloat() : 1.0f);
+            QStringList names = args.mid(1);
+            if (names.isEmpty())
+                names << "up" << "down" << "left" << "right" << "a" << "b" << "x" << "y";
+            _buttonCount = qMin(QVRDeviceMaxButtons, int(names.length()));
+            QVRButton btn;
+            for (int i = 0; i < _buttonCount; i++)
+                if (QVRButtonFromName(names[i], &btn))
+                    _buttonsMap[btn] = i;
+        }
+        break;
     }
 
     switch (config().analogsType()) {
@@ -529,10 +636,8 @@ QVRDevice::QVRDevice(int deviceIndex) :
     case QVR_Device_Analogs_Static:
         {
             QStringList args = config().analogsParameters().split(' ', Qt::SkipEmptyParts);
-            _analogs.resize(args.length());
-            int n = qMin(QVRDeviceMaxAnalogs, args.length() / 2);
-            _buttons.resize(n);
-            for (int i = 0; i < _analogs.length(); i++) {
+            _analogCount = qMin(QVRDeviceMaxAnalogs, args.length() / 2);
+            for (int i = 0; i < _analogCount; i++) {
                 QString name = args[2 * i + 0];
                 QVRAnalog anlg;
                 if (QVRAnalogFromName(name, &anlg))
@@ -558,7 +663,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     QVR_DEBUG("device %s uses gamepad %d for analogs", qPrintable(id()), padId);
                 }
             }
-            _analogs.resize(6);
+            _analogCount = 6;
             _analogsMap[QVR_Analog_Right_Axis_Y] = 0;
             _analogsMap[QVR_Analog_Right_Axis_X] = 1;
             _analogsMap[QVR_Analog_Left_Axis_Y] = 2;
@@ -574,13 +679,13 @@ QVRDevice::QVRDevice(int deviceIndex) :
             QStringList args = config().analogsParameters().split(' ', Qt::SkipEmptyParts);
             QString name = (args.length() >= 1 ? args[0] : config().analogsParameters());
             if (args.length() > 1) {
-                _analogs.resize(qMin(QVRDeviceMaxAnalogs, args.length() - 1));
+                _analogCount = qMin(QVRDeviceMaxAnalogs, args.length() - 1);
                 QVRAnalog anlg;
-                for (int i = 0; i < _analogs.length(); i++)
+                for (int i = 0; i < _analogCount; i++)
                     if (QVRAnalogFromName(args[i + 1], &anlg))
                         _analogsMap[anlg] = i;
             } else {
-                _analogs.resize(QVRDeviceMaxAnalogs);
+                _analogCount = QVRDeviceMaxAnalogs;
             }
             if (QVRManager::processIndex() == config().processIndex()) {
                 _internals->vrpnAnalogRemote = new vrpn_Analog_Remote(qPrintable(name));
@@ -595,7 +700,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QString arg = config().analogsParameters().trimmed();
             if (arg == "xbox") {
-                _analogs.resize(8);
+                _analogCount = 8;
                 _analogsMap[QVR_Analog_Left_Axis_Y] = 0;
                 _analogsMap[QVR_Analog_Left_Axis_X] = 1;
                 _analogsMap[QVR_Analog_Right_Axis_Y] = 2;
@@ -609,7 +714,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     _internals->oculusAnalogsEntity = 0;
                 }
             } else if (arg == "controller-left") {
-                _analogs.resize(4);
+                _analogCount = 4;
                 _analogsMap[QVR_Analog_Axis_Y] = 0;
                 _analogsMap[QVR_Analog_Axis_X] = 1;
                 _analogsMap[QVR_Analog_Trigger] = 2;
@@ -619,7 +724,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     _internals->oculusAnalogsEntity = 1;
                 }
             } else if (arg == "controller-right") {
-                _analogs.resize(4);
+                _analogCount = 4;
                 _analogsMap[QVR_Analog_Axis_Y] = 0;
                 _analogsMap[QVR_Analog_Axis_X] = 1;
                 _analogsMap[QVR_Analog_Trigger] = 2;
@@ -639,7 +744,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QString arg = config().analogsParameters().trimmed();
             if (arg == "controller-0") {
-                _analogs.resize(3);
+                _analogCount = 3;
                 _analogsMap[QVR_Analog_Axis_Y] = 0;
                 _analogsMap[QVR_Analog_Axis_X] = 1;
                 _analogsMap[QVR_Analog_Trigger] = 2;
@@ -648,7 +753,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
                     _internals->openVrAnalogsEntity = 0;
                 }
             } else if (arg == "controller-1") {
-                _analogs.resize(3);
+                _analogCount = 3;
                 _analogsMap[QVR_Analog_Axis_Y] = 0;
                 _analogsMap[QVR_Analog_Axis_X] = 1;
                 _analogsMap[QVR_Analog_Trigger] = 2;
@@ -667,7 +772,7 @@ QVRDevice::QVRDevice(int deviceIndex) :
         {
             QString arg = config().buttonsParameters().trimmed();
             if (arg == "daydream") {
-                _analogs.resize(2);
+                _analogCount = 2;
                 _analogsMap[QVR_Analog_Axis_Y] = 0;
                 _analogsMap[QVR_Analog_Axis_X] = 1;
             } else {
@@ -676,6 +781,26 @@ QVRDevice::QVRDevice(int deviceIndex) :
         }
 #endif
         break;
+    case QVR_Device_Analogs_Synthetic:
+        {
+            QStringList args = config().analogsParameters().split(' ', Qt::SkipEmptyParts);
+            _internals->syntheticAnalogRate = (args.length() >= 1 ? args[0].toFloat() : 0.5f);
+            QStringList names = args.mid(1);
+            if (names.isEmpty())
+                names << "axis-y" << "axis-x" << "trigger";
+            _analogCount = qMin(QVRDeviceMaxAnalogs, int(names.length()));
+            QVRAnalog anlg;
+            for (int i = 0; i < _analogCount; i++) {
+                if (QVRAnalogFromName(names[i], &anlg)) {
+                    _analogsMap[anlg] = i;
+                    if (anlg == QVR_Analog_Trigger || anlg == QVR_Analog_Left_Trigger
+                            || anlg == QVR_Analog_Right_Trigger || anlg == QVR_Analog_Grip
+                            || anlg == QVR_Analog_Left_Grip || anlg == QVR_Analog_Right_Grip)
+                        _internals->syntheticAnalogsUnipolar |= (1u << i);
+                }
+            }
+        }
+        break;
     }
 }
 
@@ -684,10 +809,14 @@ QVRDevice::QVRDevice(const QVRDevice& d) : _internals(NULL)
     _index = d._index;
     _position = d._position;
     _orientation = d._orientation;
+    _velocity = d._velocity;
+    _angularVelocity = d._angularVelocity;
     std::memcpy(_buttonsMap, d._buttonsMap, sizeof(_buttonsMap));
-    _buttons = d._buttons;
+    _buttonCount = d._buttonCount;
+    std::memcpy(_buttons, d._buttons, sizeof(_buttons));
     std::memcpy(_analogsMap, d._analogsMap, sizeof(_analogsMap));
-    _analogs = d._analogs;
+    _analogCount = d._analogCount;
+    std::memcpy(_analogs, d._analogs, sizeof(_analogs));
 }
 
 QVRDevice::~QVRDevice()
@@ -715,10 +844,14 @@ const QVRDevice& QVRDevice::operator=(const QVRDevice& d)
     _index = d._index;
     _position = d._position;
     _orientation = d._orientation;
+    _velocity = d._velocity;
+    _angularVelocity = d._angularVelocity;
     std::memcpy(_buttonsMap, d._buttonsMap, sizeof(_buttonsMap));
-    _buttons = d._buttons;
+    _buttonCount = d._buttonCount;
+    std::memcpy(_buttons, d._buttons, sizeof(_buttons));
     std::memcpy(_analogsMap, d._analogsMap, sizeof(_analogsMap));
-    _analogs = d._analogs;
+    _analogCount = d._analogCount;
+    std::memcpy(_analogs, d._analogs, sizeof(_analogs));
     return *this;
 }
 
@@ -1034,7 +1167,7 @@ void QVRDevice::update()
             _position = QVRGoogleVRPositions[_internals->googleVrTrackedEntity];
         }
         if (config().buttonsType() == QVR_Device_Buttons_GoogleVR) {
-            if (_buttons.size() == 1) {
+            if (_buttonCount == 1) {
                 // Consume a touch event generated on the Android thread.
                 // We set the button status to "pressed" until the next call of this function (typically 1 frame).
                 _buttons[0] = QVRGoogleVRTouchEvent.testAndSetRelaxed(1, 0);
@@ -1049,6 +1182,71 @@ void QVRDevice::update()
             _analogs[1] = QVRGoogleVRAxes[1];
         }
 #endif
+        if (_internals->syntheticMotion >= 0
+                || config().buttonsType() == QVR_Device_Buttons_Synthetic
+                || config().analogsType() == QVR_Device_Analogs_Synthetic) {
+            qint64 now = QVRTimer.nsecsElapsed();
+            double t = now / 1e9;
+            // limit the time step so that stalls (e.g. at startup) do not cause jumps
+            float dt = (_internals->syntheticTimestamp < 0 ? 0.0f
+                    : qMin(0.1f, float((now - _internals->syntheticTimestamp) / 1e9)));
+            _internals->syntheticTimestamp = now;
+            if (_internals->syntheticMotion == 0) {
+                float radius = _internals->syntheticParameters[0];
+                float period = _internals->syntheticParameters[1];
+                float angle = 2.0f * float(M_PI) * float(std::fmod(t / period + _internals->syntheticPhase, 1.0));
+                _position = QVector3D(radius * std::cos(angle), QVRObserverConfig::defaultEyeHeight, radius * std::sin(angle));
+                // look along the path, i.e. rotate -z into (-sin(angle), 0, cos(angle))
+                _orientation = QQuaternion::fromEulerAngles(0.0f, qRadiansToDegrees(float(M_PI) - angle), 0.0f);
+            } else if (_internals->syntheticMotion == 1) {
+                float speed = _internals->syntheticParameters[0];
+                float bound = _internals->syntheticParameters[1];
+                float heading = _internals->syntheticHeading;
+                float x = _position.x();
+                float z = _position.z();
+                if (x * x + z * z > bound * bound)
+                    heading = std::atan2(x, z); // turn back towards the origin
+                else
+                    heading += (_internals->syntheticRandom.generateDouble() * 2.0 - 1.0) * 4.0 * dt;
+                _position += speed * dt * QVector3D(-std::sin(heading), 0.0f, -std::cos(heading));
+                _orientation = QQuaternion::fromEulerAngles(0.0f, qRadiansToDegrees(heading), 0.0f);
+                _internals->syntheticHeading = heading;
+            } else if (_internals->syntheticMotion == 2) {
+                const float* c = _internals->syntheticCurve.constData();
+                int n = _internals->syntheticCurve.size() / 7;
+                float t0 = c[0];
+                float duration = c[7 * (n - 1)] - t0;
+                float ct = t0 + duration * float(std::fmod(t / duration + _internals->syntheticPhase, 1.0));
+                int lo = 0, hi = n - 1;
+                while (hi - lo > 1) {
+                    int mid = (lo + hi) / 2;
+                    if (c[7 * mid] <= ct)
+                        lo = mid;
+                    else
+                        hi = mid;
+                }
+                const float* a = c + 7 * lo;
+                const float* b = c + 7 * hi;
+                float alpha = qBound(0.0f, (ct - a[0]) / (b[0] - a[0]), 1.0f);
+                _position = (1.0f - alpha) * QVector3D(a[1], a[2], a[3]) + alpha * QVector3D(b[1], b[2], b[3]);
+                _orientation = QQuaternion::slerp(
+                        QQuaternion::fromEulerAngles(a[4], a[5], a[6]),
+                        QQuaternion::fromEulerAngles(b[4], b[5], b[6]), alpha);
+            }
+            if (config().buttonsType() == QVR_Device_Buttons_Synthetic) {
+                double p = 1.0 - std::exp(-_internals->syntheticButtonRate * dt);
+                for (int i = 0; i < _buttonCount; i++)
+                    if (_internals->syntheticRandom.generateDouble() < p)
+                        _buttons[i] = !_buttons[i];
+            }
+            if (config().analogsType() == QVR_Device_Analogs_Synthetic) {
+                for (int i = 0; i < _analogCount; i++) {
+                    double phase = _internals->syntheticPhase + 0.25 * i;
+                    float v = std::sin(2.0 * M_PI * (_internals->syntheticAnalogRate * t + phase));
+                    _analogs[i] = (_internals->syntheticAnalogsUnipolar & (1u << i)) ? 0.5f * (v + 1.0f) : v;
+                }
+            }
+        }
         if (wantVelocityCalculation && _internals->lastTimestamp >= 0) {
             qint64 usecs = (_internals->currentTimestamp - _internals->lastTimestamp) / 1000;
             double secs = usecs / 1e6;
@@ -1059,9 +1257,33 @@ void QVRDevice::update()
     }
 }
 
+void QVRDevice::latchPose()
+{
+    // Late latching: only fetch the newest tracker pose. Buttons, analogs and
+    // the velocity history stay as they were set by update() for this frame.
+#ifdef HAVE_VRPN
+    if (config().processIndex() == QVRManager::processIndex() && _internals->vrpnTrackerRemote) {
+        QVector3D position = _position;
+        QQuaternion orientation = _orientation;
+        _internals->vrpnTrackerRemote->mainloop();
+        if (_position != position || _orientation != orientation) {
+            // The next update() measures the velocity from this sample on,
+            // so it must carry the time at which it was received.
+            _internals->currentTimestamp = QVRTimer.nsecsElapsed();
+        }
+    }
+#endif
+}
+
 QDataStream &operator<<(QDataStream& ds, const QVRDevice& d)
 {
-    ds << d._index << d._position << d._orientation << d._velocity << d._angularVelocity << d._buttons << d._analogs;
+    ds << d._index << d._position << d._orientation << d._velocity << d._angularVelocity;
+    ds << d._buttonCount;
+    for (int i = 0; i < d._buttonCount; i++)
+        ds << d._buttons[i];
+    ds << d._analogCount;
+    for (int i = 0; i < d._analogCount; i++)
+        ds << d._analogs[i];
     ds.writeRawData(reinterpret_cast<const char*>(d._buttonsMap), sizeof(d._buttonsMap));
     ds.writeRawData(reinterpret_cast<const char*>(d._analogsMap), sizeof(d._analogsMap));
     return ds;
@@ -1069,7 +1291,15 @@ QDataStream &operator<<(QDataStream& ds, const QVRDevice& d)
 
 QDataStream &operator>>(QDataStream& ds, QVRDevice& d)
 {
-    ds >> d._index >> d._position >> d._orientation >> d._velocity >> d._angularVelocity >> d._buttons >> d._analogs;
+    ds >> d._index >> d._position >> d._orientation >> d._velocity >> d._angularVelocity;
+    ds >> d._buttonCount;
+    d._buttonCount = qBound(0, d._buttonCount, static_cast<int>(QVRDeviceMaxButtons));
+    for (int i = 0; i < d._buttonCount; i++)
+        ds >> d._buttons[i];
+    ds >> d._analogCount;
+    d._analogCount = qBound(0, d._analogCount, static_cast<int>(QVRDeviceMaxAnalogs));
+    for (int i = 0; i < d._analogCount; i++)
+        ds >> d._analogs[i];
     ds.readRawData(reinterpret_cast<char*>(d._buttonsMap), sizeof(d._buttonsMap));
     ds.readRawData(reinterpret_cast<char*>(d._analogsMap), sizeof(d._analogsMap));
     return ds;
@@ -57,10 +57,14 @@ private:
     QQuaternion _orientation;
     QVector3D _velocity;
     QVector3D _angularVelocity;
+    // Buttons and analogs use fixed-size inline storage so that copying
+    // a device (e.g. for device events) never allocates memory.
     signed char _buttonsMap[QVR_Button_Unknown];
-    QVector<bool> _buttons;
+    int _buttonCount;
+    bool _buttons[QVR_Button_Unknown];
     signed char _analogsMap[QVR_Analog_Unknown];
-    QVector<float> _analogs;
+    int _analogCount;
+    float _analogs[QVR_Analog_Unknown];
 
     QVRDeviceInternals* _internals;
 
@@ -69,6 +73,7 @@ private:
 
     friend class QVRManager;
     void update();
+    void latchPose();
 
 public:
     /**
@@ -154,7 +159,7 @@ public:
     /*! \brief Returns the number of buttons on this device. */
     int buttonCount() const
     {
-        return _buttons.length();
+        return _buttonCount;
     }
 
     /*! \brief Returns the type of the button with \a index. */
@@ -201,7 +206,7 @@ public:
      * joysticks. */
     int analogCount() const
     {
-        return _analogs.length();
+        return _analogCount;
     }
 
     /*! \brief Returns the type of the analog element with \a index. */
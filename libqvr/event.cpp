@@ -25,11 +25,96 @@
 #include <QDataStream>
 
 #include "event.hpp"
+#include "internalglobals.hpp"
+
+
+int QVREventContextTable::find(int processIndex, int windowIndex, unsigned int frame) const
+{
+    // There are only a few entries per frame, so a linear search is fine
+    for (int i = 0; i < _entries.size(); i++) {
+        const Entry& e = _entries[i];
+        if (e.processIndex == processIndex && e.windowIndex == windowIndex && e.frame == frame)
+            return i;
+    }
+    return -1;
+}
+
+QVREventContextTable::Entry& QVREventContextTable::insert(int processIndex, int windowIndex, unsigned int frame)
+{
+    int i = find(processIndex, windowIndex, frame);
+    if (i >= 0)
+        return _entries[i];
+    _entries.append(Entry());
+    Entry& e = _entries.last();
+    e.processIndex = processIndex;
+    e.windowIndex = windowIndex;
+    e.frame = frame;
+    return e;
+}
+
+void QVREventContextTable::set(unsigned int frame, const QVRRenderContext& context)
+{
+    Entry& e = insert(context.processIndex(), context.windowIndex(), frame);
+    if (!e.isDeserialized) {
+        e.isDeserialized = true;
+        e.context = context;
+        e.serializedContext.clear();
+    }
+}
+
+void QVREventContextTable::setSerialized(int processIndex, int windowIndex, unsigned int frame, const QByteArray& serializedContext)
+{
+    Entry& e = insert(processIndex, windowIndex, frame);
+    e.isDeserialized = false;
+    e.serializedContext = serializedContext;
+}
+
+const QVRRenderContext& QVREventContextTable::get(int processIndex, int windowIndex, unsigned int frame)
+{
+    // Every queued event has its context in the table. Appending here could
+    // move the entries and invalidate contexts that were returned before.
+    int i = find(processIndex, windowIndex, frame);
+    Q_ASSERT(i >= 0);
+    if (i < 0) {
+        static const QVRRenderContext emptyContext;
+        return emptyContext;
+    }
+    Entry& e = _entries[i];
+    if (!e.isDeserialized) {
+        QDataStream ds(e.serializedContext);
+        ds >> e.context;
+        e.isDeserialized = true;
+    }
+    return e.context;
+}
+
+const QByteArray& QVREventContextTable::getSerialized(int processIndex, int windowIndex, unsigned int frame)
+{
+    int i = find(processIndex, windowIndex, frame);
+    Q_ASSERT(i >= 0);
+    if (i < 0) {
+        static const QByteArray emptySerializedContext;
+        return emptySerializedContext;
+    }
+    Entry& e = _entries[i];
+    if (e.serializedContext.isEmpty()) {
+        QDataStream ds(&e.serializedContext, QIODevice::WriteOnly);
+        ds << e.context;
+    }
+    return e.serializedContext;
+}
+
+void QVREventContextTable::clear()
+{
+    _entries.clear();
+}
 
 
 QVREvent::QVREvent() :
     type(QVR_Event_KeyPress),
-    context(),
+    processIndex(-1),
+    windowIndex(-1),
+    frame(0),
     deviceEvent(QVRDevice(), -1, -1),
     keyEventType(QEvent::None),
     keyEventKey(0),
@@ -44,13 +129,17 @@ QVREvent::QVREvent() :
 
 QVREvent::QVREvent(QVREventType t, const QVRDeviceEvent& e) :
     type(t),
-    context(),
+    processIndex(-1),
+    windowIndex(-1),
+    frame(QVRFrameCounter),
     deviceEvent(e)
 {}
 
 QVREvent::QVREvent(QVREventType t, const QVRRenderContext& c, const QKeyEvent& e) :
     type(t),
-    context(c),
+    processIndex(c.processIndex()),
+    windowIndex(c.windowIndex()),
+    frame(QVRFrameCounter),
     deviceEvent(QVRDevice(), -1, -1),
     keyEventType(e.type()),
     keyEventKey(e.key()),
@@ -61,11 +150,15 @@ QVREvent::QVREvent(QVREventType t, const QVRRenderContext& c, const QKeyEvent& e
     keyEventText(e.text()),
     keyEventAutorepeat(e.isAutoRepeat()),
     keyEventCount(e.count())
-{}
+{
+    QVREventContexts->set(frame, c);
+}
 
 QVREvent::QVREvent(QVREventType t, const QVRRenderContext& c, const QMouseEvent& e) :
     type(t),
-    context(c),
+    processIndex(c.processIndex()),
+    windowIndex(c.windowIndex()),
+    frame(QVRFrameCounter),
     deviceEvent(QVRDevice(), -1, -1),
     mouseEventType(e.type()),
     mouseEventPosition(e.position()),
@@ -74,11 +167,15 @@ QVREvent::QVREvent(QVREventType t, const QVRRenderContext& c, const QMouseEvent&
     mouseEventButton(e.button()),
     mouseEventButtons(e.buttons()),
     mouseEventModifiers(e.modifiers())
-{}
+{
+    QVREventContexts->set(frame, c);
+}
 
 QVREvent::QVREvent(QVREventType t, const QVRRenderContext& c, const QWheelEvent& e) :
     type(t),
-    context(c),
+    processIndex(c.processIndex()),
+    windowIndex(c.windowIndex()),
+    frame(QVRFrameCounter),
     deviceEvent(QVRDevice(), -1, -1),
     wheelEventPosition(e.position()),
     wheelEventGlobalPosition(e.globalPosition()),
@@ -88,7 +185,9 @@ QVREvent::QVREvent(QVREventType t, const QVRRenderContext& c, const QWheelEvent&
     wheelEventModifiers(e.modifiers()),
     wheelEventPhase(e.phase()),
     wheelEventInverted(e.inverted())
-{}
+{
+    QVREventContexts->set(frame, c);
+}
 
 QKeyEvent* QVREvent::createKeyEvent() const
 {
@@ -110,9 +209,16 @@ QWheelEvent* QVREvent::createWheelEvent() const
             wheelEventInverted);
 }
 
+const QVRRenderContext& QVREvent::context() const
+{
+    return QVREventContexts->get(processIndex, windowIndex, frame);
+}
+
 QDataStream &operator<<(QDataStream& ds, const QVREvent& e)
 {
-    ds << static_cast<int>(e.type) << e.context;
+    ds << static_cast<quint8>(e.type)
+        << static_cast<qint16>(e.processIndex) << static_cast<qint16>(e.windowIndex)
+        << e.frame;
     switch (e.type) {
     case QVR_Event_KeyPress:
     case QVR_Event_KeyRelease:
@@ -151,6 +257,8 @@ QDataStream &operator<<(QDataStream& ds, const QVREvent& e)
     case QVR_Event_DeviceButtonPress:
     case QVR_Event_DeviceButtonRelease:
     case QVR_Event_DeviceAnalogChange:
+        // The device state is written as well: it must be the one at the time
+        // of the event, not the current one (which differs e.g. during replay).
         ds << e.deviceEvent.device()
             << e.deviceEvent.buttonIndex()
             << e.deviceEvent.analogIndex();
@@ -160,10 +268,12 @@ QDataStream &operator<<(QDataStream& ds, const QVREvent& e)
 
 QDataStream &operator>>(QDataStream& ds, QVREvent& e)
 {
-    int type;
-    ds >> type;
+    quint8 type;
+    qint16 processIndex, windowIndex;
+    ds >> type >> processIndex >> windowIndex >> e.frame;
     e.type = static_cast<QVREventType>(type);
-    ds >> e.context;
+    e.processIndex = processIndex;
+    e.windowIndex = windowIndex;
 
     int intval;
     switch (e.type) {
@@ -223,3 +333,79 @@ QDataStream &operator>>(QDataStream& ds, QVREvent& e)
     }
     return ds;
 }
+
+static bool QVREventIsCoalescable(const QVREvent& e, const QVREvent& next)
+{
+    if (e.type == QVR_Event_MouseMove && next.type == QVR_Event_MouseMove) {
+        return e.processIndex == next.processIndex
+            && e.windowIndex == next.windowIndex
+            && e.mouseEventButtons == next.mouseEventButtons
+            && e.mouseEventModifiers == next.mouseEventModifiers;
+    } else if (e.type == QVR_Event_DeviceAnalogChange && next.type == QVR_Event_DeviceAnalogChange) {
+        return e.deviceEvent.device().index() == next.deviceEvent.device().index()
+            && e.deviceEvent.analogIndex() == next.deviceEvent.analogIndex();
+    }
+    return false;
+}
+
+void QVRCoalesceEvents(QQueue<QVREvent>* queue)
+{
+    QQueue<QVREvent> coalesced;
+    while (!queue->empty()) {
+        QVREvent e = queue->dequeue();
+        if (!queue->empty() && QVREventIsCoalescable(e, queue->front()))
+            continue;
+        coalesced.enqueue(e);
+    }
+    queue->swap(coalesced);
+}
+
+int QVRSerializeEvents(QDataStream& ds, QQueue<QVREvent>* queue, bool coalesce)
+{
+    // Coalesce events if requested, and find the window frames whose contexts we need
+    QList<QVREvent> events;
+    QList<int> contextEvents; // index of the first event of each (process, window, frame)
+    while (!queue->empty()) {
+        QVREvent e = queue->dequeue();
+        if (coalesce && !queue->empty() && QVREventIsCoalescable(e, queue->front()))
+            continue;
+        if (e.windowIndex >= 0) {
+            bool known = false;
+            for (int i = 0; i < contextEvents.size() && !known; i++) {
+                const QVREvent& c = events[contextEvents[i]];
+                known = (c.processIndex == e.processIndex && c.windowIndex == e.windowIndex && c.frame == e.frame);
+            }
+            if (!known)
+                contextEvents.append(events.size());
+        }
+        events.append(e);
+    }
+    // Write each referenced context once, followed by the events
+    ds << static_cast<int>(contextEvents.size());
+    for (int i = 0; i < contextEvents.size(); i++) {
+        const QVREvent& c = events[contextEvents[i]];
+        ds << c.processIndex << c.windowIndex << c.frame
+            << QVREventContexts->getSerialized(c.processIndex, c.windowIndex, c.frame);
+    }
+    for (int i = 0; i < events.size(); i++)
+        ds << events[i];
+    return events.size();
+}
+
+void QVRDeserializeEvents(QDataStream& ds, int n, QList<QVREvent>* list)
+{
+    int contexts;
+    ds >> contexts;
+    for (int i = 0; i < contexts; i++) {
+        int p, w;
+        unsigned int frame;
+        QByteArray serializedContext;
+        ds >> p >> w >> frame >> serializedContext;
+        QVREventContexts->setSerialized(p, w, frame, serializedContext);
+    }
+    QVREvent e;
+    for (int i = 0; i < n; i++) {
+        ds >> e;
+        list->append(e);
+    }
+}
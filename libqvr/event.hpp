@@ -28,6 +28,9 @@
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QList>
+#include <QQueue>
+#include <QByteArray>
 
 #include "device.hpp"
 #include "rendercontext.hpp"
@@ -47,11 +50,56 @@ typedef enum {
     QVR_Event_DeviceAnalogChange
 } QVREventType;
 
+/* Events do not carry the render context of the window that generated them,
+ * since it is large and the same for all events of a window in a given frame.
+ * Instead, each window stores its context in this table once per frame, and
+ * events refer to it by process index, window index and frame number. Since
+ * the frame is part of the key, events of decoupled windows or windows with a
+ * render divisor that span several frames still find their own context.
+ * Contexts received from child processes are kept in serialized form and are
+ * only deserialized when the application actually asks for them.
+ * The table only needs to hold the contexts of queued events, so it is
+ * cleared whenever the event queue has been emptied. */
+class QVREventContextTable
+{
+private:
+    class Entry
+    {
+    public:
+        int processIndex;
+        int windowIndex;
+        unsigned int frame;
+        bool isDeserialized;
+        QVRRenderContext context;
+        QByteArray serializedContext;
+        Entry() : processIndex(-1), windowIndex(-1), frame(0), isDeserialized(false) {}
+    };
+    QList<Entry> _entries;
+
+    // Return the index of an entry, or -1 if there is none.
+    int find(int processIndex, int windowIndex, unsigned int frame) const;
+    // Return an entry, appending it if there is none. Only setters may append.
+    Entry& insert(int processIndex, int windowIndex, unsigned int frame);
+
+public:
+    QVREventContextTable() {}
+
+    void set(unsigned int frame, const QVRRenderContext& context);
+    void setSerialized(int processIndex, int windowIndex, unsigned int frame, const QByteArray& serializedContext);
+    const QVRRenderContext& get(int processIndex, int windowIndex, unsigned int frame);
+    const QByteArray& getSerialized(int processIndex, int windowIndex, unsigned int frame);
+    void clear();
+};
+
 class QVREvent
 {
 public:
     QVREventType type;
-    QVRRenderContext context;
+    /* The window that generated the event (-1 for device events), and the
+     * frame of the generating process. See QVREventContextTable. */
+    int processIndex;
+    int windowIndex;
+    unsigned int frame;
     QVRDeviceEvent deviceEvent;
     /* for QKeyEvent: */
     QEvent::Type keyEventType;
@@ -90,9 +138,25 @@ public:
     QKeyEvent* createKeyEvent() const;
     QMouseEvent* createMouseEvent() const;
     QWheelEvent* createWheelEvent() const;
+
+    /* Returns the render context of the window that generated the event. */
+    const QVRRenderContext& context() const;
 };
 
 QDataStream &operator<<(QDataStream& ds, const QVREvent& e);
 QDataStream &operator>>(QDataStream& ds, QVREvent& e);
 
+/* Coalesce consecutive mouse move events of the same window and consecutive analog
+ * change events of the same device analog into the latest one. The main process does
+ * this before it hands its queue to the application; device events only originate there. */
+void QVRCoalesceEvents(QQueue<QVREvent>* queue);
+/* Serialize all events in the queue, emptying it, for transfer to the main process.
+ * If coalesce is set, the events are coalesced as by QVRCoalesceEvents().
+ * The render context of each window and frame that generated events is written only once.
+ * Returns the number of events written. */
+int QVRSerializeEvents(QDataStream& ds, QQueue<QVREvent>* queue, bool coalesce);
+/* Read n events written by QVRSerializeEvents() and append them to the list.
+ * The render contexts are stored in QVREventContexts. */
+void QVRDeserializeEvents(QDataStream& ds, int n, QList<QVREvent>* list);
+
 #endif
@@ -22,8 +22,31 @@
  */
 
 #include <QDataStream>
+#include <QVarLengthArray>
+
+#if defined(__AVX__)
+# include <immintrin.h>
+# define QVR_CULLING_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define QVR_CULLING_SSE
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+# define QVR_CULLING_NEON
+#endif
 
 #include "frustum.hpp"
+#include "rendercontext.hpp"
+
+// No contraction into fused multiply-add, see cullSpheres(). GCC ignores this
+// pragma and needs -ffp-contract=off instead, which the build files set.
+#if defined(__clang__)
+# pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+# pragma fp_contract(off)
+#endif
 
 
 QVRFrustum::QVRFrustum() : _lrbtnf { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }
@@ -48,6 +71,140 @@ QMatrix4x4 QVRFrustum::toMatrix4x4() const
     return m;
 }
 
+void QVRFrustum::getCullingPlanes(const QMatrix4x4& viewMatrix, QVector4D* planes) const
+{
+    // Extract the planes from the combined projection and view matrix
+    // (Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes
+    // from the World-View-Projection Matrix", 2001).
+    QMatrix4x4 m = toMatrix4x4() * viewMatrix;
+    QVector4D r0 = m.row(0);
+    QVector4D r1 = m.row(1);
+    QVector4D r2 = m.row(2);
+    QVector4D r3 = m.row(3);
+    planes[0] = r3 + r0; // left
+    planes[1] = r3 - r0; // right
+    planes[2] = r3 + r1; // bottom
+    planes[3] = r3 - r1; // top
+    planes[4] = r3 + r2; // near
+    planes[5] = r3 - r2; // far
+    for (int i = 0; i < 6; i++) {
+        float l = planes[i].toVector3D().length();
+        if (l > 0.0f)
+            planes[i] /= l;
+    }
+}
+
+/* The common culling kernel for spheres and boxes: object i is outside of plane p if
+ * a * px[p][i] + b * py[p][i] + c * pz[p][i] + d + r[i] < 0, where r may be NULL. */
+static void QVRCull(const QVector4D* planes, int planeCount, int count,
+        const float* const* px, const float* const* py, const float* const* pz,
+        const float* r, quint32* visibility)
+{
+    for (int w = 0; w < (count + 31) / 32; w++)
+        visibility[w] = 0;
+    int i = 0;
+#ifdef QVR_CULLING_AVX
+    for (; i + 8 <= count; i += 8) {
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        __m256 radius = (r ? _mm256_loadu_ps(r + i) : _mm256_setzero_ps());
+        for (int p = 0; p < planeCount; p++) {
+            __m256 d = _mm256_add_ps(_mm256_set1_ps(planes[p].w()), radius);
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes[p].x()), _mm256_loadu_ps(px[p] + i)));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes[p].y()), _mm256_loadu_ps(py[p] + i)));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes[p].z()), _mm256_loadu_ps(pz[p] + i)));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        visibility[i / 32] |= quint32(_mm256_movemask_ps(visible)) << (i % 32);
+    }
+#endif
+#ifdef QVR_CULLING_SSE
+    for (; i + 4 <= count; i += 4) {
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128 radius = (r ? _mm_loadu_ps(r + i) : _mm_setzero_ps());
+        for (int p = 0; p < planeCount; p++) {
+            __m128 d = _mm_add_ps(_mm_set1_ps(planes[p].w()), radius);
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].x()), _mm_loadu_ps(px[p] + i)));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].y()), _mm_loadu_ps(py[p] + i)));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes[p].z()), _mm_loadu_ps(pz[p] + i)));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(d, _mm_setzero_ps()));
+        }
+        visibility[i / 32] |= quint32(_mm_movemask_ps(visible)) << (i % 32);
+    }
+#endif
+#ifdef QVR_CULLING_NEON
+    static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t visible = vdupq_n_u32(0xffffffffu);
+        float32x4_t radius = (r ? vld1q_f32(r + i) : vdupq_n_f32(0.0f));
+        for (int p = 0; p < planeCount; p++) {
+            float32x4_t d = vaddq_f32(vdupq_n_f32(planes[p].w()), radius);
+            d = vmlaq_n_f32(d, vld1q_f32(px[p] + i), planes[p].x());
+            d = vmlaq_n_f32(d, vld1q_f32(py[p] + i), planes[p].y());
+            d = vmlaq_n_f32(d, vld1q_f32(pz[p] + i), planes[p].z());
+            visible = vandq_u32(visible, vcgeq_f32(d, vdupq_n_f32(0.0f)));
+        }
+        visibility[i / 32] |= quint32(vaddvq_u32(vandq_u32(visible, vld1q_u32(laneBits)))) << (i % 32);
+    }
+#endif
+    for (; i < count; i++) {
+        bool visible = true;
+        float radius = (r ? r[i] : 0.0f);
+        for (int p = 0; visible && p < planeCount; p++) {
+            // same order of operations as in the vector kernels
+            float d = planes[p].w() + radius;
+            d += planes[p].x() * px[p][i];
+            d += planes[p].y() * py[p][i];
+            d += planes[p].z() * pz[p][i];
+            visible = (d >= 0.0f);
+        }
+        if (visible)
+            visibility[i / 32] |= (1u << (i % 32));
+    }
+}
+
+void QVRFrustum::cullSpheres(const QVector4D* planes, int planeCount, int count,
+        const float* x, const float* y, const float* z, const float* radius,
+        quint32* visibility)
+{
+    QVarLengthArray<const float*, QVRRenderContext::maxProcessCullingPlanes> px(planeCount), py(planeCount), pz(planeCount);
+    for (int p = 0; p < planeCount; p++) {
+        px[p] = x;
+        py[p] = y;
+        pz[p] = z;
+    }
+    QVRCull(planes, planeCount, count, px.constData(), py.constData(), pz.constData(), radius, visibility);
+}
+
+void QVRFrustum::cullBoxes(const QVector4D* planes, int planeCount, int count,
+        const float* minX, const float* minY, const float* minZ,
+        const float* maxX, const float* maxY, const float* maxZ,
+        quint32* visibility)
+{
+    // For each plane, only the box corner that lies farthest along the plane normal
+    // needs to be tested. Since the plane is the same for all boxes, this boils down
+    // to choosing between the min and max arrays once per plane.
+    QVarLengthArray<const float*, QVRRenderContext::maxProcessCullingPlanes> px(planeCount), py(planeCount), pz(planeCount);
+    for (int p = 0; p < planeCount; p++) {
+        px[p] = (planes[p].x() >= 0.0f ? maxX : minX);
+        py[p] = (planes[p].y() >= 0.0f ? maxY : minY);
+        pz[p] = (planes[p].z() >= 0.0f ? maxZ : minZ);
+    }
+    QVRCull(planes, planeCount, count, px.constData(), py.constData(), pz.constData(), NULL, visibility);
+}
+
+const char* QVRFrustum::cullingImplementation()
+{
+#if defined(QVR_CULLING_AVX)
+    return "avx";
+#elif defined(QVR_CULLING_SSE)
+    return "sse";
+#elif defined(QVR_CULLING_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
 void QVRFrustum::adjustNearPlane(float n)
 {
     float q = n / nearPlane();
@@ -25,6 +25,7 @@
 #define QVR_FRUSTUM_HPP
 
 #include <QMatrix4x4>
+#include <QVector4D>
 
 class QDataStream;
 
@@ -96,6 +97,72 @@ public:
      */
     QMatrix4x4 toMatrix4x4() const;
 
+    /*!
+     * \brief Computes world space culling planes.
+     * \param viewMatrix    The view matrix that transforms world coordinates to eye coordinates
+     * \param planes        Array of 6 planes: left, right, bottom, top, near, far
+     *
+     * Each plane (a, b, c, d) has a normalized normal (a, b, c) that points into the frustum,
+     * so that a point (x, y, z) is on the inside if a*x + b*y + c*z + d >= 0.
+     * The planes can be used with \a cullSpheres() and \a cullBoxes().
+     */
+    void getCullingPlanes(const QMatrix4x4& viewMatrix, QVector4D* planes) const;
+
+    /*!
+     * \brief Tests an array of bounding spheres against culling planes.
+     * \param planes        The culling planes, see \a getCullingPlanes()
+     * \param planeCount    The number of culling planes
+     * \param count         The number of spheres
+     * \param x             The x coordinates of the sphere centers
+     * \param y             The y coordinates of the sphere centers
+     * \param z             The z coordinates of the sphere centers
+     * \param radius        The sphere radii
+     * \param visibility    The resulting bit mask with (count + 31) / 32 entries
+     *
+     * Bit (i % 32) of visibility[i / 32] is set if sphere i is not completely outside of
+     * one of the planes. The test is conservative: spheres near the frustum corners may be
+     * reported as visible even though they are not.
+     *
+     * The spheres are given in structure-of-arrays layout, which allows the test to
+     * process several spheres at once with SSE, AVX, or NEON instructions, depending on
+     * the instruction set that libqvr was compiled for; see \a cullingImplementation().
+     * All instruction sets give exactly the same result as the scalar code only if the
+     * compiler does not contract multiplications and additions into fused multiply-add
+     * instructions (e.g. with -ffp-contract=fast, the GCC default, and -march=native).
+     * The libqvr build therefore disables contraction for the culling code (with
+     * -ffp-contract=off for GCC and Clang, and /fp:precise for MSVC).
+     */
+    static void cullSpheres(const QVector4D* planes, int planeCount, int count,
+            const float* x, const float* y, const float* z, const float* radius,
+            quint32* visibility);
+
+    /*!
+     * \brief Tests an array of axis-aligned bounding boxes against culling planes.
+     * \param planes        The culling planes, see \a getCullingPlanes()
+     * \param planeCount    The number of culling planes
+     * \param count         The number of boxes
+     * \param minX          The minimum x coordinates of the boxes
+     * \param minY          The minimum y coordinates of the boxes
+     * \param minZ          The minimum z coordinates of the boxes
+     * \param maxX          The maximum x coordinates of the boxes
+     * \param maxY          The maximum y coordinates of the boxes
+     * \param maxZ          The maximum z coordinates of the boxes
+     * \param visibility    The resulting bit mask with (count + 31) / 32 entries
+     *
+     * This works like \a cullSpheres(), but for boxes.
+     */
+    static void cullBoxes(const QVector4D* planes, int planeCount, int count,
+            const float* minX, const float* minY, const float* minZ,
+            const float* maxX, const float* maxY, const float* maxZ,
+            quint32* visibility);
+
+    /*!
+     * \brief Returns the name of the instruction set used by \a cullSpheres() and \a cullBoxes().
+     *
+     * This is one of "avx", "sse", "neon", or "scalar".
+     */
+    static const char* cullingImplementation();
+
     /*!
      * \brief Adjusts the near plane while preserving the frustum shape.
      * \param n         The new near clipping plane
@@ -83,8 +83,15 @@ void QVRMatrixToPose(const QMatrix4x4& matrix, QQuaternion* orientation, QVector
     *position = QVector3D(matrix(0, 3), matrix(1, 3), matrix(2, 3));
 }
 
-/* Global event queue */
+/* Global event queue, and the render contexts that events refer to */
 QQueue<QVREvent>* QVREventQueue = NULL;
+QVREventContextTable* QVREventContexts = NULL;
+
+/* Global pool of the view textures of this process */
+QVRTexturePool* QVRViewTexturePool = NULL;
+
+/* Global frame counter of this process, incremented by QVRManager::render() */
+unsigned int QVRFrameCounter = 0;
 
 /* Global timer */
 QElapsedTimer QVRTimer;
@@ -37,6 +37,7 @@
 
 #include "event.hpp"
 class QVRManager;
+class QVRTexturePool;
 
 
 /* Global manager instance (singleton) */
@@ -52,8 +53,15 @@ void QVRGetScreenInfo();
 /* Global helper functions */
 void QVRMatrixToPose(const QMatrix4x4& matrix, QQuaternion* orientation, QVector3D* position);
 
-/* Global event queue */
+/* Global event queue, and the render contexts that events refer to */
 extern QQueue<QVREvent>* QVREventQueue;
+extern QVREventContextTable* QVREventContexts;
+
+/* Global pool of the view textures of this process */
+extern QVRTexturePool* QVRViewTexturePool;
+
+/* Global frame counter of this process, incremented by QVRManager::render() */
+extern unsigned int QVRFrameCounter;
 
 /* Global timer */
 extern QElapsedTimer QVRTimer;
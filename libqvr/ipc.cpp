@@ -237,9 +237,68 @@ qint64 QVRSharedMemoryDevice::writeData(const char* data, qint64 maxSize)
 // The following sizes should avoid read/write synchronization waits in most cases.
 // Such waits happen when the size of transferred data exceeds the data buffer size
 // of the QVRSharedMemoryDevice. This usually only happens with applications that
-// serialize a lot of dynamic data.
+// serialize a lot of dynamic data, and with processes that send pixel data.
 static const int QVRSharedMemoryServerDeviceSize = 1024 * 1024; // Shared memory size for server->client device
 static const int QVRSharedMemoryClientDeviceSize = 2048; // Shared memory size for client->server device
+static const int QVRSharedMemoryPixelClientDeviceSize = 16 * 1024 * 1024; // same, for processes that send pixels
+static const int QVRSharedMemoryPixelServerDeviceSize = 16 * 1024 * 1024; // server->client device for display-only processes
+
+// Decoupled and display-only processes have their own server->client device;
+// all other child processes share one.
+static bool QVRHasOwnSharedMemServerDevice(int processIndex)
+{
+    const QVRProcessConfig& processConfig = QVRManager::processConfig(processIndex);
+    return (processConfig.decoupledRendering() || processConfig.displayOnly());
+}
+
+// Offset of the given server->client device. For the number of server devices,
+// this returns the total size of all server devices.
+static int QVRGetSharedMemServerDeviceOffset(int serverIndex)
+{
+    int offset = 0;
+    int index = 0;
+    for (int p = 1; p < QVRManager::processCount(); p++) {
+        if (!QVRHasOwnSharedMemServerDevice(p)) {
+            // the shared device comes first
+            if (serverIndex == 0)
+                return 0;
+            offset = QVRSharedMemoryServerDeviceSize;
+            index = 1;
+            break;
+        }
+    }
+    for (int p = 1; p < QVRManager::processCount() && index < serverIndex; p++) {
+        if (QVRHasOwnSharedMemServerDevice(p)) {
+            offset += (QVRManager::processConfig(p).displayOnly()
+                    ? QVRSharedMemoryPixelServerDeviceSize : QVRSharedMemoryServerDeviceSize);
+            index++;
+        }
+    }
+    return offset;
+}
+
+static int QVRGetSharedMemServerDeviceSize(int serverIndex)
+{
+    return QVRGetSharedMemServerDeviceOffset(serverIndex + 1) - QVRGetSharedMemServerDeviceOffset(serverIndex);
+}
+
+static int QVRGetSharedMemClientDeviceSize(int processIndex)
+{
+    const QVRProcessConfig& processConfig = QVRManager::processConfig(processIndex);
+    for (int w = 0; w < processConfig.windowConfigs().size(); w++) {
+        if (!processConfig.windowConfigs()[w].tileOwnerId().isEmpty())
+            return QVRSharedMemoryPixelClientDeviceSize;
+    }
+    return QVRSharedMemoryClientDeviceSize;
+}
+
+static int QVRGetSharedMemClientDeviceOffset(int serverDeviceCount, int processIndex)
+{
+    int offset = QVRGetSharedMemServerDeviceOffset(serverDeviceCount);
+    for (int p = 1; p < processIndex; p++)
+        offset += QVRGetSharedMemClientDeviceSize(p);
+    return offset;
+}
 
 static void QVRGetSharedMemServerConfigs(int* serverDeviceCount, int* coupledClientCount,
         int* serverIndexForThisProcess, int* coupledClientIndexForThisProcess)
@@ -249,7 +308,7 @@ static void QVRGetSharedMemServerConfigs(int* serverDeviceCount, int* coupledCli
     *serverIndexForThisProcess = 0;
     *coupledClientIndexForThisProcess = 0;
     for (int p = 1; p < QVRManager::processCount(); p++) {
-        if (QVRManager::processConfig(p).decoupledRendering()) {
+        if (QVRHasOwnSharedMemServerDevice(p)) {
             (*serverDeviceCount)++;
         } else {
             if (*coupledClientCount == 0)
@@ -259,11 +318,11 @@ static void QVRGetSharedMemServerConfigs(int* serverDeviceCount, int* coupledCli
             (*coupledClientCount)++;
         }
     }
-    if (QVRManager::processConfig(QVRManager::processIndex()).decoupledRendering()) {
+    if (QVRHasOwnSharedMemServerDevice(QVRManager::processIndex())) {
         if (*coupledClientCount > 0)
             *serverIndexForThisProcess = 1;
         for (int p = 1; p < QVRManager::processIndex(); p++)
-            if (QVRManager::processConfig(p).decoupledRendering())
+            if (QVRHasOwnSharedMemServerDevice(p))
                 (*serverIndexForThisProcess)++;
     }
 }
@@ -419,16 +478,16 @@ bool QVRClient::start(const QString& serverName)
                 &coupledClientCount,
                 &serverIndexForThisProcess,
                 &coupledClientIndexForThisProcess);
+        bool haveOwnServerDevice = QVRHasOwnSharedMemServerDevice(QVRManager::processIndex());
         _sharedMemServerDevice = new QVRSharedMemoryDevice(
-                QVRManager::processConfig().decoupledRendering() ? 1 : coupledClientCount,
-                static_cast<char*>(sharedMem->data()) + serverIndexForThisProcess * QVRSharedMemoryServerDeviceSize,
-                QVRSharedMemoryServerDeviceSize);
-        _sharedMemServerDevice->openReader(QVRManager::processConfig().decoupledRendering() ? 0
-                : coupledClientIndexForThisProcess);
+                haveOwnServerDevice ? 1 : coupledClientCount,
+                static_cast<char*>(sharedMem->data()) + QVRGetSharedMemServerDeviceOffset(serverIndexForThisProcess),
+                QVRGetSharedMemServerDeviceSize(serverIndexForThisProcess));
+        _sharedMemServerDevice->openReader(haveOwnServerDevice ? 0 : coupledClientIndexForThisProcess);
         _sharedMemClientDevice = new QVRSharedMemoryDevice(1,
-                static_cast<char*>(sharedMem->data()) + serverDeviceCount * QVRSharedMemoryServerDeviceSize
-                + (QVRManager::processIndex() - 1) * QVRSharedMemoryClientDeviceSize,
-                QVRSharedMemoryClientDeviceSize);
+                static_cast<char*>(sharedMem->data())
+                + QVRGetSharedMemClientDeviceOffset(serverDeviceCount, QVRManager::processIndex()),
+                QVRGetSharedMemClientDeviceSize(QVRManager::processIndex()));
         _sharedMemClientDevice->openWriter();
     } else {
         QVR_FATAL("invalid server specification %s", qPrintable(serverName));
@@ -449,6 +508,16 @@ void QVRClient::sendCmdSync(int n, const QByteArray& serializedEvents)
     QVRWriteData(outputDevice(), serializedEvents);
 }
 
+void QVRClient::sendTile(const QByteArray& tileData)
+{
+    QVRWriteData(outputDevice(), tileData);
+}
+
+void QVRClient::sendStreamInfo(const QByteArray& serializedStreamInfo)
+{
+    QVRWriteData(outputDevice(), serializedStreamInfo);
+}
+
 void QVRClient::flush()
 {
     if (_tcpSocket)
@@ -470,6 +539,7 @@ bool QVRClient::receiveCmd(QVRClientCmd* cmd, bool waitForIt)
         case 'd': *cmd = QVRClientCmdDevice; break;
         case 'w': *cmd = QVRClientCmdWasdqeState; break;
         case 'o': *cmd = QVRClientCmdObserver; break;
+        case 't': *cmd = QVRClientCmdTiles; break;
         case 'r': *cmd = QVRClientCmdRender; break;
         case 'q': *cmd = QVRClientCmdQuit; break;
         default:  *cmd = QVRClientCmdInvalid; break;
@@ -506,6 +576,18 @@ void QVRClient::receiveCmdObserverArgs(QVRObserver* obs)
     ds >> *obs;
 }
 
+void QVRClient::receiveCmdTilesArgs(QByteArray* serializedTiles)
+{
+    QVRReadData(inputDevice(), *serializedTiles);
+}
+
+void QVRClient::receiveStreamFrame(QByteArray* frameData)
+{
+    QVRReadData(inputDevice(), *frameData);
+    if (_tcpSocket)
+        *frameData = qUncompress(*frameData);
+}
+
 void QVRClient::receiveCmdRenderArgs(float* n, float* f, QVRApp* app)
 {
     QVRReadData(inputDevice(), _data);
@@ -607,8 +689,7 @@ bool QVRServer::startSharedMemory()
 
     QString name = QUuid::createUuid().toString().mid(1, 36);
     QSharedMemory* sharedMemory = new QSharedMemory(name);
-    bool r = sharedMemory->create(serverDeviceCount * QVRSharedMemoryServerDeviceSize
-            + clientCount * QVRSharedMemoryClientDeviceSize);
+    bool r = sharedMemory->create(QVRGetSharedMemClientDeviceOffset(serverDeviceCount, clientCount + 1));
     if (!r) {
         QVR_FATAL("cannot initialize shared memory: %s", qPrintable(sharedMemory->errorString()));
         delete sharedMemory;
@@ -616,7 +697,8 @@ bool QVRServer::startSharedMemory()
     }
     _sharedMem = sharedMemory;
 
-    // create server devices: one for all coupled clients (if any), and one for each decoupled client
+    // create server devices: one for all coupled clients (if any), and one for each
+    // decoupled or display-only client
     _sharedMemHaveCoupledClients = (coupledClientCount > 0);
     if (coupledClientCount > 0) {
         _sharedMemServerDevices.append(new QVRSharedMemoryDevice(coupledClientCount,
@@ -626,10 +708,10 @@ bool QVRServer::startSharedMemory()
     _sharedMemServerForClientMap.resize(clientCount);
     int decoupledProcessServerIndex = (_sharedMemHaveCoupledClients ? 1 : 0);
     for (int p = 1; p < QVRManager::processCount(); p++) {
-        if (QVRManager::processConfig(p).decoupledRendering()) {
+        if (QVRHasOwnSharedMemServerDevice(p)) {
+            int s = _sharedMemServerDevices.length();
             _sharedMemServerDevices.append(new QVRSharedMemoryDevice(1, static_cast<char*>(_sharedMem->data())
-                        + _sharedMemServerDevices.length() * QVRSharedMemoryServerDeviceSize,
-                        QVRSharedMemoryServerDeviceSize));
+                        + QVRGetSharedMemServerDeviceOffset(s), QVRGetSharedMemServerDeviceSize(s)));
             _sharedMemServerDevices.last()->openWriter();
             _sharedMemServerForClientMap[p - 1] = decoupledProcessServerIndex++;
         } else {
@@ -639,9 +721,8 @@ bool QVRServer::startSharedMemory()
     // create client devices
     for (int p = 1; p < QVRManager::processCount(); p++) {
         _sharedMemClientDevices.append(new QVRSharedMemoryDevice(1, static_cast<char*>(_sharedMem->data())
-                    + serverDeviceCount * QVRSharedMemoryServerDeviceSize
-                    + (p - 1) * QVRSharedMemoryClientDeviceSize,
-                    QVRSharedMemoryClientDeviceSize));
+                    + QVRGetSharedMemClientDeviceOffset(serverDeviceCount, p),
+                    QVRGetSharedMemClientDeviceSize(p)));
         _sharedMemClientDevices.last()->openReader(0);
     }
 
@@ -728,24 +809,63 @@ bool QVRServer::waitForClients()
         }
     }
     _clientIsSynced.resize(clientCount);
-    for (int i = 0; i < clientCount; i++)
+    _clientHasMailbox.resize(clientCount);
+    _mailbox.resize(clientCount);
+    _mailboxIsComplete.resize(clientCount);
+    _mailboxWasDelivered.resize(clientCount);
+    for (int i = 0; i < clientCount; i++) {
         _clientIsSynced[i] = true;
+        // Clients that own devices must sync regularly to answer device update
+        // requests, so only decoupled clients without devices get a mailbox.
+        _clientHasMailbox[i] = QVRManager::processConfig(i + 1).decoupledRendering();
+        for (int d = 0; d < QVRManager::config().deviceConfigs().size(); d++) {
+            if (QVRManager::config().deviceConfigs()[d].processIndex() == i + 1)
+                _clientHasMailbox[i] = false;
+        }
+        _mailboxIsComplete[i] = false;
+        _mailboxWasDelivered[i] = false;
+    }
     return true;
 }
 
+QIODevice* QVRServer::outputDevice(int i)
+{
+    if (_tcpServer)
+        return _tcpSockets[i];
+    else if (_localServer)
+        return _localSockets[i];
+    else
+        return _sharedMemServerDevices[_sharedMemServerForClientMap[i]];
+}
+
+static void QVRAppendMailboxData(QByteArray& mailbox, const QByteArray& data)
+{
+    int s = data.size();
+    mailbox.append(reinterpret_cast<const char*>(&s), sizeof(int));
+    mailbox.append(data);
+}
+
+void QVRServer::deliverMailbox(int i)
+{
+    // Let the client start its next frame right away with the newest
+    // state; it stays unsynced since it is rendering again.
+    QVRWriteData(outputDevice(i), _mailbox[i].constData(), _mailbox[i].size());
+    if (_tcpServer)
+        _tcpSockets[i]->flush();
+    else if (_localServer)
+        _localSockets[i]->flush();
+    _mailbox[i].resize(0);
+    _mailboxIsComplete[i] = false;
+}
+
 void QVRServer::sendCmd(const char cmd, const QByteArray& data0, const QByteArray& data1)
 {
     bool wroteToCoupledServerDevice = false;
     for (int i = 0; i < inputDevices(); i++) {
         if (_clientIsSynced[i]) {
             bool doWrite = true;
-            QIODevice* dev;
-            if (_tcpServer) {
-                dev = _tcpSockets[i];
-            } else if (_localServer) {
-                dev = _localSockets[i];
-            } else {
-                dev = _sharedMemServerDevices[_sharedMemServerForClientMap[i]];
+            QIODevice* dev = outputDevice(i);
+            if (!_tcpServer && !_localServer) {
                 if (_sharedMemServerForClientMap[i] == 0 && _sharedMemHaveCoupledClients) {
                     if (wroteToCoupledServerDevice) {
                         doWrite = false;
@@ -761,6 +881,27 @@ void QVRServer::sendCmd(const char cmd, const QByteArray& data0, const QByteArra
                 if (!data1.isNull())
                     QVRWriteData(dev, data1);
             }
+        } else if (_clientHasMailbox[i] && (cmd == 'd' || cmd == 'w' || cmd == 'o' || cmd == 't' || cmd == 'r')) {
+            // The render command is the last command of a frame, so the next
+            // command after it starts a new frame state that replaces the old one.
+            if (_mailboxIsComplete[i]) {
+                _mailbox[i].resize(0);
+                _mailboxIsComplete[i] = false;
+            }
+            _mailbox[i].append(cmd);
+            if (!data0.isNull())
+                QVRAppendMailboxData(_mailbox[i], data0);
+            if (!data1.isNull())
+                QVRAppendMailboxData(_mailbox[i], data1);
+            if (cmd == 'r') {
+                _mailboxIsComplete[i] = true;
+                // A client that synced since the last receiveCmdSync() is idle;
+                // do not make it wait for the end of this frame.
+                if (!_mailboxWasDelivered[i] && inputDevice(i)->bytesAvailable() > 0) {
+                    deliverMailbox(i);
+                    _mailboxWasDelivered[i] = true;
+                }
+            }
         }
     }
 }
@@ -790,6 +931,11 @@ void QVRServer::sendCmdObserver(const QByteArray& serializedObserver)
     sendCmd('o', serializedObserver);
 }
 
+void QVRServer::sendCmdTiles(const QByteArray& serializedTiles)
+{
+    sendCmd('t', serializedTiles);
+}
+
 void QVRServer::sendCmdRender(float n, float f, const QByteArray& serializedDynData)
 {
     float data[2] = { n, f };
@@ -836,17 +982,40 @@ void QVRServer::receiveReplyUpdateDevices(QList<QVRDevice*> deviceList)
     }
 }
 
+void QVRServer::receiveTile(int processIndex, QByteArray* tileData)
+{
+    Q_ASSERT(processIndex >= 1 && processIndex <= inputDevices());
+    Q_ASSERT(_clientIsSynced[processIndex - 1]);
+    QVRReadData(inputDevice(processIndex - 1), *tileData);
+}
+
+void QVRServer::sendStreamFrame(int processIndex, const QByteArray& frameData)
+{
+    Q_ASSERT(processIndex >= 1 && processIndex <= inputDevices());
+    Q_ASSERT(QVRManager::processConfig(processIndex).displayOnly());
+    QIODevice* dev = outputDevice(processIndex - 1);
+    // Remote display processes get compressed frames; the fastest zlib level
+    // is usually much faster than the network.
+    if (_tcpServer)
+        QVRWriteData(dev, qCompress(frameData, 1));
+    else
+        QVRWriteData(dev, frameData);
+}
+
+void QVRServer::receiveStreamInfo(int processIndex, QByteArray* serializedStreamInfo)
+{
+    Q_ASSERT(processIndex >= 1 && processIndex <= inputDevices());
+    Q_ASSERT(_clientIsSynced[processIndex - 1]);
+    QVRReadData(inputDevice(processIndex - 1), *serializedStreamInfo);
+}
+
 static void QVRServerReceiveCmdSyncHelper(QIODevice* device, QByteArray& data, QList<QVREvent>* eventList)
 {
     int n;
     QVRReadData(device, reinterpret_cast<char*>(&n), sizeof(int));
     QVRReadData(device, data);
     QDataStream ds(data);
-    QVREvent e;
-    for (int j = 0; j < n; j++) {
-        ds >> e;
-        eventList->append(e);
-    }
+    QVRDeserializeEvents(ds, n, eventList);
 }
 
 void QVRServer::receiveCmdSync(QList<QVREvent>* eventList)
@@ -863,7 +1032,14 @@ void QVRServer::receiveCmdSync(QList<QVREvent>* eventList)
     for (int i = 0; i < inputDevices(); i++) {
         if (!_clientIsSynced[i] && inputDevice(i)->bytesAvailable() > 0) {
             QVRServerReceiveCmdSyncHelper(inputDevice(i), _data, eventList);
-            _clientIsSynced[i] = true;
+            if (_mailboxWasDelivered[i]) {
+                // this sync was already answered in sendCmd()
+                _mailboxWasDelivered[i] = false;
+            } else if (_mailboxIsComplete[i]) {
+                deliverMailbox(i);
+            } else {
+                _clientIsSynced[i] = true;
+            }
         }
     }
 }
@@ -66,6 +66,7 @@ typedef enum {
     QVRClientCmdDevice,
     QVRClientCmdWasdqeState,
     QVRClientCmdObserver,
+    QVRClientCmdTiles,
     QVRClientCmdRender,
     QVRClientCmdQuit,
     QVRClientCmdInvalid
@@ -96,6 +97,13 @@ public:
     /* Commands that this client sends to the server */
     void sendReplyUpdateDevices(int n, const QByteArray& serializedDevices);
     void sendCmdSync(int n, const QByteArray& serializedEvents);
+    /* Send the rendered tile of a tile proxy window; see receiveCmdTilesArgs().
+     * This is sent after rendering and before the sync command. */
+    void sendTile(const QByteArray& tileData);
+    /* Send the window sizes and screen walls of a display-only process; see
+     * QVRServer::receiveStreamInfo(). This is sent after the render command
+     * and before the sync command. */
+    void sendStreamInfo(const QByteArray& serializedStreamInfo);
     /* Explicit flushing of the underlying socket */
     void flush();
 
@@ -108,7 +116,11 @@ public:
     void receiveCmdDeviceArgs(QVRDevice* dev);
     void receiveCmdWasdqeStateArgs(int*, int*, bool*);
     void receiveCmdObserverArgs(QVRObserver* obs);
+    void receiveCmdTilesArgs(QByteArray* serializedTiles);
     void receiveCmdRenderArgs(float* n, float* f, QVRApp* app);
+    /* Receive a streamed frame for a window of a display-only process; see
+     * QVRServer::sendStreamFrame(). */
+    void receiveStreamFrame(QByteArray* frameData);
 };
 
 /* The server, for the main process. Based on QLocalServer/QTcpServer. */
@@ -127,10 +139,21 @@ private:
     QVector<int> _sharedMemServerForClientMap;
     QVector<QVRSharedMemoryDevice*> _sharedMemClientDevices;
     QVector<bool> _clientIsSynced;
+    // Mailboxes for decoupled clients: while such a client is busy rendering, the
+    // newest frame state (device, wasdqe, observer, tiles and render commands) is
+    // kept here, overwritten every frame, and handed to the client as soon as it syncs.
+    // If the client already synced when the render command is queued, the mailbox
+    // is delivered right away and the pending sync is only consumed in receiveCmdSync().
+    QVector<bool> _clientHasMailbox;
+    QVector<QByteArray> _mailbox;
+    QVector<bool> _mailboxIsComplete;
+    QVector<bool> _mailboxWasDelivered;
 
     int inputDevices() const;
     QIODevice* inputDevice(int i);
+    QIODevice* outputDevice(int i);
 
+    void deliverMailbox(int i);
     void sendCmd(const char cmd,
             const QByteArray& data0 = QByteArray(static_cast<const char*>(0), 0),
             const QByteArray& data1 = QByteArray(static_cast<const char*>(0), 0));
@@ -157,6 +180,7 @@ public:
     void sendCmdDevice(const QByteArray& serializedDevice);
     void sendCmdWasdqeState(const QByteArray& serializedWasdqeState);
     void sendCmdObserver(const QByteArray& serializedObserver);
+    void sendCmdTiles(const QByteArray& serializedTiles);
     void sendCmdRender(float n, float f, const QByteArray& serializedDynData);
     void sendCmdQuit();
     /* Explicit flushing of the underlying sockets */
@@ -164,6 +188,17 @@ public:
 
     /* Replies that this server receives from clients. See sendCmdUpdateDevices(). */
     void receiveReplyUpdateDevices(QList<QVRDevice*> devices);
+    /* Receive the next tile that the given (coupled) client process sent with
+     * QVRClient::sendTile(). This must be called before receiveCmdSync(). */
+    void receiveTile(int processIndex, QByteArray* tileData);
+    /* Send a streamed frame to the given display-only client process, which
+     * receives it with QVRClient::receiveStreamFrame(). This is sent after the
+     * render command. Frames to remote clients are compressed. */
+    void sendStreamFrame(int processIndex, const QByteArray& frameData);
+    /* Receive the window sizes and screen walls that the given display-only
+     * client process sent with QVRClient::sendStreamInfo(). This must be called
+     * after sendStreamFrame() and before receiveCmdSync(). */
+    void receiveStreamInfo(int processIndex, QByteArray* serializedStreamInfo);
     /* Commands that this server receives from all clients.
      * This is always a list of zero or more event commands followed by a sync command.
      * The events (if any) will be appended to the given list. */
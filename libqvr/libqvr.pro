@@ -26,10 +26,15 @@ TEMPLATE = lib
 
 CONFIG += dll c++11
 
+# The culling kernels must not contract multiplications and additions; see frustum.hpp
+QMAKE_CXXFLAGS += -ffp-contract=off
+
 DEFINES += QT_DEPRECATED_WARNINGS \
 	HAVE_QGAMEPAD \
 	GL_SRGB8_ALPHA8=0x8C43   \
-	GL_RGBA8=0x8058
+	GL_RGBA8=0x8058 \
+	GL_TEXTURE_2D_ARRAY=0x8C1A \
+	GL_TEXTURE_BINDING_2D_ARRAY=0x8C1D
 
 SOURCES += \
 	manager.cpp \
@@ -43,7 +48,13 @@ SOURCES += \
 	logging.cpp \
 	event.cpp \
 	rendercontext.cpp \
-	frustum.cpp
+	frustum.cpp \
+	record.cpp \
+	texturepool.cpp \
+	capture.cpp \
+	tiling.cpp \
+	upscaler.cpp \
+	posetracker.cpp
 
 HEADERS += \
 	manager.hpp \
@@ -57,7 +68,13 @@ HEADERS += \
 	logging.hpp \
 	event.hpp \
 	rendercontext.hpp \
-	frustum.hpp
+	frustum.hpp \
+	record.hpp \
+	texturepool.hpp \
+	capture.hpp \
+	tiling.hpp \
+	upscaler.hpp \
+	posetracker.hpp
 
 RESOURCES += qvr.qrc
 
@@ -30,8 +30,13 @@
 #include <QGuiApplication>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QtMath>
 #include <QOpenGLContext>
 #include <QOpenGLExtraFunctions>
+#include <QOffscreenSurface>
+#include <QThread>
+#include <QSemaphore>
+#include <QAtomicInt>
 
 #include "manager.hpp"
 #include "event.hpp"
@@ -43,6 +48,10 @@
 #include "window.hpp"
 #include "process.hpp"
 #include "ipc.hpp"
+#include "record.hpp"
+#include "texturepool.hpp"
+#include "tiling.hpp"
+#include "posetracker.hpp"
 #include "internalglobals.hpp"
 
 
@@ -80,6 +89,89 @@ static void removeArg(int& argc, char* argv[], int i)
     argc -= 1;
 }
 
+// Render worker for parallel rendering: calls QVRApp::render() for one window
+// with its own context that shares objects with the main context
+class QVRRenderWorker : public QThread
+{
+private:
+    QVRApp* _app;
+    QVRWindow* _window;
+    QOffscreenSurface* _surface;
+    QOpenGLContext* _context;
+
+public:
+    // Handshakes with the main thread, as for the window threads
+    QAtomicInt exitWanted;
+    QSemaphore renderingWanted;
+    QSemaphore renderingFinished;
+    unsigned int textures[2];
+    void* fence; // GLsync that signals when the rendering is complete
+
+    QVRRenderWorker(QVRApp* app, QVRWindow* window, QOpenGLContext* shareContext);
+    ~QVRRenderWorker();
+
+    bool isValid() const { return _context->isValid(); }
+    void start();
+    void stop();
+
+protected:
+    void run() override;
+};
+
+QVRRenderWorker::QVRRenderWorker(QVRApp* app, QVRWindow* window, QOpenGLContext* shareContext) :
+    _app(app), _window(window), exitWanted(0), textures { 0, 0 }, fence(NULL)
+{
+    // Surfaces must be created in the main thread
+    _surface = new QOffscreenSurface;
+    _surface->setFormat(shareContext->format());
+    _surface->create();
+    _context = new QOpenGLContext;
+    _context->setShareContext(shareContext);
+    _context->setFormat(shareContext->format());
+    _context->create();
+}
+
+QVRRenderWorker::~QVRRenderWorker()
+{
+    stop();
+    delete _context;
+    delete _surface;
+}
+
+void QVRRenderWorker::start()
+{
+    _context->moveToThread(this);
+    QThread::start();
+}
+
+void QVRRenderWorker::stop()
+{
+    if (isRunning()) {
+        exitWanted.storeRelease(1);
+        renderingWanted.release();
+        wait();
+    }
+}
+
+void QVRRenderWorker::run()
+{
+    _context->makeCurrent(_surface);
+#ifdef GL_FRAMEBUFFER_SRGB
+    _context->extraFunctions()->glEnable(GL_FRAMEBUFFER_SRGB);
+#endif
+    for (;;) {
+        renderingWanted.acquire();
+        if (exitWanted.loadAcquire())
+            break;
+        _app->render(_window, _window->renderContext(), textures);
+        fence = _context->extraFunctions()->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _context->extraFunctions()->glFlush();
+        renderingFinished.release();
+    }
+    _context->doneCurrent();
+    _context->moveToThread(QCoreApplication::instance()->thread());
+}
+
 QVRManager::QVRManager(int& argc, char* argv[]) :
     _triggerTimer(new QTimer),
     _fpsTimer(new QTimer),
@@ -94,6 +186,9 @@ QVRManager::QVRManager(int& argc, char* argv[]) :
     _syncToVBlank(true),
     _fpsMsecs(0),
     _fpsCounter(0),
+    _recordFilename(),
+    _replayFilename(),
+    _replayRealtime(false),
     _configFilename(),
     _autodetect(),
     _isRelaunchedMain(false),
@@ -111,11 +206,16 @@ QVRManager::QVRManager(int& argc, char* argv[]) :
     _wantExit(false),
     _wandNavigationTimer(NULL),
     _wasdqeTimer(NULL),
+    _recorder(NULL),
+    _replayer(NULL),
+    _predictionLatency(0.0f),
     _initialized(false)
 {
     Q_ASSERT(!QVRManagerInstance); // there can be only one
     QVRManagerInstance = this;
     QVREventQueue = new QQueue<QVREvent>;
+    QVREventContexts = new QVREventContextTable;
+    QVRViewTexturePool = new QVRTexturePool;
     Q_INIT_RESOURCE(qvr);
 
     // set global timeout value (-1 means never timeout)
@@ -209,6 +309,37 @@ QVRManager::QVRManager(int& argc, char* argv[]) :
         }
     }
 
+    // set recording and replay
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--qvr-record") == 0 && i < argc - 1) {
+            _recordFilename = argv[i + 1];
+            removeTwoArgs(argc, argv, i);
+            break;
+        } else if (strncmp(argv[i], "--qvr-record=", 13) == 0) {
+            _recordFilename = argv[i] + 13;
+            removeArg(argc, argv, i);
+            break;
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--qvr-replay") == 0 && i < argc - 1) {
+            _replayFilename = argv[i + 1];
+            removeTwoArgs(argc, argv, i);
+            break;
+        } else if (strncmp(argv[i], "--qvr-replay=", 13) == 0) {
+            _replayFilename = argv[i] + 13;
+            removeArg(argc, argv, i);
+            break;
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--qvr-replay-realtime") == 0) {
+            _replayRealtime = true;
+            removeArg(argc, argv, i);
+            break;
+        }
+    }
+
     // get configuration file name (if any)
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--qvr-config") == 0 && i < argc - 1) {
@@ -295,6 +426,10 @@ QVRManager::~QVRManager()
         delete _devices.at(i);
     for (int i = 0; i < _observers.size(); i++)
         delete _observers.at(i);
+    delete _recorder;
+    delete _replayer;
+    for (int i = 0; i < _renderWorkers.size(); i++)
+        delete _renderWorkers.at(i);
     for (int i = 0; i < _windows.size(); i++)
         delete _windows.at(i);
     for (int i = 0; i < _childProcesses.size(); i++)
@@ -309,6 +444,10 @@ QVRManager::~QVRManager()
     delete _wandNavigationTimer;
     delete QVREventQueue;
     QVREventQueue = NULL;
+    delete QVREventContexts;
+    QVREventContexts = NULL;
+    delete QVRViewTexturePool;
+    QVRViewTexturePool = NULL;
     delete _server;
     delete _client;
     QVRManagerInstance = NULL;
@@ -338,6 +477,9 @@ void QVRManager::buildProcessCommandLine(int processIndex, QString* prg, QString
     if (_syncToVBlankWasSet)
         *args << QString("--qvr-sync-to-vblank=%1").arg(_syncToVBlank ? 1 : 0);
     *args << QString("--qvr-config=%1").arg(_configFilename);
+    // Child processes only need to know that a replay is active; only main reads the file
+    if (processIndex != 0 && !_replayFilename.isEmpty())
+        *args << QString("--qvr-replay=%1").arg(_replayFilename);
     *args << _appArgs;
     if (!processConfig.launcher().isEmpty() && processConfig.launcher() != "manual") {
         QStringList ll = processConfig.launcher().split(' ', Qt::SkipEmptyParts);
@@ -546,6 +688,44 @@ bool QVRManager::init(QVRApp* app, bool preferCustomNavigation)
         }
         _observerTrackingDevices0.append(trackDev0);
         _observerTrackingDevices1.append(trackDev1);
+        _predictionValid.append(false);
+        _predictionSampleTimes.append(0);
+        _predictionSamplePositions.append(QVector3D());
+        _predictionSampleOrientations.append(QQuaternion());
+        _predictionSampleVelocities.append(QVector3D());
+        _predictionSampleAngularVelocities.append(QVector3D());
+        _predictionPositionErrors.append(0.0);
+        _predictionOrientationErrors.append(0.0);
+        _predictionErrorCounts.append(0);
+    }
+    // Late latching changes the pose of an observer after the main process has
+    // sent it to the others, so it is only safe for observers that no other
+    // process renders and whose tracking devices are all owned by this process.
+    for (int o = 0; o < _observers.size(); o++) {
+        int td[2] = { _observerTrackingDevices0[o], _observerTrackingDevices1[o] };
+        bool latch = (processConfig().lateLatching() && td[0] >= 0);
+        bool rendered = false;
+        for (int i = 0; i < 2; i++) {
+            if (td[i] >= 0 && (_devices[td[i]]->config().processIndex() != _processIndex
+                        || _devices[td[i]]->config().trackingType() != QVR_Device_Tracking_VRPN))
+                latch = false;
+        }
+        for (int p = 0; p < _config->processConfigs().size(); p++) {
+            for (int w = 0; w < _config->processConfigs()[p].windowConfigs().size(); w++) {
+                if (windowConfig(p, w).observerIndex() == o) {
+                    if (p == _processIndex)
+                        rendered = true;
+                    else
+                        latch = false;
+                }
+            }
+        }
+        if (processConfig().lateLatching() && td[0] >= 0 && rendered && !latch) {
+            QVR_WARNING("process %s: observer %s is not latched since other processes render it "
+                    "or it is not tracked by VRPN devices of this process",
+                    qPrintable(processConfig().id()), qPrintable(_observers[o]->config().id()));
+        }
+        _observerLatching.append(latch);
     }
     if (_haveWasdqeObservers) {
         _wasdqeTimer = new QElapsedTimer;
@@ -680,6 +860,12 @@ bool QVRManager::init(QVRApp* app, bool preferCustomNavigation)
         QVRWindow* window = new QVRWindow(_mainWindow, observer, w);
         if (!window->isValid())
             return false;
+        int o = windowConfig(_processIndex, w).observerIndex();
+        if (window->_reprojection != QVR_Reprojection_None && _observerTrackingDevices0[o] >= 0) {
+            window->_poseTracker = new QVRPoseTracker(_devices[_observerTrackingDevices0[o]],
+                    _observerTrackingDevices1[o] >= 0 ? _devices[_observerTrackingDevices1[o]] : NULL,
+                    _replayFilename.isEmpty());
+        }
         _windows.append(window);
     }
 
@@ -687,15 +873,61 @@ bool QVRManager::init(QVRApp* app, bool preferCustomNavigation)
     _mainWindow->winContext()->makeCurrent(_mainWindow);
     if (!_app->initProcess(_thisProcess))
         return false;
-    for (int w = 0; w < _windows.size(); w++)
+    for (int w = 0; w < _windows.size(); w++) {
+        if (_app->wantLayeredViews(_windows[w])) {
+            if (_windows[w]->supportsLayeredViews()) {
+                QVR_DEBUG("  window %d uses layered views", w);
+                _windows[w]->_layeredViews = true;
+            } else {
+                QVR_INFO("  window %d: output mode does not support layered views; using separate views", w);
+            }
+        }
         if (!_app->initWindow(_windows[w]))
             return false;
+    }
     _mainWindow->winContext()->doneCurrent();
+
+    // Start render workers if requested
+    if (processConfig().parallelRendering()) {
+        if (!_app->supportsParallelRendering()) {
+            QVR_FATAL("process %s uses parallel rendering, but the application does not support it",
+                    qPrintable(processConfig().id()));
+            return false;
+        }
+        QVR_DEBUG("  starting %lld render workers...", _windows.size());
+        for (int w = 0; w < _windows.size(); w++) {
+            QVRRenderWorker* worker = new QVRRenderWorker(_app, _windows[w], _mainWindow->winContext());
+            _renderWorkers.append(worker);
+            if (!worker->isValid()) {
+                QVR_FATAL("Cannot get a valid OpenGL context for render worker %d", w);
+                return false;
+            }
+            worker->start();
+        }
+    }
     if (_processIndex == 0) {
         updateDevices();
         _app->update(_observers);
     }
 
+    // Initialize recording or replay
+    if (_processIndex == 0 && !_recordFilename.isEmpty() && !_replayFilename.isEmpty()) {
+        QVR_FATAL("cannot record and replay at the same time");
+        return false;
+    }
+    if (_processIndex == 0 && !_recordFilename.isEmpty()) {
+        _recorder = new QVRRecorder;
+        if (!_recorder->open(_recordFilename, _devices.size(), _observers.size()))
+            return false;
+        QVR_INFO("recording to %s", qPrintable(_recordFilename));
+    }
+    if (_processIndex == 0 && !_replayFilename.isEmpty()) {
+        _replayer = new QVRReplayer;
+        if (!_replayer->open(_replayFilename, _replayRealtime, _devices.size(), _observers.size()))
+            return false;
+        QVR_INFO("replaying %s%s", qPrintable(_replayFilename), _replayRealtime ? " in realtime" : "");
+    }
+
     // Initialize FPS printing
     if (_fpsMsecs > 0) {
         connect(_fpsTimer, SIGNAL(timeout()), this, SLOT(printFps()));
@@ -748,136 +980,22 @@ void QVRManager::mainLoop()
         return;
     }
 
-    updateDevices();
-    for (int o = 0; o < _observers.size(); o++) {
-        QVRObserver* obs = _observers[o];
-        QVR_FIREHOSE("  ... updating observer %d", o);
-        if (obs->config().navigationType() == QVR_Navigation_WASDQE) {
-            const float speed = 1.5f; // in meters per second; TODO: make this configurable?
-            float seconds = 0.0f;
-            if (_wasdqeTimer->isValid()) {
-                seconds = _wasdqeTimer->nsecsElapsed() / 1e9f;
-                _wasdqeTimer->restart();
-            } else {
-                _wasdqeTimer->start();
-            }
-            if (_wasdqeIsPressed[0] || _wasdqeIsPressed[1] || _wasdqeIsPressed[2] || _wasdqeIsPressed[3]) {
-                QQuaternion viewerRot = obs->trackingOrientation() * obs->navigationOrientation();
-                QVector3D dir;
-                if (_wasdqeIsPressed[0])
-                    dir = viewerRot * QVector3D(0.0f, 0.0f, -1.0f);
-                else if (_wasdqeIsPressed[1])
-                    dir = viewerRot * QVector3D(-1.0f, 0.0f, 0.0f);
-                else if (_wasdqeIsPressed[2])
-                    dir = viewerRot * QVector3D(0.0f, 0.0f, +1.0f);
-                else if (_wasdqeIsPressed[3])
-                    dir = viewerRot * QVector3D(+1.0f, 0.0f, 0.0f);
-                dir.setY(0.0f);
-                dir.normalize();
-                _wasdqePos += speed * seconds * dir;
-            }
-            if (_wasdqeIsPressed[4]) {
-                _wasdqePos += speed * seconds * QVector3D(0.0f, +1.0f, 0.0f);
-            }
-            if (_wasdqeIsPressed[5]) {
-                _wasdqePos += speed * seconds * QVector3D(0.0f, -1.0f, 0.0f);
-            }
-            obs->setNavigation(_wasdqePos + obs->config().initialNavigationPosition(),
-                    QQuaternion::fromEulerAngles(_wasdqeVertAngle, _wasdqeHorzAngle, 0.0f)
-                    * obs->config().initialNavigationOrientation());
-        }
-        if (obs->config().navigationType() == QVR_Navigation_Device) {
-            const QVRDevice* dev = _devices.at(_observerNavigationDevices[o]);
-            const bool haveTwoAxes = (dev->hasAnalog(QVR_Analog_Axis_X) && dev->hasAnalog(QVR_Analog_Axis_Y));
-            const bool haveFourAxes = (dev->hasAnalog(QVR_Analog_Right_Axis_X) && dev->hasAnalog(QVR_Analog_Right_Axis_Y));
-            const bool haveFourButtons = (dev->hasButton(QVR_Button_Up) && dev->hasButton(QVR_Button_Down)
-                    && dev->hasButton(QVR_Button_Left) && dev->hasButton(QVR_Button_Right));
-            const float speed = 1.5f; // in meters per second; TODO: make this configurable?
-            float seconds = 0.0f;
-            if (_wandNavigationTimer->isValid()) {
-                seconds = _wandNavigationTimer->nsecsElapsed() / 1e9f;
-                _wandNavigationTimer->restart();
-            } else {
-                _wandNavigationTimer->start();
-            }
-            float forwardVal = 0.0f;
-            float sidewaysVal = 0.0f;
-            if (haveFourAxes) {
-                forwardVal = dev->analogValue(QVR_Analog_Right_Axis_Y);
-                sidewaysVal = dev->analogValue(QVR_Analog_Right_Axis_X);
-            } else if (haveTwoAxes) {
-                forwardVal = dev->analogValue(QVR_Analog_Axis_Y);
-                sidewaysVal = dev->analogValue(QVR_Analog_Axis_X);
-            } else if (!haveFourButtons) {
-                forwardVal = (dev->isButtonPressed(0) ? 1.0f : 0.0f);
-            }
-            if (std::abs(forwardVal) > 0.0f || std::abs(sidewaysVal) > 0.0f) {
-                QQuaternion rot = (dev->config().trackingType() == QVR_Device_Tracking_None
-                        ? obs->trackingOrientation() : dev->orientation())
-                    * QQuaternion::fromEulerAngles(0.0f, _wandNavigationRotY, 0.0f);
-                QVector3D forwardDir = rot * QVector3D(0.0f, 0.0f, -1.0f);
-                if (haveFourAxes || haveFourButtons) {
-                    forwardDir.setY(0.0f);
-                    forwardDir.normalize();
-                }
-                QVector3D rightDir = rot * QVector3D(1.0f, 0.0f, 0.0f);
-                if (haveFourAxes || haveFourButtons) {
-                    rightDir.setY(0.0f);
-                    rightDir.normalize();
-                }
-                if (!haveFourAxes && !haveFourButtons) {
-                    seconds = 2.0f / 3.0f;
-                }
-                _wandNavigationPos += speed * seconds * (forwardDir * forwardVal + rightDir * sidewaysVal);
-            }
-            float upVal = 0.0f;
-            float downVal = 0.0f;
-            float rightVal = 0.0f;
-            float leftVal = 0.0f;
-            if (haveFourAxes) {
-                upVal = dev->analogValue(QVR_Analog_Left_Axis_Y);
-                downVal = -dev->analogValue(QVR_Analog_Left_Axis_Y);
-                rightVal = dev->analogValue(QVR_Analog_Left_Axis_X);
-                leftVal = -dev->analogValue(QVR_Analog_Left_Axis_X);
-            } else if (haveFourButtons) {
-                upVal = (dev->isButtonPressed(QVR_Button_Up) ? 1.0f : 0.0f);
-                downVal = (dev->isButtonPressed(QVR_Button_Down) ? 1.0f : 0.0f);
-                rightVal = (dev->isButtonPressed(QVR_Button_Right) ? 1.0f : 0.0f);
-                leftVal = (dev->isButtonPressed(QVR_Button_Left) ? 1.0f : 0.0f);
-            }
-            if (upVal > 0.0f)
-                _wandNavigationPos += speed * seconds * upVal * QVector3D(0.0f, +1.0f, 0.0f);
-            if (downVal > 0.0f)
-                _wandNavigationPos += speed * seconds * downVal * QVector3D(0.0f, -1.0f, 0.0f);
-            if (rightVal > 0.0f) {
-                _wandNavigationRotY -= rightVal;
-                if (_wandNavigationRotY <= 0.0f)
-                    _wandNavigationRotY += 360.0f;
-            }
-            if (leftVal > 0.0f) {
-                _wandNavigationRotY += leftVal;
-                if (_wandNavigationRotY >= 360.0f)
-                    _wandNavigationRotY -= 360.0f;
-            }
-            obs->setNavigation(_wandNavigationPos + obs->config().initialNavigationPosition(),
-                    QQuaternion::fromEulerAngles(0.0f, _wandNavigationRotY, 0.0f) * obs->config().initialNavigationOrientation());
-        }
-        if (obs->config().trackingType() == QVR_Tracking_Device) {
-            int td0 = _observerTrackingDevices0[o];
-            int td1 = _observerTrackingDevices1[o];
-            if (td0 >= 0 && td1 >= 0) {
-                const QVRDevice* dev0 = _devices.at(td0);
-                const QVRDevice* dev1 = _devices.at(td1);
-                obs->setTracking(dev0->position(), dev0->orientation(), dev1->position(), dev1->orientation());
-            } else if (td0 >= 0) {
-                const QVRDevice* dev = _devices.at(td0);
-                obs->setTracking(dev->position(), dev->orientation());
-            }
+    QList<QVREvent> replayedEvents;
+    if (_replayer) {
+        QVR_FIREHOSE("  ... replaying recorded frame");
+        if (!_replayer->readFrame(&_near, &_far, _devices, _observers, &replayedEvents, _app)) {
+            QVR_INFO("replay finished");
+            _wantExit = true;
+            return;
         }
+        _predictionLatencyTimer.start();
+    } else {
+        updateDevices();
+        _predictionLatencyTimer.start();
+        updateObservers();
+        _app->getNearFar(_near, _far);
     }
 
-    _app->getNearFar(_near, _far);
-
     if (_childProcesses.size() > 0) {
         for (int d = 0; d < _devices.size(); d++) {
             _serializationBuffer.resize(0);
@@ -900,6 +1018,7 @@ void QVRManager::mainLoop()
             QVR_FIREHOSE("  ... sending observer %d (%lld bytes) to child processes", o, _serializationBuffer.size());
             _server->sendCmdObserver(_serializationBuffer);
         }
+        updateTiles();
         _serializationBuffer.resize(0);
         QDataStream serializationDataStream(&_serializationBuffer, QIODevice::WriteOnly);
         _app->serializeDynamicData(serializationDataStream);
@@ -914,12 +1033,25 @@ void QVRManager::mainLoop()
     // process events and run application updates while the windows wait for the buffer swap
     QVR_FIREHOSE("  ... event processing");
     QGuiApplication::processEvents();
+    if (_recorder) {
+        QVR_FIREHOSE("  ... recording frame");
+        if (!_recorder->writeFrame(_near, _far, _devices, _observers, *QVREventQueue, _app)) {
+            delete _recorder;
+            _recorder = NULL;
+        }
+    } else if (_replayer) {
+        // Live input is replaced by the recorded events
+        QVREventQueue->clear();
+        for (int e = 0; e < replayedEvents.size(); e++)
+            QVREventQueue->enqueue(replayedEvents[e]);
+    }
     processEventQueue();
     QVR_FIREHOSE("  ... app update");
     _app->update(_observers);
 
     // now wait for windows to finish buffer swap...
     waitForBufferSwaps();
+    _predictionLatency = 0.9f * _predictionLatency + 0.1f * (_predictionLatencyTimer.nsecsElapsed() / 1e9f);
     // ... and for the children to sync
     if (_childProcesses.size() > 0) {
         QVR_FIREHOSE("  ... waiting for children to sync");
@@ -927,7 +1059,7 @@ void QVRManager::mainLoop()
         _server->receiveCmdSync(&childEvents);
         for (int e = 0; e < childEvents.size(); e++) {
             QVR_FIREHOSE("  ... got an event from process %d window %d",
-                    childEvents[e].context.processIndex(), childEvents[e].context.windowIndex());
+                    childEvents[e].processIndex, childEvents[e].windowIndex);
             QVREventQueue->enqueue(childEvents[e]);
         }
     }
@@ -987,19 +1119,23 @@ void QVRManager::childLoop()
             QVRObserver o;
             _client->receiveCmdObserverArgs(&o);
             *(_observers.at(o.index())) = o;
+        } else if (cmd == QVRClientCmdTiles) {
+            QVR_FIREHOSE("  ... got command 'tiles' from main");
+            _client->receiveCmdTilesArgs(&_serializationBuffer);
+            setTiles(_serializationBuffer);
         } else if (cmd == QVRClientCmdRender) {
             QVR_FIREHOSE("  ... got command 'render' from main");
             _client->receiveCmdRenderArgs(&_near, &_far, _app);
+            _predictionLatencyTimer.start();
             render();
+            sendTiles();
             QGuiApplication::processEvents();
-            int n = 0;
             _serializationBuffer.resize(0);
             QDataStream serializationDataStream(&_serializationBuffer, QIODevice::WriteOnly);
-            while (!QVREventQueue->empty()) {
-                serializationDataStream << QVREventQueue->dequeue();
-                n++;
-            }
+            int n = QVRSerializeEvents(serializationDataStream, QVREventQueue, true);
+            QVREventContexts->clear();
             waitForBufferSwaps();
+            _predictionLatency = 0.9f * _predictionLatency + 0.1f * (_predictionLatencyTimer.nsecsElapsed() / 1e9f);
             QVR_FIREHOSE("  ... sending command 'sync' with %d events in %lld bytes to main", n, _serializationBuffer.size());
             _client->sendCmdSync(n, _serializationBuffer);
             _client->flush();
@@ -1022,6 +1158,19 @@ void QVRManager::quit()
 {
     QVR_DEBUG("quitting process %d...", _thisProcess->index());
     _fpsTimer->stop();
+    if (_recorder) {
+        _recorder->close();
+        delete _recorder;
+        _recorder = NULL;
+    }
+    if (_replayer) {
+        _replayer->close();
+        delete _replayer;
+        _replayer = NULL;
+    }
+    for (int w = 0; w < _renderWorkers.size(); w++)
+        delete _renderWorkers[w];
+    _renderWorkers.clear();
     _mainWindow->winContext()->makeCurrent(_mainWindow);
     for (int w = _windows.size() - 1; w >= 0; w--) {
         QVR_DEBUG("... exiting window %d", w);
@@ -1029,6 +1178,9 @@ void QVRManager::quit()
         _windows[w]->exitGL();
         _windows[w]->close();
     }
+    _mainWindow->winContext()->makeCurrent(_mainWindow);
+    QVRViewTexturePool->clear();
+    _mainWindow->winContext()->doneCurrent();
     QVR_DEBUG("... exiting process");
     _app->exitProcess(_thisProcess);
     _mainWindow->close();
@@ -1097,9 +1249,497 @@ void QVRManager::updateDevices()
     }
 }
 
+float QVRManager::predictionHorizon(int o) const
+{
+    float horizon = _observers[o]->config().predictionHorizon();
+    return (horizon < 0.0f ? _predictionLatency : horizon);
+}
+
+static void QVRPredictPose(const QVRDevice* dev, float seconds, QVector3D* pos, QQuaternion* rot)
+{
+    QVRPredictPose(dev->position(), dev->orientation(), dev->velocity(), dev->angularVelocity(), seconds, pos, rot);
+}
+
+void QVRManager::updateObservers()
+{
+    Q_ASSERT(_processIndex == 0);
+
+    for (int o = 0; o < _observers.size(); o++) {
+        QVRObserver* obs = _observers[o];
+        QVR_FIREHOSE("  ... updating observer %d", o);
+        if (obs->config().navigationType() == QVR_Navigation_WASDQE) {
+            const float speed = 1.5f; // in meters per second; TODO: make this configurable?
+            float seconds = 0.0f;
+            if (_wasdqeTimer->isValid()) {
+                seconds = _wasdqeTimer->nsecsElapsed() / 1e9f;
+                _wasdqeTimer->restart();
+            } else {
+                _wasdqeTimer->start();
+            }
+            if (_wasdqeIsPressed[0] || _wasdqeIsPressed[1] || _wasdqeIsPressed[2] || _wasdqeIsPressed[3]) {
+                QQuaternion viewerRot = obs->trackingOrientation() * obs->navigationOrientation();
+                QVector3D dir;
+                if (_wasdqeIsPressed[0])
+                    dir = viewerRot * QVector3D(0.0f, 0.0f, -1.0f);
+                else if (_wasdqeIsPressed[1])
+                    dir = viewerRot * QVector3D(-1.0f, 0.0f, 0.0f);
+                else if (_wasdqeIsPressed[2])
+                    dir = viewerRot * QVector3D(0.0f, 0.0f, +1.0f);
+                else if (_wasdqeIsPressed[3])
+                    dir = viewerRot * QVector3D(+1.0f, 0.0f, 0.0f);
+                dir.setY(0.0f);
+                dir.normalize();
+                _wasdqePos += speed * seconds * dir;
+            }
+            if (_wasdqeIsPressed[4]) {
+                _wasdqePos += speed * seconds * QVector3D(0.0f, +1.0f, 0.0f);
+            }
+            if (_wasdqeIsPressed[5]) {
+                _wasdqePos += speed * seconds * QVector3D(0.0f, -1.0f, 0.0f);
+            }
+            obs->setNavigation(_wasdqePos + obs->config().initialNavigationPosition(),
+                    QQuaternion::fromEulerAngles(_wasdqeVertAngle, _wasdqeHorzAngle, 0.0f)
+                    * obs->config().initialNavigationOrientation());
+        }
+        if (obs->config().navigationType() == QVR_Navigation_Device) {
+            const QVRDevice* dev = _devices.at(_observerNavigationDevices[o]);
+            const bool haveTwoAxes = (dev->hasAnalog(QVR_Analog_Axis_X) && dev->hasAnalog(QVR_Analog_Axis_Y));
+            const bool haveFourAxes = (dev->hasAnalog(QVR_Analog_Right_Axis_X) && dev->hasAnalog(QVR_Analog_Right_Axis_Y));
+            const bool haveFourButtons = (dev->hasButton(QVR_Button_Up) && dev->hasButton(QVR_Button_Down)
+                    && dev->hasButton(QVR_Button_Left) && dev->hasButton(QVR_Button_Right));
+            const float speed = 1.5f; // in meters per second; TODO: make this configurable?
+            float seconds = 0.0f;
+            if (_wandNavigationTimer->isValid()) {
+                seconds = _wandNavigationTimer->nsecsElapsed() / 1e9f;
+                _wandNavigationTimer->restart();
+            } else {
+                _wandNavigationTimer->start();
+            }
+            float forwardVal = 0.0f;
+            float sidewaysVal = 0.0f;
+            if (haveFourAxes) {
+                forwardVal = dev->analogValue(QVR_Analog_Right_Axis_Y);
+                sidewaysVal = dev->analogValue(QVR_Analog_Right_Axis_X);
+            } else if (haveTwoAxes) {
+                forwardVal = dev->analogValue(QVR_Analog_Axis_Y);
+                sidewaysVal = dev->analogValue(QVR_Analog_Axis_X);
+            } else if (!haveFourButtons) {
+                forwardVal = (dev->isButtonPressed(0) ? 1.0f : 0.0f);
+            }
+            if (std::abs(forwardVal) > 0.0f || std::abs(sidewaysVal) > 0.0f) {
+                QQuaternion rot = (dev->config().trackingType() == QVR_Device_Tracking_None
+                        ? obs->trackingOrientation() : dev->orientation())
+                    * QQuaternion::fromEulerAngles(0.0f, _wandNavigationRotY, 0.0f);
+                QVector3D forwardDir = rot * QVector3D(0.0f, 0.0f, -1.0f);
+                if (haveFourAxes || haveFourButtons) {
+                    forwardDir.setY(0.0f);
+                    forwardDir.normalize();
+                }
+                QVector3D rightDir = rot * QVector3D(1.0f, 0.0f, 0.0f);
+                if (haveFourAxes || haveFourButtons) {
+                    rightDir.setY(0.0f);
+                    rightDir.normalize();
+                }
+                if (!haveFourAxes && !haveFourButtons) {
+                    seconds = 2.0f / 3.0f;
+                }
+                _wandNavigationPos += speed * seconds * (forwardDir * forwardVal + rightDir * sidewaysVal);
+            }
+            float upVal = 0.0f;
+            float downVal = 0.0f;
+            float rightVal = 0.0f;
+            float leftVal = 0.0f;
+            if (haveFourAxes) {
+                upVal = dev->analogValue(QVR_Analog_Left_Axis_Y);
+                downVal = -dev->analogValue(QVR_Analog_Left_Axis_Y);
+                rightVal = dev->analogValue(QVR_Analog_Left_Axis_X);
+                leftVal = -dev->analogValue(QVR_Analog_Left_Axis_X);
+            } else if (haveFourButtons) {
+                upVal = (dev->isButtonPressed(QVR_Button_Up) ? 1.0f : 0.0f);
+                downVal = (dev->isButtonPressed(QVR_Button_Down) ? 1.0f : 0.0f);
+                rightVal = (dev->isButtonPressed(QVR_Button_Right) ? 1.0f : 0.0f);
+                leftVal = (dev->isButtonPressed(QVR_Button_Left) ? 1.0f : 0.0f);
+            }
+            if (upVal > 0.0f)
+                _wandNavigationPos += speed * seconds * upVal * QVector3D(0.0f, +1.0f, 0.0f);
+            if (downVal > 0.0f)
+                _wandNavigationPos += speed * seconds * downVal * QVector3D(0.0f, -1.0f, 0.0f);
+            if (rightVal > 0.0f) {
+                _wandNavigationRotY -= rightVal;
+                if (_wandNavigationRotY <= 0.0f)
+                    _wandNavigationRotY += 360.0f;
+            }
+            if (leftVal > 0.0f) {
+                _wandNavigationRotY += leftVal;
+                if (_wandNavigationRotY >= 360.0f)
+                    _wandNavigationRotY -= 360.0f;
+            }
+            obs->setNavigation(_wandNavigationPos + obs->config().initialNavigationPosition(),
+                    QQuaternion::fromEulerAngles(0.0f, _wandNavigationRotY, 0.0f) * obs->config().initialNavigationOrientation());
+        }
+        updateObserverTracking(o, true);
+    }
+}
+
+void QVRManager::updateObserverTracking(int o, bool measurePrediction)
+{
+    QVRObserver* obs = _observers[o];
+    if (obs->config().trackingType() == QVR_Tracking_Device) {
+        int td0 = _observerTrackingDevices0[o];
+        int td1 = _observerTrackingDevices1[o];
+        float horizon = (obs->config().predictionHorizon() != 0.0f ? predictionHorizon(o) : 0.0f);
+        if (td0 >= 0 && td1 >= 0) {
+            const QVRDevice* dev0 = _devices.at(td0);
+            const QVRDevice* dev1 = _devices.at(td1);
+            QVector3D pos0, pos1;
+            QQuaternion rot0, rot1;
+            QVRPredictPose(dev0, horizon, &pos0, &rot0);
+            QVRPredictPose(dev1, horizon, &pos1, &rot1);
+            obs->setTracking(pos0, rot0, pos1, rot1);
+        } else if (td0 >= 0) {
+            const QVRDevice* dev = _devices.at(td0);
+            QVector3D pos;
+            QQuaternion rot;
+            QVRPredictPose(dev, horizon, &pos, &rot);
+            obs->setTracking(pos, rot);
+        }
+        if (measurePrediction && obs->config().predictionHorizon() != 0.0f && td0 >= 0) {
+            // Measure the prediction error: extrapolate the previous sample of the
+            // tracking device(s) to the time of the new sample with the same model
+            // that is used for the observer, and compare with the new sample.
+            // Two devices are combined into their mean pose and mean velocities.
+            // Devices are updated every frame, but trackers may not have delivered
+            // a new sample since the last one; such frames are not measured.
+            QVector3D pos, vel, angVel;
+            QQuaternion rot;
+            if (td1 >= 0) {
+                pos = 0.5f * (_devices[td0]->position() + _devices[td1]->position());
+                rot = QQuaternion::slerp(_devices[td0]->orientation(), _devices[td1]->orientation(), 0.5f);
+                vel = 0.5f * (_devices[td0]->velocity() + _devices[td1]->velocity());
+                angVel = 0.5f * (_devices[td0]->angularVelocity() + _devices[td1]->angularVelocity());
+            } else {
+                pos = _devices[td0]->position();
+                rot = _devices[td0]->orientation();
+                vel = _devices[td0]->velocity();
+                angVel = _devices[td0]->angularVelocity();
+            }
+            if (_predictionValid[o]
+                    && pos == _predictionSamplePositions[o]
+                    && rot == _predictionSampleOrientations[o]) {
+                return;
+            }
+            qint64 sampleTime = QVRTimer.nsecsElapsed();
+            if (_predictionValid[o]) {
+                float seconds = (sampleTime - _predictionSampleTimes[o]) / 1e9f;
+                QVector3D predictedPos;
+                QQuaternion predictedRot;
+                QVRPredictPose(_predictionSamplePositions[o], _predictionSampleOrientations[o],
+                        _predictionSampleVelocities[o], _predictionSampleAngularVelocities[o],
+                        seconds, &predictedPos, &predictedRot);
+                QQuaternion diff = predictedRot.conjugated() * rot;
+                float angle = 2.0f * std::acos(qMin(1.0f, std::abs(diff.normalized().scalar())));
+                _predictionPositionErrors[o] += (pos - predictedPos).length();
+                _predictionOrientationErrors[o] += qRadiansToDegrees(angle);
+                _predictionErrorCounts[o]++;
+            }
+            _predictionSampleTimes[o] = sampleTime;
+            _predictionSamplePositions[o] = pos;
+            _predictionSampleOrientations[o] = rot;
+            _predictionSampleVelocities[o] = vel;
+            _predictionSampleAngularVelocities[o] = angVel;
+            _predictionValid[o] = true;
+        }
+    }
+}
+
+void QVRManager::latchTracking()
+{
+    // Only VRPN devices are re-read here: Oculus and OpenVR poses are
+    // updated by their runtimes once per frame and are already predicted.
+    // See init() for the observers that may be latched.
+    for (int o = 0; o < _observers.size(); o++) {
+        if (!_observerLatching[o])
+            continue;
+        _devices[_observerTrackingDevices0[o]]->latchPose();
+        if (_observerTrackingDevices1[o] >= 0)
+            _devices[_observerTrackingDevices1[o]]->latchPose();
+        updateObserverTracking(o, false);
+    }
+}
+
+int QVRManager::computeProcessCullingPlanes(QVector4D* planes) const
+{
+    /* The union of the view frusta is not convex, so we bound it conservatively:
+     * every plane of every view frustum is a candidate direction, and each
+     * candidate is moved outwards until all frustum corners of all views lie
+     * on its inner side. For the two eyes of a stereo window this results in
+     * a volume that is only slightly larger than the union.
+     * This runs every frame, so it works on fixed-size storage only. Candidates
+     * beyond maxProcessCullingPlanes are dropped; a subset of the planes still
+     * bounds a conservative volume. */
+    int planeCount = 0;
+    for (int w = 0; w < _windows.size(); w++) {
+        const QVRRenderContext& renderContext = _windows[w]->renderContext();
+        for (int i = 0; i < renderContext.viewCount(); i++) {
+            QVector4D viewPlanes[6];
+            renderContext.getCullingPlanes(i, viewPlanes);
+            for (int p = 0; p < 6 && planeCount < QVRRenderContext::maxProcessCullingPlanes; p++) {
+                QVector3D n = viewPlanes[p].toVector3D();
+                if (n.isNull())
+                    continue;
+                bool isDuplicate = false;
+                for (int j = 0; !isDuplicate && j < planeCount; j++)
+                    isDuplicate = (QVector3D::dotProduct(n, planes[j].toVector3D()) > 1.0f - 1e-6f);
+                if (!isDuplicate)
+                    planes[planeCount++] = QVector4D(n, 0.0f);
+            }
+        }
+    }
+    float minDist[QVRRenderContext::maxProcessCullingPlanes];
+    bool haveCorners = false;
+    for (int w = 0; w < _windows.size(); w++) {
+        const QVRRenderContext& renderContext = _windows[w]->renderContext();
+        for (int i = 0; i < renderContext.viewCount(); i++) {
+            bool invertible;
+            QMatrix4x4 inv = (renderContext.frustum(i).toMatrix4x4() * renderContext.viewMatrix(i)).inverted(&invertible);
+            if (!invertible)
+                continue;
+            for (int c = 0; c < 8; c++) {
+                QVector4D p = inv * QVector4D(c & 1 ? +1.0f : -1.0f, c & 2 ? +1.0f : -1.0f, c & 4 ? +1.0f : -1.0f, 1.0f);
+                QVector3D corner = p.toVector3D() / p.w();
+                for (int j = 0; j < planeCount; j++) {
+                    float dist = QVector3D::dotProduct(planes[j].toVector3D(), corner);
+                    minDist[j] = (haveCorners ? qMin(minDist[j], dist) : dist);
+                }
+                haveCorners = true;
+            }
+        }
+    }
+    if (!haveCorners)
+        return 0;
+    for (int j = 0; j < planeCount; j++) {
+        // a little slack compensates for rounding errors in the corner computation
+        planes[j].setW(-minDist[j] + 1e-5f * (1.0f + qAbs(minDist[j])));
+    }
+    return planeCount;
+}
+
+void QVRManager::updateTiles()
+{
+    Q_ASSERT(_processIndex == 0);
+
+    // Assign the tiles of all tiled windows for the next frame and send the
+    // assignments, together with the screen walls, to the helper processes.
+    int tiledWindows = 0;
+    for (int w = 0; w < _windows.size(); w++)
+        if (_windows[w]->_tileBalancer)
+            tiledWindows++;
+    if (tiledWindows == 0)
+        return;
+    _serializationBuffer.resize(0);
+    QDataStream serializationDataStream(&_serializationBuffer, QIODevice::WriteOnly);
+    serializationDataStream << tiledWindows;
+    for (int w = 0; w < _windows.size(); w++) {
+        QVRWindow* window = _windows[w];
+        if (!window->_tileBalancer)
+            continue;
+        window->_tileFullSize = QSize(
+                window->width() * window->devicePixelRatio() * window->config().renderResolutionFactor(),
+                window->height() * window->devicePixelRatio() * window->config().renderResolutionFactor());
+        if (window->isSortLast()) {
+            // All processes render the whole window
+            window->_tileBounds.clear();
+            window->_tileX0 = 0;
+            window->_tileX1 = window->_tileFullSize.width();
+        } else {
+            window->_tileBalancer->getBounds(window->_tileFullSize.width(), window->_tileBounds);
+            window->_tileX0 = window->_tileBounds[0];
+            window->_tileX1 = window->_tileBounds[1];
+        }
+        window->screenWall(window->_tileWall[0], window->_tileWall[1], window->_tileWall[2]);
+        serializationDataStream << w << window->_tileFullSize
+            << window->_tileWall[0] << window->_tileWall[1] << window->_tileWall[2]
+            << window->_tileBounds;
+    }
+    QVR_FIREHOSE("  ... sending tiles of %d windows (%lld bytes) to child processes", tiledWindows, _serializationBuffer.size());
+    _server->sendCmdTiles(_serializationBuffer);
+}
+
+void QVRManager::setTiles(const QByteArray& serializedTiles)
+{
+    QDataStream ds(serializedTiles);
+    int tiledWindows;
+    ds >> tiledWindows;
+    for (int i = 0; i < tiledWindows; i++) {
+        int ownerIndex;
+        QSize fullSize;
+        QVector3D wall[3];
+        QVector<int> bounds;
+        ds >> ownerIndex >> fullSize >> wall[0] >> wall[1] >> wall[2] >> bounds;
+        for (int w = 0; w < _windows.size(); w++) {
+            QVRWindow* window = _windows[w];
+            if (window->isTileProxy() && window->config().tileOwnerIndex() == ownerIndex) {
+                int k = window->config().tileIndex();
+                window->_tileFullSize = fullSize;
+                window->_tileX0 = (window->isSortLast() ? 0 : bounds.value(k));
+                window->_tileX1 = (window->isSortLast() ? fullSize.width() : bounds.value(k + 1));
+                for (int j = 0; j < 3; j++)
+                    window->_tileWall[j] = wall[j];
+            }
+        }
+    }
+}
+
+void QVRManager::sendTiles()
+{
+    // Tile proxies send their tile in every frame in which the tiled window
+    // renders, even if the tile is empty, so that the main process knows what
+    // to expect.
+    bool sentTiles = false;
+    for (int w = 0; w < _windows.size(); w++) {
+        if (!_windows[w]->isTileProxy() || !_windows[w]->isRenderFrame())
+            continue;
+        _windows[w]->readTile(&_serializationBuffer);
+        QVR_FIREHOSE("  ... sending tile of window %d (%lld bytes) to main", w, _serializationBuffer.size());
+        _client->sendTile(_serializationBuffer);
+        sentTiles = true;
+    }
+    if (sentTiles)
+        _client->flush();
+}
+
+void QVRManager::finishTile(QVRWindow* window, qint64 renderStart)
+{
+    // Nothing waits for the GPU here. Proxies start the readback of their tile
+    // and wait for it only when sending it, in readTile(). The render time of
+    // the tile of the main process is measured in compositeTiles().
+    window->_tileRenderStart = renderStart;
+    if (window->isProxy()) {
+        // Proxies are never presented, so nobody else needs their fence.
+        void*& fence = window->_renderFences[window->_renderSet];
+        _mainWindow->_gl->glDeleteSync(static_cast<GLsync>(fence));
+        fence = NULL;
+        window->startTileReadback();
+    }
+}
+
+void QVRManager::compositeTiles()
+{
+    Q_ASSERT(_processIndex == 0);
+
+    for (int w = 0; w < _windows.size(); w++) {
+        QVRWindow* window = _windows[w];
+        if (!window->_tileBalancer || !window->isRenderFrame())
+            continue;
+        const QStringList& tileProcessIds = window->config().tileProcessIds();
+        QVector<QByteArray> tileData(tileProcessIds.size());
+        // Our own tile is finished when its render fence is first seen
+        // signaled while receiving the other tiles. The fence is only polled;
+        // if the GPU is still busy afterwards, the time so far is a lower
+        // bound, which still moves the tile boundaries in the right direction.
+        void*& fence = window->_renderFences[window->_renderSet];
+        bool measuring = (window->_isRendered && !window->isSortLast() && fence);
+        for (int k = 0; k < tileProcessIds.size(); k++) {
+            if (measuring && _mainWindow->_gl->glClientWaitSync(static_cast<GLsync>(fence),
+                        GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED) {
+                window->_tileRenderTime = (QVRTimer.nsecsElapsed() - window->_tileRenderStart) / 1e9f;
+                measuring = false;
+            }
+            int p = 1;
+            while (_config->processConfigs()[p].id() != tileProcessIds[k])
+                p++;
+            QVR_FIREHOSE("  ... receiving tile %d of window %d from process %d", k + 1, w, p);
+            _server->receiveTile(p, &(tileData[k]));
+        }
+        if (measuring)
+            window->_tileRenderTime = (QVRTimer.nsecsElapsed() - window->_tileRenderStart) / 1e9f;
+        if (!window->_isRendered)
+            continue;
+        QVR_FIREHOSE("  ... compositing tiles of window %d", w);
+        window->compositeTiles(tileData);
+        // The window thread must wait for the composited textures
+        if (fence)
+            _mainWindow->_gl->glDeleteSync(static_cast<GLsync>(fence));
+        fence = _mainWindow->_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void QVRManager::sendStreamInfo()
+{
+    Q_ASSERT(processConfig().displayOnly());
+
+    // Tell the main process the render sizes and screen walls of our windows,
+    // so that it renders the next frame for them. The observer transformation
+    // is applied by the main process, since it knows the newest observer state.
+    _serializationBuffer.resize(0);
+    QDataStream serializationDataStream(&_serializationBuffer, QIODevice::WriteOnly);
+    serializationDataStream << int(_windows.size());
+    for (int w = 0; w < _windows.size(); w++) {
+        QVRWindow* window = _windows[w];
+        QSize size(
+                window->width() * window->devicePixelRatio() * window->config().renderResolutionFactor(),
+                window->height() * window->devicePixelRatio() * window->config().renderResolutionFactor());
+        QVector3D wall[3];
+        window->screenWall(wall[0], wall[1], wall[2], false);
+        serializationDataStream << size << wall[0] << wall[1] << wall[2];
+    }
+    QVR_FIREHOSE("  ... sending stream info (%lld bytes) to main", _serializationBuffer.size());
+    _client->sendStreamInfo(_serializationBuffer);
+    _client->flush();
+}
+
+void QVRManager::streamFrames()
+{
+    Q_ASSERT(_processIndex == 0);
+
+    // Stream sources send a frame in every frame in which the display-only
+    // window renders, even if they did not render, so that the display-only
+    // process knows what to expect. The frames go out in the order of the
+    // display-only windows.
+    bool sentFrames = false;
+    for (int w = 0; w < _windows.size(); w++) {
+        QVRWindow* window = _windows[w];
+        if (!window->isStreamSource() || !window->isRenderFrame())
+            continue;
+        window->readTile(&_serializationBuffer);
+        QVR_FIREHOSE("  ... streaming window %d (%lld bytes) to process %d",
+                w, _serializationBuffer.size(), window->config().streamProcessIndex());
+        _server->sendStreamFrame(window->config().streamProcessIndex(), _serializationBuffer);
+        sentFrames = true;
+    }
+    if (sentFrames)
+        _server->flush();
+    // Get the window sizes and screen walls for the next frame; every
+    // display-only process sends them in each frame
+    for (int p = 1; p < _config->processConfigs().size(); p++) {
+        if (!_config->processConfigs()[p].displayOnly())
+            continue;
+        _server->receiveStreamInfo(p, &_serializationBuffer);
+        QDataStream ds(_serializationBuffer);
+        int windowCount;
+        ds >> windowCount;
+        for (int i = 0; i < windowCount; i++) {
+            QSize size;
+            QVector3D wall[3];
+            ds >> size >> wall[0] >> wall[1] >> wall[2];
+            for (int w = 0; w < _windows.size(); w++) {
+                QVRWindow* window = _windows[w];
+                if (window->config().streamProcessIndex() == p && window->config().streamWindowIndex() == i) {
+                    window->_tileFullSize = size;
+                    window->_tileX0 = 0;
+                    window->_tileX1 = size.width();
+                    for (int j = 0; j < 3; j++)
+                        window->_tileWall[j] = wall[j];
+                }
+            }
+        }
+    }
+}
+
 void QVRManager::render()
 {
     QVR_FIREHOSE("  render() ...");
+    QVRFrameCounter++;
 
     _mainWindow->winContext()->makeCurrent(_mainWindow);
 #ifdef GL_FRAMEBUFFER_SRGB
@@ -1108,6 +1748,11 @@ void QVRManager::render()
 
     QVR_FIREHOSE("  ... preRenderProcess()");
     _app->preRenderProcess(_thisProcess);
+    // During replay, the recorded poses must not be replaced by live tracking
+    if (processConfig().lateLatching() && _replayFilename.isEmpty()) {
+        QVR_FIREHOSE("  ... late latching of tracking poses");
+        latchTracking();
+    }
     // determine global 2D screens, if available
     constexpr float tolerance = 1e-5f;
     QRectF unitedScreenRect;
@@ -1161,9 +1806,30 @@ void QVRManager::render()
             intersectedScreenTopLeft = QVector3D(intersectedScreenRect.bottomLeft().x(), intersectedScreenRect.bottomLeft().y(), screenCommonZ);
         }
     }
+    // determine a conservative culling volume for all views of this process
+    QVector4D processCullingPlanes[QVRRenderContext::maxProcessCullingPlanes];
+    int processCullingPlaneCount = computeProcessCullingPlanes(processCullingPlanes);
     for (int w = 0; w < _windows.size(); w++) {
         _windows[w]->renderContext().setUnitedScreenWall(unitedScreenBottomLeft, unitedScreenBottomRight, unitedScreenTopLeft);
         _windows[w]->renderContext().setIntersectedScreenWall(intersectedScreenBottomLeft, intersectedScreenBottomRight, intersectedScreenTopLeft);
+        _windows[w]->renderContext().setProcessCullingPlanes(processCullingPlanes, processCullingPlaneCount);
+    }
+    QVR_FIREHOSE("  ... updateProcessVisibleSet()");
+    _app->updateProcessVisibleSet(_thisProcess, processCullingPlanes, processCullingPlaneCount);
+    if (processConfig().displayOnly())
+        sendStreamInfo();
+    // determine the screen areas of sort-last tiles
+    bool haveSortLastWindows = false;
+    for (int w = 0; w < _windows.size(); w++)
+        if (_windows[w]->isSortLast())
+            haveSortLastWindows = true;
+    if (haveSortLastWindows) {
+        QVector3D partitionMin, partitionMax;
+        QVR_FIREHOSE("  ... getPartitionBounds()");
+        bool havePartitionBounds = _app->getPartitionBounds(_thisProcess, partitionMin, partitionMax);
+        for (int w = 0; w < _windows.size(); w++)
+            if (_windows[w]->isSortLast())
+                _windows[w]->updateTileRect(havePartitionBounds, partitionMin, partitionMax);
     }
     // render
     for (int w = 0; w < _windows.size(); w++) {
@@ -1177,11 +1843,28 @@ void QVRManager::render()
                 _windows[w]->unsetCursor();
             }
         }
+        _windows[w]->_isRendered = _windows[w]->wantsRendering();
+        if (!_windows[w]->_isRendered) {
+            QVR_FIREHOSE("  ... skipping window %d in this frame", w);
+            continue;
+        }
+        if (_windows[w]->isStreamTarget()) {
+            // The main process rendered this window for us
+            unsigned int streamTextures[2];
+            _windows[w]->getTextures(streamTextures);
+            QVR_FIREHOSE("  ... receiving streamed frame of window %d", w);
+            _client->receiveStreamFrame(&_serializationBuffer);
+            _windows[w]->_isRendered = _windows[w]->setStreamFrame(_serializationBuffer);
+            if (_windows[w]->_isRendered)
+                _windows[w]->_renderFences[_windows[w]->_renderSet] = _mainWindow->_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            continue;
+        }
         QVR_FIREHOSE("  ... preRenderWindow(%d)", w);
         _app->preRenderWindow(_windows[w]);
         QVR_FIREHOSE("  ... render(%d)", w);
         const QVRRenderContext& renderContext = _windows[w]->renderContext();
-        unsigned int textures[2];
+        unsigned int localTextures[2];
+        unsigned int* textures = (_renderWorkers.isEmpty() ? localTextures : _renderWorkers[w]->textures);
         _windows[w]->getTextures(textures);
         for (int i = 0; i < renderContext.viewCount(); i++) {
             QVR_FIREHOSE("  ... view %d frustum: l=%g r=%g b=%g t=%g n=%g f=%g", i,
@@ -1201,22 +1884,72 @@ void QVRManager::render()
                     renderContext.viewMatrix(i)(3, 0), renderContext.viewMatrix(i)(3, 1),
                     renderContext.viewMatrix(i)(3, 2), renderContext.viewMatrix(i)(3, 3));
         }
+        if (!_renderWorkers.isEmpty())
+            continue;
+        qint64 tileRenderStart = QVRTimer.nsecsElapsed();
         _app->render(_windows[w], renderContext, textures);
         QVR_FIREHOSE("  ... postRenderWindow(%d)", w);
         _app->postRenderWindow(_windows[w]);
+        /* The window thread must not use the textures before they actually
+         * contain the current scene, otherwise artefacts are displayed. Each
+         * window thread waits for its own fence, so that it can present while
+         * the GPU still renders the views of the following windows. */
+        if (_windows[w]->config().outputMode() != QVR_Output_GoogleVR)
+            _windows[w]->_renderFences[_windows[w]->_renderSet] = _mainWindow->_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (_windows[w]->isTiled())
+            finishTile(_windows[w], tileRenderStart);
+    }
+    if (!_renderWorkers.isEmpty()) {
+        // Texture (re)allocations by getTextures() must reach the workers
+        _mainWindow->_gl->glFlush();
+        qint64 tileRenderStart = QVRTimer.nsecsElapsed();
+        for (int w = 0; w < _windows.size(); w++) {
+            if (_windows[w]->_isRendered)
+                _renderWorkers[w]->renderingWanted.release();
+        }
+        // Barrier: all windows must be rendered before presentation
+        for (int w = 0; w < _windows.size(); w++) {
+            if (!_windows[w]->_isRendered)
+                continue;
+            _renderWorkers[w]->renderingFinished.acquire();
+            GLsync workerFence = static_cast<GLsync>(_renderWorkers[w]->fence);
+            _mainWindow->_gl->glWaitSync(workerFence, 0, GL_TIMEOUT_IGNORED);
+            _mainWindow->_gl->glDeleteSync(workerFence);
+            _renderWorkers[w]->fence = NULL;
+            QVR_FIREHOSE("  ... postRenderWindow(%d)", w);
+            _app->postRenderWindow(_windows[w]);
+            if (_windows[w]->config().outputMode() != QVR_Output_GoogleVR)
+                _windows[w]->_renderFences[_windows[w]->_renderSet] = _mainWindow->_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            if (_windows[w]->isTiled())
+                finishTile(_windows[w], tileRenderStart);
+        }
+    }
+    if (_processIndex == 0) {
+        compositeTiles();
+        streamFrames();
     }
     QVR_FIREHOSE("  ... postRenderProcess()");
     _app->postRenderProcess(_thisProcess);
-    /* At this point, we must make sure that all textures actually contain
-     * the current scene, otherwise artefacts are displayed when the window
-     * threads render them. It seems that glFlush() is not enough for all
-     * OpenGL implementations; to be safe, we use glFinish(). */
-    _mainWindow->_gl->glFinish();
+    /* Make sure the fences are submitted so that the window threads' waits
+     * can complete. Google VR renders on a separate thread without fences,
+     * so it still needs glFinish(). */
+    bool haveGoogleVRWindow = false;
+    for (int w = 0; w < _windows.size(); w++)
+        if (_windows[w]->config().outputMode() == QVR_Output_GoogleVR)
+            haveGoogleVRWindow = true;
+    if (haveGoogleVRWindow)
+        _mainWindow->_gl->glFinish();
+    else
+        _mainWindow->_gl->glFlush();
     for (int w = 0; w < _windows.size(); w++) {
+        if (!_windows[w]->_isRendered || _windows[w]->isProxy())
+            continue;
         QVR_FIREHOSE("  ... renderToScreen(%d)", w);
         _windows[w]->renderToScreen();
     }
     for (int w = 0; w < _windows.size(); w++) {
+        if (!_windows[w]->_isRendered || _windows[w]->isProxy())
+            continue;
         QVR_FIREHOSE("  ... asyncSwapBuffers(%d)", w);
         _windows[w]->asyncSwapBuffers();
     }
@@ -1227,6 +1960,8 @@ void QVRManager::waitForBufferSwaps()
 {
     // wait for windows to finish the buffer swap
     for (int w = 0; w < _windows.size(); w++) {
+        if (!_windows[w]->_isRendered || _windows[w]->isProxy())
+            continue;
         QVR_FIREHOSE("  ... waiting for buffer swap %d...", w);
         _windows[w]->waitForSwapBuffers();
         QVR_FIREHOSE("  ... buffer swap %d done.", w);
@@ -1239,15 +1974,27 @@ void QVRManager::printFps()
         QVR_FATAL("fps %.1f", _fpsCounter / (_fpsMsecs / 1000.0f));
         _fpsCounter = 0;
     }
+    for (int o = 0; o < _observers.size(); o++) {
+        if (_predictionErrorCounts[o] > 0) {
+            QVR_FATAL("observer %s: prediction horizon %.1f ms, mean error at next sample %.1f mm, %.2f degrees",
+                    qPrintable(_observers[o]->id()), predictionHorizon(o) * 1000.0f,
+                    _predictionPositionErrors[o] / _predictionErrorCounts[o] * 1000.0,
+                    _predictionOrientationErrors[o] / _predictionErrorCounts[o]);
+            _predictionPositionErrors[o] = 0.0;
+            _predictionOrientationErrors[o] = 0.0;
+            _predictionErrorCounts[o] = 0;
+        }
+    }
 }
 
 void QVRManager::processEventQueue()
 {
+    QVRCoalesceEvents(QVREventQueue);
     while (!QVREventQueue->empty()) {
         QVREvent e = QVREventQueue->front();
         QVREventQueue->dequeue();
-        if (_haveWasdqeObservers
-                && observerConfig(windowConfig(e.context.processIndex(), e.context.windowIndex())
+        if (_haveWasdqeObservers && e.processIndex >= 0
+                && observerConfig(windowConfig(e.processIndex, e.windowIndex)
                     .observerIndex()).navigationType() == QVR_Navigation_WASDQE) {
             bool consumed = false;
             if (e.type == QVR_Event_KeyPress) {
@@ -1314,27 +2061,27 @@ void QVRManager::processEventQueue()
                     break;
                 }
             } else if (e.type == QVR_Event_MousePress) {
-                _wasdqeMouseProcessIndex = e.context.processIndex();
-                _wasdqeMouseWindowIndex = e.context.windowIndex();
+                _wasdqeMouseProcessIndex = e.processIndex;
+                _wasdqeMouseWindowIndex = e.windowIndex;
                 _wasdqeMouseInitialized = false;
                 consumed = true;
             } else if (e.type == QVR_Event_MouseMove) {
                 if (_wasdqeMouseInitialized
-                        && _wasdqeMouseProcessIndex == e.context.processIndex()
-                        && _wasdqeMouseWindowIndex == e.context.windowIndex()) {
+                        && _wasdqeMouseProcessIndex == e.processIndex
+                        && _wasdqeMouseWindowIndex == e.windowIndex) {
                     // Horizontal angle
                     float x = e.mouseEventPosition.x();
-                    float w = e.context.windowGeometry().width();
+                    float w = e.context().windowGeometry().width();
                     float xf = x / w * 2.0f - 1.0f;
                     _wasdqeHorzAngle = -xf * 180.0f;
                     // Vertical angle
                     // For HMDs, up/down views are realized via head movements. Additional
                     // mouse-based up/down views should be disabled since they lead to
                     // sickness fast ;)
-                    if (windowConfig(e.context.processIndex(), e.context.windowIndex()).outputMode()
+                    if (windowConfig(e.processIndex, e.windowIndex).outputMode()
                             != QVR_Output_Oculus) {
                         float y = e.mouseEventPosition.y();
-                        float h = e.context.windowGeometry().height();
+                        float h = e.context().windowGeometry().height();
                         float yf = y / h * 2.0f - 1.0f;
                         _wasdqeVertAngle = -yf * 90.0f;
                     }
@@ -1349,49 +2096,49 @@ void QVRManager::processEventQueue()
         case QVR_Event_KeyPress:
             {
                 QKeyEvent* keyEvent = e.createKeyEvent();
-                _app->keyPressEvent(e.context, keyEvent);
+                _app->keyPressEvent(e.context(), keyEvent);
                 delete keyEvent;
             }
             break;
         case QVR_Event_KeyRelease:
             {
                 QKeyEvent* keyEvent = e.createKeyEvent();
-                _app->keyReleaseEvent(e.context, keyEvent);
+                _app->keyReleaseEvent(e.context(), keyEvent);
                 delete keyEvent;
             }
             break;
         case QVR_Event_MouseMove:
             {
                 QMouseEvent* mouseEvent = e.createMouseEvent();
-                _app->mouseMoveEvent(e.context, mouseEvent);
+                _app->mouseMoveEvent(e.context(), mouseEvent);
                 delete mouseEvent;
             }
             break;
         case QVR_Event_MousePress:
             {
                 QMouseEvent* mouseEvent = e.createMouseEvent();
-                _app->mousePressEvent(e.context, mouseEvent);
+                _app->mousePressEvent(e.context(), mouseEvent);
                 delete mouseEvent;
             }
             break;
         case QVR_Event_MouseRelease:
             {
                 QMouseEvent* mouseEvent = e.createMouseEvent();
-                _app->mouseReleaseEvent(e.context, mouseEvent);
+                _app->mouseReleaseEvent(e.context(), mouseEvent);
                 delete mouseEvent;
             }
             break;
         case QVR_Event_MouseDoubleClick:
             {
                 QMouseEvent* mouseEvent = e.createMouseEvent();
-                _app->mouseDoubleClickEvent(e.context, mouseEvent);
+                _app->mouseDoubleClickEvent(e.context(), mouseEvent);
                 delete mouseEvent;
             }
             break;
         case QVR_Event_Wheel:
             {
                 QWheelEvent* wheelEvent = e.createWheelEvent();
-                _app->wheelEvent(e.context, wheelEvent);
+                _app->wheelEvent(e.context(), wheelEvent);
                 delete wheelEvent;
             }
             break;
@@ -1406,6 +2153,7 @@ void QVRManager::processEventQueue()
             break;
         }
     }
+    QVREventContexts->clear();
 }
 
 QVRManager* QVRManager::instance()
@@ -1499,3 +2247,23 @@ const QImage& QVRManager::deviceModelTexture(int textureIndex)
 {
     return QVRDeviceModelTextures.at(textureIndex);
 }
+
+qint64 QVRManager::viewTextureMemory()
+{
+    return QVRViewTexturePool->inUseBytes() + QVRViewTexturePool->idleBytes();
+}
+
+qint64 QVRManager::idleViewTextureMemory()
+{
+    return QVRViewTexturePool->idleBytes();
+}
+
+int QVRManager::viewTextureAllocations()
+{
+    return QVRViewTexturePool->allocations();
+}
+
+int QVRManager::viewTextureReuses()
+{
+    return QVRViewTexturePool->reuses();
+}
@@ -92,12 +92,14 @@
  * Device definition (see \a QVRDevice and \a QVRDeviceConfig):
  * - `device <id>`<br>
  *   Start a new device definition with the given unique id.
- * - `tracking <none|static|oculus|openvr|vprn>`<br>
+ * - `tracking <none|static|oculus|openvr|vprn|synthetic>`<br>
  *   Use the specified tracking method for this device. Default: `none`.
- * - `buttons <none|static|gamepad|vprn|oculus|openvr>`<br>
+ * - `buttons <none|static|gamepad|vprn|oculus|openvr|synthetic>`<br>
  *   Use the specified method to query digital buttons for this device. Default: `none`.
- * - `analogs <none|static|gamepad|vrpn|oculus|openvr>`<br>
+ * - `analogs <none|static|gamepad|vrpn|oculus|openvr|synthetic>`<br>
  *   Use the specified method to query analog joystick elements for this device. Default: `none`.
+ *   The `synthetic` tracking, buttons, and analogs methods generate scripted input without any
+ *   hardware; they are intended for load testing with many devices.
  *
  * Observer definition (see \a QVRObserver and \a QVRObserverConfig):
  * - `observer <id>`<br>
@@ -120,6 +122,10 @@
  *   Set the initial tracking forward (or viewing) direction. Default: `0 0 -1`.
  * - `tracking_up <x> <y> <z>`<br>
  *   Set the initial tracking up direction. Default: `0 1 0`.
+ * - `prediction <off|auto|seconds>`<br>
+ *   Extrapolate device-based tracking poses by the given time, or by the automatically measured
+ *   latency between tracking and buffer swap. The mean error of the prediction from one tracking
+ *   sample to the next is reported together with the frame rate (see `--qvr-fps`). Default: `off`.
  *
  * Process definition (see \a QVRProcess and \a QVRProcessConfig):
  * - `process <id>`<br>
@@ -136,14 +142,37 @@
  *   Whether windows of this process are synchronized with the vertical refresh of the display. Default: `true`.
  * - `decoupled_rendering <true|false>`<br>
  *   Whether the rendering of this child process is decoupled from the main process. Default: `false`.
+ *   A decoupled process without devices starts each new frame with the newest state of the main process
+ *   as soon as it has finished its previous frame.
+ * - `late_latching <true|false>`<br>
+ *   Whether this process re-reads the poses of the VRPN tracking devices it owns right before rendering,
+ *   and updates the observers tracked by them. Default: `false`.
+ *   Only observers that no other process renders are latched, so that all windows agree on their poses.
+ * - `single_presentation_thread <true|false>`<br>
+ *   Whether a single thread with a single OpenGL context presents all windows of this process,
+ *   instead of one thread and context per window. Windows with output modes `stereo`, `oculus`,
+ *   `openvr`, and `googlevr` always get their own thread. Default: `false`.
+ * - `parallel_rendering <true|false>`<br>
+ *   Whether the windows of this process are rendered in parallel by one worker thread per window.
+ *   \a QVRApp::render() is then called concurrently for different windows; see there for details.
+ *   Requires an application that implements \a QVRApp::supportsParallelRendering().
+ *   Default: `false`.
+ * - `display_only <true|false>`<br>
+ *   Whether this child process only presents its windows, while the main process renders them
+ *   and streams the images to it. The main process gets a hidden window named like each window
+ *   of this process followed by `-stream`. Useful for display computers with weak GPUs.
+ *   Display-only processes must not use decoupled or parallel rendering. Default: `false`.
  *
  * Window definition (see \a QVRWindow and \a QVRWindowConfig):
  * - `window <id>`<br>
  *   Start a new window definition with the given unique id, within the current process definition.
  * - `observer <id>`<br>
  *   Set the observer that this window provides a view for.
- * - `output <center|left|right|stereo|red_cyan|green_magenta|amber_blue|oculus|openvr|googlevr>`<br>
- *   Set the output mode. For center, left, right, and stereo, you can set an additional output plugin. Default: `center`.
+ * - `output <center|left|right|stereo|red_cyan|green_magenta|amber_blue|oculus|openvr|googlevr|offscreen>`<br>
+ *   Set the output mode. For center, left, right, stereo, and offscreen, you can set an additional output plugin.
+ *   An offscreen window is never shown; it renders a monoscopic view at its configured size and keeps
+ *   the output in a framebuffer object, so that it works on nodes without displays (for example with
+ *   `QT_QPA_PLATFORM=offscreen` and a software OpenGL implementation). Default: `center`.
  * - `display_screen <screen>`<br>
  *   Select the Qt screen index on the Qt display that this process is connected to. Default: `-1` (which means the default screen).
  * - `fullscreen <true|false>`
@@ -165,6 +194,51 @@
  *   right corner, and top left corner. Default: `0 0 0 0 0 0 0 0 0`.
  * - `render_resolution_factor <factor>`<br>
  *   Set the render resolution factor. Default: `1.0`.
+ * - `texture_buffers <1|2|3>`<br>
+ *   Set the number of view texture sets of this window. With more than one set,
+ *   the application renders the next frame while the window thread still presents
+ *   the previous one, and the window always presents the newest completed frame.
+ *   Not supported for `oculus`, `openvr`, and `googlevr` windows. Default: `1`.
+ * - `render_divisor <k>`<br>
+ *   Render into this window only every k-th frame. Default: `1`.
+ * - `present_latest <true|false>`<br>
+ *   Whether the window swaps buffers independently at the rate of its own display,
+ *   always presenting the newest frame that the application completed. This implies
+ *   at least two texture buffers. Not supported for `oculus`, `openvr`, and `googlevr`
+ *   windows. Default: `false`.
+ * - `reprojection <none|rotation|depth>`<br>
+ *   Whether frames that the window presents again because the application has not
+ *   completed a new one are warped to the newest observer pose, either assuming a far
+ *   away scene or based on the depth that the application renders into
+ *   \a QVRWindow::depthTexture(). Implies `present_latest true`. Not supported for
+ *   `oculus`, `openvr`, `googlevr`, and `offscreen` windows and for output plugins.
+ *   Default: `none`.
+ * - `temporal_upscaling <true|false>`<br>
+ *   Whether the window accumulates jittered frames rendered at the render resolution
+ *   into an image at the output resolution. The application must render depth into
+ *   \a QVRWindow::depthTexture(). Not supported for `oculus`, `openvr`, and `googlevr`
+ *   windows, output plugins, tiled windows, and display-only processes. Default: `false`.
+ * - `capture <none|output|views>`<br>
+ *   Capture the final output of the window, or the view textures, to files. Frames are
+ *   read back asynchronously and dropped rather than delaying rendering. Capturing the
+ *   output is not supported for `oculus` and `googlevr` windows. Default: `none`.
+ * - `capture_format <png|y4m>`<br>
+ *   Write captured frames as PNG image sequences or as raw Y4M videos. Default: `png`.
+ * - `capture_prefix <prefix>`<br>
+ *   Prefix of the capture file names. Default: `qvr-capture-` followed by the window id.
+ * - `tile_processes <process-id> [<process-id> ...]`<br>
+ *   Split this window of the main process into vertical tiles that are rendered
+ *   by the main process and the given child processes, and composited by the main
+ *   process. Tile widths are load-balanced based on the render times of the previous
+ *   frame. Each given process gets a hidden tile proxy window with the id of this
+ *   window followed by `-tile1`, `-tile2`, and so on. The given processes must not
+ *   use decoupled rendering. Not supported for `oculus`, `openvr`, and `googlevr`
+ *   windows and for output plugins. Default: none.
+ * - `tile_compositing <columns|depth>`<br>
+ *   How the tiles of a window with `tile_processes` are composited: sort-first,
+ *   with each process rendering a column of the window, or sort-last, with each
+ *   process rendering its data partition into the whole window and depth-based
+ *   compositing of the results. See \a QVRApp::getPartitionBounds(). Default: `columns`.
  *
  * \section Implementation
  *
@@ -178,7 +252,10 @@
  * window. The windows themselves render in separate rendering threads. On buffer
  * swap, only these rendering threads block. The main thread fills the waiting
  * time with CPU work such as processing events and calling the \a QVRApp::update()
- * function of the application.
+ * function of the application. Windows that are not exposed, and windows whose
+ * render divisor excludes the current frame, are skipped entirely: the application
+ * functions \a QVRApp::preRenderWindow(), \a QVRApp::render(), and
+ * \a QVRApp::postRenderWindow() are not called for them.
  *
  * The process initially started by the user is the main process. \a QVRManager
  * launch child processes as required by the configuration file, and it will
@@ -188,6 +265,8 @@
 
 #include <QObject>
 #include <QVector3D>
+#include <QVector4D>
+#include <QVector>
 #include <QByteArray>
 
 template <typename T> class QList;
@@ -207,6 +286,9 @@ class QVRProcess;
 class QVRRenderContext;
 class QVRServer;
 class QVRClient;
+class QVRRenderWorker;
+class QVRRecorder;
+class QVRReplayer;
 
 /*!
  * \brief Level of logging of the QVR framework
@@ -267,6 +349,9 @@ private:
     bool _syncToVBlank;
     unsigned int _fpsMsecs;
     unsigned int _fpsCounter;
+    QString _recordFilename;
+    QString _replayFilename;
+    bool _replayRealtime;
     QString _configFilename;
     QString _mainName;
     QVRConfig::Autodetect _autodetect;
@@ -284,8 +369,10 @@ private:
     QList<int> _observerNavigationDevices;
     QList<int> _observerTrackingDevices0;
     QList<int> _observerTrackingDevices1;
+    QList<bool> _observerLatching; // whether this process latches the observer; see init()
     QVRWindow* _mainWindow;
     QList<QVRWindow*> _windows;
+    QList<QVRRenderWorker*> _renderWorkers; // one per window, only with parallel rendering
     QVRProcess* _thisProcess;
     QList<QVRProcess*> _childProcesses;
     float _near, _far;
@@ -302,6 +389,19 @@ private:
     QVector3D _wasdqePos;         // WASDQE observers: position
     float _wasdqeHorzAngle;       // WASDQE observers: angle around the y axis
     float _wasdqeVertAngle;       // WASDQE observers: angle around the x axis
+    QVRRecorder* _recorder;       // only on the main process, with --qvr-record
+    QVRReplayer* _replayer;       // only on the main process, with --qvr-replay
+    float _predictionLatency;                   // Pose prediction: measured latency from tracking to buffer swap
+    QElapsedTimer _predictionLatencyTimer;      // Pose prediction: started when tracking is sampled
+    QList<bool> _predictionValid;               // Pose prediction: do we have a previous sample for an observer?
+    QList<qint64> _predictionSampleTimes;       // Pose prediction: time of the previous tracking sample
+    QList<QVector3D> _predictionSamplePositions;        // Pose prediction: previous sampled tracking device position
+    QList<QQuaternion> _predictionSampleOrientations;   // Pose prediction: previous sampled tracking device orientation
+    QList<QVector3D> _predictionSampleVelocities;       // Pose prediction: previous sampled tracking device velocity
+    QList<QVector3D> _predictionSampleAngularVelocities;// Pose prediction: previous sampled tracking device angular velocity
+    QList<double> _predictionPositionErrors;    // Pose prediction: sum of position errors since last report
+    QList<double> _predictionOrientationErrors; // Pose prediction: sum of orientation errors since last report
+    QList<int> _predictionErrorCounts;          // Pose prediction: number of errors since last report
     bool _initialized;
 
     void buildProcessCommandLine(int processIndex, QString* prg, QStringList* args);
@@ -309,6 +409,18 @@ private:
     void processEventQueue();
 
     void updateDevices();
+    float predictionHorizon(int observerIndex) const;
+    void updateObservers();
+    void updateObserverTracking(int observerIndex, bool measurePrediction);
+    void latchTracking();
+    int computeProcessCullingPlanes(QVector4D* planes) const;
+    void updateTiles();
+    void setTiles(const QByteArray& serializedTiles);
+    void sendTiles();
+    void finishTile(QVRWindow* window, qint64 renderStart);
+    void compositeTiles();
+    void sendStreamInfo();
+    void streamFrames();
     void render();
     void waitForBufferSwaps();
     void quit();
@@ -351,6 +463,16 @@ public:
      *   'gamepads' for gamepads. Each entry can be preceded with '~' to negate it. For example,
      *   use '\-\-qvr-autodetect=all,~oculus' to try autodetection for all hardware except Oculus Rift.
      *   This option only takes effect if no \-\-qvr-config option was given.
+     * - \-\-qvr-record=\<filename\><br>
+     *   Record the input of each frame of the main process (device states, observer poses,
+     *   events, near and far values, and the dynamic application data) to the given file.
+     * - \-\-qvr-replay=\<filename\><br>
+     *   Drive the main process from a recording instead of live input, as fast as possible.
+     *   Live input events are ignored, and the application quits at the end of the recording.
+     *   This requires the same configuration that was used for recording.
+     *   Late latching of tracking poses is disabled during replay.
+     * - \-\-qvr-replay-realtime<br>
+     *   Replay the recording at the recorded speed instead of as fast as possible.
      */
     QVRManager(int& argc, char* argv[]);
 
@@ -541,6 +663,27 @@ public:
     static const QImage& deviceModelTexture(int textureIndex);
 
     /*@}*/
+
+    /**
+     * \name GPU memory statistics
+     *
+     * The view textures of all windows of a process come from a common pool. Textures
+     * that are no longer needed, e.g. after a window was resized, are kept for reuse
+     * by later requests of the same size, as long as they hold at most twice the memory
+     * of the textures in use.
+     */
+    /*@{*/
+
+    /*! \brief Return the number of bytes of GPU memory held by the view textures of this process, including idle ones. */
+    static qint64 viewTextureMemory();
+    /*! \brief Return the number of bytes of GPU memory held by idle view textures that are kept for reuse. */
+    static qint64 idleViewTextureMemory();
+    /*! \brief Return the number of view texture allocations so far. */
+    static int viewTextureAllocations();
+    /*! \brief Return the number of view texture requests that were served by reusing an idle texture. */
+    static int viewTextureReuses();
+
+    /*@}*/
 };
 
 #endif
@@ -23,6 +23,20 @@
 
 uniform sampler2D tex_l;
 uniform sampler2D tex_r;
+// used instead of tex_l and tex_r for layered views:
+uniform lowp sampler2DArray tex_layers;
+uniform bool layered;
+uniform int layer_l;
+uniform int layer_r;
+
+// reprojection of the views to a newer pose:
+uniform int reprojection; // same values as QVRReprojection enum
+uniform highp mat4 reproj_rot_l;  // new to old NDC, for points at infinity
+uniform highp mat4 reproj_rot_r;
+uniform highp mat4 reproj_full_l; // old to new NDC
+uniform highp mat4 reproj_full_r;
+uniform highp sampler2D depth_l;
+uniform highp sampler2D depth_r;
 
 uniform int output_mode;
 // same values as QVROutputMode enum:
@@ -33,6 +47,9 @@ uniform int output_mode;
 #define QVR_Output_Red_Cyan 4
 #define QVR_Output_Green_Magenta 5
 #define QVR_Output_Amber_Blue 6
+#define QVR_Reprojection_None 0
+#define QVR_Reprojection_Rotation 1
+#define QVR_Reprojection_Depth 2
 
 smooth in vec2 vtexcoord;
 
@@ -66,6 +83,53 @@ const lowp mat3 dubois_amber_blue_m1 = mat3(
         -0.123, 0.062, 0.185,
         -0.017, -0.017, 0.911);
 
+// Find the texture coordinates in a view that was rendered for an older pose.
+// A negative result means that the point was not visible in the old view.
+highp vec2 reproject(highp mat4 rot, highp mat4 full, highp sampler2D depth_tex)
+{
+    if (reprojection == QVR_Reprojection_None)
+        return vtexcoord;
+    highp vec2 ndc = 2.0 * vtexcoord - 1.0;
+    highp vec4 p = rot * vec4(ndc, 1.0, 1.0);
+    if (p.w <= 0.0)
+        return vec2(-1.0);
+    highp vec2 s = p.xy / p.w;
+    if (reprojection == QVR_Reprojection_Depth) {
+        // Move the point found at s into the new view and correct s by
+        // the parallax error. One step suffices for small pose changes.
+        highp float d = texture(depth_tex, 0.5 * s + 0.5).r;
+        highp vec4 q = full * vec4(s, 2.0 * d - 1.0, 1.0);
+        if (q.w > 0.0)
+            s -= q.xy / q.w - ndc;
+    }
+    highp vec2 tc = 0.5 * s + 0.5;
+    if (any(lessThan(tc, vec2(0.0))) || any(greaterThan(tc, vec2(1.0))))
+        return vec2(-1.0);
+    return tc;
+}
+
+lowp vec3 view_l()
+{
+    highp vec2 tc = reproject(reproj_rot_l, reproj_full_l, depth_l);
+    if (tc.x < 0.0)
+        return vec3(0.0);
+    if (layered)
+        return texture(tex_layers, vec3(tc, float(layer_l))).rgb;
+    else
+        return texture(tex_l, tc).rgb;
+}
+
+lowp vec3 view_r()
+{
+    highp vec2 tc = reproject(reproj_rot_r, reproj_full_r, depth_r);
+    if (tc.x < 0.0)
+        return vec3(0.0);
+    if (layered)
+        return texture(tex_layers, vec3(tc, float(layer_r))).rgb;
+    else
+        return texture(tex_r, tc).rgb;
+}
+
 void main(void)
 {
     lowp vec3 l, r;
@@ -74,8 +138,8 @@ void main(void)
     case QVR_Output_Red_Cyan:
     case QVR_Output_Green_Magenta:
     case QVR_Output_Amber_Blue:
-        l = texture(tex_l, vtexcoord).rgb;
-        r = texture(tex_r, vtexcoord).rgb;
+        l = view_l();
+        r = view_r();
         if (output_mode == QVR_Output_Red_Cyan)
             color = dubois_red_cyan_m0 * l + dubois_red_cyan_m1 * r;
         else if (output_mode == QVR_Output_Green_Magenta)
@@ -84,7 +148,7 @@ void main(void)
             color = dubois_amber_blue_m0 * l + dubois_amber_blue_m1 * r;
         break;
     default:
-        color = texture(tex_l, vtexcoord).rgb;
+        color = view_l();
         break;
     }
     fcolor = vec4(color, 1.0);
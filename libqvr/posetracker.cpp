@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <QtMath>
+#include <QStringList>
+
+#include "posetracker.hpp"
+#include "device.hpp"
+#include "internalglobals.hpp"
+
+#ifdef HAVE_VRPN
+# include <vrpn_Tracker.h>
+#endif
+
+
+void QVRPredictPose(const QVector3D& position, const QQuaternion& orientation,
+        const QVector3D& velocity, const QVector3D& angularVelocity,
+        float seconds, QVector3D* pos, QQuaternion* rot)
+{
+    *pos = position + seconds * velocity;
+    *rot = orientation;
+    float angle = seconds * angularVelocity.length();
+    if (angle > 0.0f)
+        *rot = QQuaternion::fromAxisAndAngle(angularVelocity.normalized(), qRadiansToDegrees(angle)) * (*rot);
+}
+
+QVRPoseSample::QVRPoseSample(const QVRDevice* dev0, const QVRDevice* dev1) :
+    valid(true),
+    timestamp(QVRTimer.nsecsElapsed())
+{
+    if (dev1) {
+        position = 0.5f * (dev0->position() + dev1->position());
+        orientation = QQuaternion::slerp(dev0->orientation(), dev1->orientation(), 0.5f);
+        velocity = 0.5f * (dev0->velocity() + dev1->velocity());
+        angularVelocity = 0.5f * (dev0->angularVelocity() + dev1->angularVelocity());
+    } else {
+        position = dev0->position();
+        orientation = dev0->orientation();
+        velocity = dev0->velocity();
+        angularVelocity = dev0->angularVelocity();
+    }
+}
+
+#ifdef HAVE_VRPN
+static void QVRPoseTrackerChangeHandler(void* userdata, const vrpn_TRACKERCB info)
+{
+    QVRPoseSample* s = reinterpret_cast<QVRPoseSample*>(userdata);
+    s->valid = true;
+    s->timestamp = QVRTimer.nsecsElapsed();
+    s->position = QVector3D(info.pos[0], info.pos[1], info.pos[2]);
+    s->orientation = QQuaternion(info.quat[3], info.quat[0], info.quat[1], info.quat[2]);
+}
+#endif
+
+QVRPoseTracker::QVRPoseTracker(const QVRDevice* dev0, const QVRDevice* dev1, bool liveTracking) :
+    _devices { dev0, dev1 },
+    _trackers { NULL, NULL }
+{
+#ifdef HAVE_VRPN
+    for (int i = 0; liveTracking && i < 2 && _devices[i]; i++) {
+        if (_devices[i]->config().trackingType() != QVR_Device_Tracking_VRPN)
+            continue;
+        QStringList args = _devices[i]->config().trackingParameters().split(' ', Qt::SkipEmptyParts);
+        QString name = (args.length() >= 1 ? args[0] : _devices[i]->config().trackingParameters());
+        int sensor = (args.length() >= 2 ? args[1].toInt() : vrpn_ALL_SENSORS);
+        // A connection of our own: VRPN connections must only be used by one
+        // thread, and the one that QVRDevice shares belongs to the main thread.
+        vrpn_Connection* connection = vrpn_get_connection_by_name(qPrintable(name),
+                NULL, NULL, NULL, NULL, NULL, true);
+        vrpn_Tracker_Remote* tracker = new vrpn_Tracker_Remote(qPrintable(name), connection);
+        connection->removeReference();
+        tracker->register_change_handler(&(_trackerSamples[i]), QVRPoseTrackerChangeHandler, sensor);
+        _trackers[i] = tracker;
+    }
+#endif
+}
+
+QVRPoseTracker::~QVRPoseTracker()
+{
+#ifdef HAVE_VRPN
+    for (int i = 0; i < 2; i++)
+        delete static_cast<vrpn_Tracker_Remote*>(_trackers[i]);
+#endif
+}
+
+void QVRPoseTracker::currentPose(const QVRPoseSample& frameSample, QVector3D* pos, QQuaternion* rot)
+{
+    // Use the trackers if all of them have reported after the frame sample was taken
+    int trackerCount = (_devices[1] ? 2 : 1);
+    bool haveTrackerPose = true;
+    for (int i = 0; i < trackerCount; i++) {
+#ifdef HAVE_VRPN
+        if (_trackers[i])
+            static_cast<vrpn_Tracker_Remote*>(_trackers[i])->mainloop();
+#endif
+        if (!_trackers[i] || !_trackerSamples[i].valid || _trackerSamples[i].timestamp < frameSample.timestamp)
+            haveTrackerPose = false;
+    }
+    if (haveTrackerPose) {
+        if (trackerCount == 2) {
+            *pos = 0.5f * (_trackerSamples[0].position + _trackerSamples[1].position);
+            *rot = QQuaternion::slerp(_trackerSamples[0].orientation, _trackerSamples[1].orientation, 0.5f);
+        } else {
+            *pos = _trackerSamples[0].position;
+            *rot = _trackerSamples[0].orientation;
+        }
+    } else {
+        float seconds = (QVRTimer.nsecsElapsed() - frameSample.timestamp) / 1e9f;
+        QVRPredictPose(frameSample.position, frameSample.orientation,
+                frameSample.velocity, frameSample.angularVelocity, seconds, pos, rot);
+    }
+}
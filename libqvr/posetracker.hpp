@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef QVR_POSETRACKER_HPP
+#define QVR_POSETRACKER_HPP
+
+#include <QVector3D>
+#include <QQuaternion>
+
+class QVRDevice;
+
+
+/* Extrapolate a pose with constant linear and angular velocity. */
+void QVRPredictPose(const QVector3D& position, const QQuaternion& orientation,
+        const QVector3D& velocity, const QVector3D& angularVelocity,
+        float seconds, QVector3D* pos, QQuaternion* rot);
+
+/* A pose of the tracking device(s) of an observer, with velocities, taken
+ * at a QVRTimer timestamp. Two devices are combined into their mean pose. */
+class QVRPoseSample
+{
+public:
+    bool valid;
+    qint64 timestamp;
+    QVector3D position;
+    QQuaternion orientation;
+    QVector3D velocity;
+    QVector3D angularVelocity;
+
+    QVRPoseSample() : valid(false), timestamp(0) {}
+    QVRPoseSample(const QVRDevice* dev0, const QVRDevice* dev1);
+};
+
+/* Fresh tracking poses for the reprojection in a window thread (see
+ * QVRWindowConfig::reprojection()).
+ *
+ * The main thread only updates tracking once per frame, and not at all while
+ * the application renders, so the window thread cannot wait for it. Instead,
+ * it polls VRPN trackers on connections of its own right before presenting.
+ * For other devices, and until a VRPN tracker has reported, it extrapolates
+ * the sample that the main thread took for the presented frame to the present
+ * time. The constructor, the destructor, and updateFrameSample() must be called
+ * from the main thread, and currentPose() only from the window thread. The frame
+ * sample is shared, so updateFrameSample() and frameSample() must be protected
+ * by the same mutex as the render context that the sample belongs to.
+ * These interfaces are only used internally and never exposed to applications. */
+
+class QVRPoseTracker
+{
+private:
+    const QVRDevice* _devices[2];   // the tracking devices; the second one is optional
+    QVRPoseSample _frameSample;     // sample of the devices for the newest render context
+    void* _trackers[2];             // vrpn_Tracker_Remote, NULL if unavailable
+    QVRPoseSample _trackerSamples[2]; // newest poses reported by them
+
+public:
+    // Without live tracking (e.g. during replay), poses are always extrapolated.
+    QVRPoseTracker(const QVRDevice* dev0, const QVRDevice* dev1, bool liveTracking);
+    ~QVRPoseTracker();
+
+    // Sample the devices for a new render context.
+    void updateFrameSample() { _frameSample = QVRPoseSample(_devices[0], _devices[1]); }
+    // Return the sample of the newest render context.
+    const QVRPoseSample& frameSample() const { return _frameSample; }
+    // Return the newest pose of the tracking devices. The given sample is the
+    // one that belongs to the render context of the presented frame.
+    void currentPose(const QVRPoseSample& frameSample, QVector3D* pos, QQuaternion* rot);
+};
+
+#endif
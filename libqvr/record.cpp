@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <QDataStream>
+#include <QThread>
+
+#include "record.hpp"
+#include "app.hpp"
+#include "device.hpp"
+#include "observer.hpp"
+#include "event.hpp"
+#include "logging.hpp"
+
+
+static const quint32 QVRRecordMagic = 0x51565252; // "QVRR"
+static const quint32 QVRRecordVersion = 2;
+static const qint64 QVRRecordHeaderSize = 16;
+
+QVRRecorder::QVRRecorder()
+{
+}
+
+bool QVRRecorder::open(const QString& filename, int deviceCount, int observerCount)
+{
+    _file.setFileName(filename);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QVR_FATAL("cannot open recording file %s: %s", qPrintable(filename), qPrintable(_file.errorString()));
+        return false;
+    }
+    QDataStream fs(&_file);
+    fs << QVRRecordMagic << QVRRecordVersion
+        << static_cast<qint32>(deviceCount) << static_cast<qint32>(observerCount);
+    if (fs.status() != QDataStream::Ok) {
+        QVR_FATAL("cannot write recording file %s", qPrintable(filename));
+        return false;
+    }
+    return true;
+}
+
+bool QVRRecorder::writeFrame(float n, float f,
+        const QList<QVRDevice*>& devices,
+        const QList<QVRObserver*>& observers,
+        const QQueue<QVREvent>& events,
+        QVRApp* app)
+{
+    if (!_timer.isValid())
+        _timer.start();
+
+    _frame.resize(0);
+    QDataStream ds(&_frame, QIODevice::WriteOnly);
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    ds << static_cast<qint64>(_timer.nsecsElapsed()) << n << f;
+    for (int d = 0; d < devices.size(); d++)
+        ds << *(devices[d]);
+    for (int o = 0; o < observers.size(); o++)
+        ds << *(observers[o]);
+    QQueue<QVREvent> eventQueue = events;
+    QByteArray eventData;
+    QDataStream eventStream(&eventData, QIODevice::WriteOnly);
+    eventStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    // Record every event: a replay must deliver exactly what the application saw
+    int eventCount = QVRSerializeEvents(eventStream, &eventQueue, false);
+    ds << eventCount << eventData;
+    // The application data uses a default stream, as for inter-process communication
+    QByteArray dynamicData;
+    QDataStream dynamicStream(&dynamicData, QIODevice::WriteOnly);
+    app->serializeDynamicData(dynamicStream);
+    ds << dynamicData;
+
+    QDataStream fs(&_file);
+    fs << static_cast<quint32>(_frame.size());
+    fs.writeRawData(_frame.constData(), _frame.size());
+    if (fs.status() != QDataStream::Ok) {
+        QVR_WARNING("cannot write to recording file %s", qPrintable(_file.fileName()));
+        return false;
+    }
+    return true;
+}
+
+void QVRRecorder::close()
+{
+    if (_file.isOpen())
+        _file.close();
+}
+
+QVRReplayer::QVRReplayer() :
+    _data(NULL), _size(0), _pos(0), _realtime(false)
+{
+}
+
+bool QVRReplayer::open(const QString& filename, bool realtime, int deviceCount, int observerCount)
+{
+    _file.setFileName(filename);
+    if (!_file.open(QIODevice::ReadOnly)) {
+        QVR_FATAL("cannot open recording file %s: %s", qPrintable(filename), qPrintable(_file.errorString()));
+        return false;
+    }
+    _size = _file.size();
+    if (_size < QVRRecordHeaderSize) {
+        QVR_FATAL("recording file %s is invalid", qPrintable(filename));
+        return false;
+    }
+    _data = _file.map(0, _size);
+    if (!_data) {
+        QVR_FATAL("cannot map recording file %s: %s", qPrintable(filename), qPrintable(_file.errorString()));
+        return false;
+    }
+    QByteArray header = QByteArray::fromRawData(reinterpret_cast<const char*>(_data), QVRRecordHeaderSize);
+    QDataStream hs(header);
+    quint32 magic, version;
+    qint32 recordedDeviceCount, recordedObserverCount;
+    hs >> magic >> version >> recordedDeviceCount >> recordedObserverCount;
+    if (magic != QVRRecordMagic || version != QVRRecordVersion) {
+        QVR_FATAL("recording file %s is invalid", qPrintable(filename));
+        return false;
+    }
+    if (recordedDeviceCount != deviceCount || recordedObserverCount != observerCount) {
+        QVR_FATAL("recording file %s does not match the configuration (%d devices and %d observers recorded)",
+                qPrintable(filename), recordedDeviceCount, recordedObserverCount);
+        return false;
+    }
+    _pos = QVRRecordHeaderSize;
+    _realtime = realtime;
+    return true;
+}
+
+bool QVRReplayer::readFrame(float* n, float* f,
+        QList<QVRDevice*>& devices,
+        QList<QVRObserver*>& observers,
+        QList<QVREvent>* events,
+        QVRApp* app)
+{
+    if (_pos + 4 > _size)
+        return false;
+    quint32 frameSize;
+    QByteArray sizeData = QByteArray::fromRawData(reinterpret_cast<const char*>(_data + _pos), 4);
+    QDataStream(sizeData) >> frameSize;
+    _pos += 4;
+    if (_pos + frameSize > _size) {
+        QVR_WARNING("recording file %s is truncated", qPrintable(_file.fileName()));
+        return false;
+    }
+    QByteArray frame = QByteArray::fromRawData(reinterpret_cast<const char*>(_data + _pos), frameSize);
+    _pos += frameSize;
+
+    QDataStream ds(frame);
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    qint64 timestamp;
+    ds >> timestamp >> *n >> *f;
+    if (_realtime) {
+        if (!_timer.isValid()) {
+            _timer.start();
+        } else {
+            qint64 wait = timestamp - _timer.nsecsElapsed();
+            if (wait > 0)
+                QThread::usleep(wait / 1000);
+        }
+    }
+    for (int d = 0; d < devices.size(); d++) {
+        QVRDevice device;
+        ds >> device;
+        *(devices[d]) = device;
+    }
+    for (int o = 0; o < observers.size(); o++) {
+        QVRObserver observer;
+        ds >> observer;
+        *(observers[o]) = observer;
+    }
+    int eventCount;
+    QByteArray eventData;
+    ds >> eventCount >> eventData;
+    QDataStream eventStream(eventData);
+    eventStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    QVRDeserializeEvents(eventStream, eventCount, events);
+    QByteArray dynamicData;
+    ds >> dynamicData;
+    QDataStream dynamicStream(dynamicData);
+    app->deserializeDynamicData(dynamicStream);
+    if (ds.status() != QDataStream::Ok) {
+        QVR_WARNING("recording file %s is invalid", qPrintable(_file.fileName()));
+        return false;
+    }
+    return true;
+}
+
+void QVRReplayer::close()
+{
+    if (_data) {
+        _file.unmap(const_cast<uchar*>(_data));
+        _data = NULL;
+    }
+    if (_file.isOpen())
+        _file.close();
+}
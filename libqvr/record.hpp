@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef QVR_RECORD_HPP
+#define QVR_RECORD_HPP
+
+#include <QFile>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QQueue>
+
+class QVRApp;
+class QVRDevice;
+class QVRObserver;
+class QVREvent;
+
+
+/* Recording and replay of the input that drives the main process: device
+ * states, observer poses, events, near/far values, and the dynamic application
+ * data. Replaying a recording renders the identical frames, which makes frame
+ * times of different builds comparable.
+ * These interfaces are only used internally and never exposed to applications.
+ *
+ * File format: a header (magic, version, device count, observer count),
+ * followed by one record per frame. Each frame record starts with its size in
+ * bytes so that a reader can skip it. All data is written with QDataStream in
+ * single floating point precision. */
+
+class QVRRecorder
+{
+private:
+    QFile _file;
+    QElapsedTimer _timer;
+    QByteArray _frame;
+
+public:
+    QVRRecorder();
+
+    // Open the file and write the header. Returns false on error.
+    bool open(const QString& filename, int deviceCount, int observerCount);
+    // Append the data of one frame. The events are only read, not consumed.
+    bool writeFrame(float n, float f,
+            const QList<QVRDevice*>& devices,
+            const QList<QVRObserver*>& observers,
+            const QQueue<QVREvent>& events,
+            QVRApp* app);
+    void close();
+};
+
+class QVRReplayer
+{
+private:
+    QFile _file;
+    const uchar* _data; // the memory-mapped file
+    qint64 _size;
+    qint64 _pos;
+    QElapsedTimer _timer;
+    bool _realtime;
+
+public:
+    QVRReplayer();
+
+    // Map the file and check the header against the current configuration.
+    // Returns false on error.
+    bool open(const QString& filename, bool realtime, int deviceCount, int observerCount);
+    // Read the data of the next frame into the devices, observers, and the
+    // application, and append the recorded events to the list. With realtime
+    // replay, this waits until the frame is due. Returns false when the end
+    // of the recording is reached or on error.
+    bool readFrame(float* n, float* f,
+            QList<QVRDevice*>& devices,
+            QList<QVRObserver*>& observers,
+            QList<QVREvent>* events,
+            QVRApp* app);
+    void close();
+};
+
+#endif
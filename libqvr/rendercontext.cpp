@@ -42,10 +42,12 @@ QVRRenderContext::QVRRenderContext() :
     _trackingPosition { QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 0.0f) },
     _trackingOrientation { QQuaternion(0.0f, 0.0f, 0.0f, 0.0f), QQuaternion(0.0f, 0.0f, 0.0f, 0.0f) },
     _frustum { { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } },
+    _jitter { QVector2D(0.0f, 0.0f), QVector2D(0.0f, 0.0f) },
     _viewMatrix { QMatrix4x4(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f),
                   QMatrix4x4(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f) },
     _viewMatrixPure { QMatrix4x4(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f),
-                  QMatrix4x4(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f) }
+                  QMatrix4x4(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f) },
+    _processCullingPlaneCount(0)
 {
 }
 
@@ -54,6 +56,7 @@ void QVRRenderContext::setOutputConf(QVROutputMode om)
     _outputMode = om;
     switch (om) {
     case QVR_Output_Center:
+    case QVR_Output_Offscreen:
         _viewCount = 1;
         _eye[0] = QVR_Eye_Center;
         break;
@@ -93,6 +96,7 @@ QDataStream &operator<<(QDataStream& ds, const QVRRenderContext& rc)
             << rc._trackingPosition[i]
             << rc._trackingOrientation[i]
             << rc._frustum[i]
+            << rc._jitter[i]
             << rc._viewMatrix[i]
             << rc._viewMatrixPure[i];
     }
@@ -116,6 +120,7 @@ QDataStream &operator>>(QDataStream& ds, QVRRenderContext& rc)
             >> rc._trackingPosition[i]
             >> rc._trackingOrientation[i]
             >> rc._frustum[i]
+            >> rc._jitter[i]
             >> rc._viewMatrix[i]
             >> rc._viewMatrixPure[i];
         rc._eye[i] = static_cast<QVREye>(e);
@@ -26,6 +26,7 @@
 #define QVR_RENDERCONTEXT_HPP
 
 #include <QRect>
+#include <QVector2D>
 #include <QVector3D>
 #include <QMatrix4x4>
 #include <QQuaternion>
@@ -55,6 +56,10 @@ class QDataStream;
  */
 class QVRRenderContext
 {
+public:
+    /*! \brief The maximum number of process culling planes; see \a processCullingPlanes(). */
+    static constexpr int maxProcessCullingPlanes = 32;
+
 private:
     int _processIndex;
     int _windowIndex;
@@ -70,10 +75,13 @@ private:
     QVector3D _trackingPosition[2];
     QQuaternion _trackingOrientation[2];
     QVRFrustum _frustum[2];
+    QVector2D _jitter[2];
     QMatrix4x4 _viewMatrix[2];
     QMatrix4x4 _viewMatrixPure[2];
     QVector3D _unitedScreenWall[3];
     QVector3D _intersectedScreenWall[3];
+    int _processCullingPlaneCount;
+    QVector4D _processCullingPlanes[maxProcessCullingPlanes];
 
     friend QDataStream &operator<<(QDataStream& ds, const QVRRenderContext& rc);
     friend QDataStream &operator>>(QDataStream& ds, QVRRenderContext& rc);
@@ -91,6 +99,7 @@ private:
     void setTextureSize(int vp, const QSize& size) { _textureSize[vp] = size; }
     void setTracking(int vp, const QVector3D& p, const QQuaternion& r) { _trackingPosition[vp] = p; _trackingOrientation[vp] = r; }
     void setFrustum(int vp, const QVRFrustum f) { _frustum[vp] = f; }
+    void setJitter(int vp, const QVector2D& j) { _jitter[vp] = j; }
     void setViewMatrix(int vp, const QMatrix4x4& vm) { _viewMatrix[vp] = vm; }
     void setViewMatrixPure(int vp, const QMatrix4x4& vmp) { _viewMatrixPure[vp] = vmp; }
     // These functions are used internally by QVRManager when computing the global screen information.
@@ -99,6 +108,8 @@ private:
     { _unitedScreenWall[0] = bl; _unitedScreenWall[1]= br; _unitedScreenWall[2] = tl; }
     void setIntersectedScreenWall(const QVector3D& bl, const QVector3D& br, const QVector3D& tl)
     { _intersectedScreenWall[0] = bl; _intersectedScreenWall[1]= br; _intersectedScreenWall[2] = tl; }
+    void setProcessCullingPlanes(const QVector4D* planes, int count)
+    { _processCullingPlaneCount = count; for (int i = 0; i < count; i++) _processCullingPlanes[i] = planes[i]; }
 
 public:
     /*! \brief Constructor. */
@@ -140,10 +151,22 @@ public:
     QMatrix4x4 trackingMatrix(int view) const { Q_ASSERT(view >= 0 && view < viewCount()); QMatrix4x4 m; m.translate(trackingPosition(view)); m.rotate(trackingOrientation(view)); return m; }
     /*! \brief Returns the frustum for rendering \a view. */
     const QVRFrustum& frustum(int view) const { Q_ASSERT(view >= 0 && view < viewCount()); return _frustum[view]; }
+    /*!
+     * \brief Returns the sub-pixel jitter of the frustum for rendering \a view.
+     *
+     * For windows with temporal upscaling (see \a QVRWindowConfig::temporalUpscaling()),
+     * the frustum is shifted by a different sub-pixel offset in each frame, so that
+     * successive frames sample different positions. The offset is given in texels of
+     * the view texture and lies in [-0.5,0.5]. It is already applied to frustum(); the
+     * application does not need to use it. For other windows, it is (0,0).
+     */
+    const QVector2D& jitter(int view) const { Q_ASSERT(view >= 0 && view < viewCount()); return _jitter[view]; }
     /*! \brief Returns the view matrix for rendering \a view. */
     const QMatrix4x4& viewMatrix(int view) const { Q_ASSERT(view >= 0 && view < viewCount()); return _viewMatrix[view]; }
     /*! \brief Returns the pure view matrix (i.e. in tracking space, without navigation) for rendering \a view. */
     const QMatrix4x4& viewMatrixPure(int view) const { Q_ASSERT(view >= 0 && view < viewCount()); return _viewMatrixPure[view]; }
+    /*! \brief Computes the 6 world space culling planes for rendering \a view; see \a QVRFrustum::getCullingPlanes(). */
+    void getCullingPlanes(int view, QVector4D* planes) const { frustum(view).getCullingPlanes(viewMatrix(view), planes); }
     /*! \brief Returns whether there is a global 2D screen wall that is united across all windows. */
     bool haveUnitedScreenWall() const { return !_unitedScreenWall[0].isNull() || !_unitedScreenWall[1].isNull() || !_unitedScreenWall[2].isNull(); }
     /*! \brief Returns the virtual world coordinates of the bottom left corner of the global screen wall united across all windows. */
@@ -160,6 +183,18 @@ public:
     const QVector3D& intersectedScreenWallBottomRight() const { return _intersectedScreenWall[1]; }
     /*! \brief Returns the virtual world coordinates of the top left corner of the global screen wall intersected across all windows. */
     const QVector3D& intersectedScreenWallTopLeft() const { return _intersectedScreenWall[2]; }
+    /*!
+     * \brief Returns the culling planes of a conservative volume that contains all views of all windows of this process.
+     *
+     * The volume is convex and contains both eyes of stereo windows as well as the views of all other windows
+     * of the process, so that applications can cull their scene once per process and frame (see
+     * \a QVRApp::updateProcessVisibleSet()) and then only filter the result per view (see \a getCullingPlanes()).
+     * The planes have the same form as those of \a QVRFrustum::getCullingPlanes(); their number varies
+     * (see \a processCullingPlaneCount()), but never exceeds \a maxProcessCullingPlanes.
+     */
+    const QVector4D* processCullingPlanes() const { return _processCullingPlanes; }
+    /*! \brief Returns the number of planes returned by \a processCullingPlanes(). */
+    int processCullingPlaneCount() const { return _processCullingPlaneCount; }
 };
 
 QDataStream &operator<<(QDataStream& ds, const QVRRenderContext& rc);
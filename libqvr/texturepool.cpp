@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+#include "texturepool.hpp"
+#include "logging.hpp"
+
+
+static qint64 QVRTextureBytesPerTexel(unsigned int format)
+{
+    // All view texture formats (GL_RGBA8, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT32F)
+    // have 32 bits per texel
+    Q_UNUSED(format);
+    return 4;
+}
+
+QVRTexturePool::QVRTexturePool() :
+    _inUseBytes(0),
+    _idleBytes(0),
+    _allocations(0),
+    _reuses(0),
+    _haveTexStorage(-1)
+{
+}
+
+QVRTexturePool::~QVRTexturePool()
+{
+    // Remaining textures cannot be deleted here since this requires a current
+    // OpenGL context; they go away with the context. See clear().
+}
+
+unsigned int QVRTexturePool::acquire(unsigned int target, unsigned int format, int width, int height, int layers)
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+    Q_ASSERT(target == GL_TEXTURE_2D || target == GL_TEXTURE_2D_ARRAY);
+
+    for (int i = _idle.size() - 1; i >= 0; i--) {
+        const Texture& t = _idle[i];
+        if (t.target == target && t.format == format
+                && t.width == width && t.height == height && t.layers == layers) {
+            Texture reused = _idle.takeAt(i);
+            _idleBytes -= reused.bytes;
+            _inUseBytes += reused.bytes;
+            _inUse.insert(reused.name, reused);
+            _reuses++;
+            QVR_FIREHOSE("texture pool: reusing texture %u (%dx%dx%d)", reused.name, width, height, layers);
+            return reused.name;
+        }
+    }
+
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    QOpenGLExtraFunctions* gl = ctx->extraFunctions();
+    if (_haveTexStorage < 0) {
+        QPair<int, int> version = ctx->format().version();
+        if (ctx->isOpenGLES())
+            _haveTexStorage = (version >= qMakePair(3, 0));
+        else
+            _haveTexStorage = (version >= qMakePair(4, 2) || ctx->hasExtension("GL_ARB_texture_storage"));
+        if (!_haveTexStorage)
+            QVR_DEBUG("texture pool: immutable texture storage is not available");
+    }
+    Texture t;
+    gl->glGenTextures(1, &t.name);
+    gl->glBindTexture(target, t.name);
+    if (_haveTexStorage) {
+        if (target == GL_TEXTURE_2D_ARRAY)
+            gl->glTexStorage3D(target, 1, format, width, height, layers);
+        else
+            gl->glTexStorage2D(target, 1, format, width, height);
+    } else {
+        unsigned int externalFormat = (format == GL_DEPTH_COMPONENT32F ? GL_DEPTH_COMPONENT : GL_RGBA);
+        unsigned int type = (format == GL_DEPTH_COMPONENT32F ? GL_FLOAT : GL_UNSIGNED_BYTE);
+        if (target == GL_TEXTURE_2D_ARRAY)
+            gl->glTexImage3D(target, 0, format, width, height, layers, 0, externalFormat, type, NULL);
+        else
+            gl->glTexImage2D(target, 0, format, width, height, 0, externalFormat, type, NULL);
+        // Immutable storage has exactly one level; do the same here
+        gl->glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    t.target = target;
+    t.format = format;
+    t.width = width;
+    t.height = height;
+    t.layers = layers;
+    t.bytes = QVRTextureBytesPerTexel(format) * width * height * layers;
+    _inUseBytes += t.bytes;
+    _inUse.insert(t.name, t);
+    _allocations++;
+    QVR_DEBUG("texture pool: allocated texture %u (%dx%dx%d); %lld bytes in use, %lld idle",
+            t.name, width, height, layers, _inUseBytes, _idleBytes);
+    return t.name;
+}
+
+bool QVRTexturePool::release(unsigned int name)
+{
+    auto it = _inUse.find(name);
+    if (it == _inUse.end())
+        return false;
+    Texture t = it.value();
+    _inUse.erase(it);
+    _inUseBytes -= t.bytes;
+    _idle.append(t);
+    _idleBytes += t.bytes;
+    trim();
+    return true;
+}
+
+void QVRTexturePool::trim()
+{
+    if (_idleBytes <= 2 * _inUseBytes)
+        return;
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    while (_idleBytes > 2 * _inUseBytes) {
+        Texture t = _idle.takeFirst();
+        _idleBytes -= t.bytes;
+        gl->glDeleteTextures(1, &t.name);
+        QVR_DEBUG("texture pool: deleted idle texture %u (%dx%dx%d)", t.name, t.width, t.height, t.layers);
+    }
+}
+
+void QVRTexturePool::clear()
+{
+    if (_inUse.isEmpty() && _idle.isEmpty())
+        return;
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    for (auto it = _inUse.cbegin(); it != _inUse.cend(); ++it)
+        gl->glDeleteTextures(1, &(it.value().name));
+    for (int i = 0; i < _idle.size(); i++)
+        gl->glDeleteTextures(1, &(_idle[i].name));
+    QVR_DEBUG("texture pool: %d allocations, %d reuses", _allocations, _reuses);
+    _inUse.clear();
+    _idle.clear();
+    _inUseBytes = 0;
+    _idleBytes = 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+#ifndef QVR_TEXTUREPOOL_HPP
+#define QVR_TEXTUREPOOL_HPP
+
+#include <QHash>
+#include <QList>
+
+
+/* A pool of the view textures of a process. All windows of a process create
+ * their view textures in the main OpenGL context, so they can share one pool.
+ *
+ * Textures get immutable storage where the OpenGL implementation supports it
+ * (OpenGL 4.2, ARB_texture_storage, or OpenGL ES 3.0), and mutable storage of
+ * the same size and format otherwise. A texture that is no longer needed
+ * (e.g. because its window was resized) is kept idle for later reuse by a
+ * request with the same target, format, and size. Idle textures are deleted
+ * least recently released first when they hold more than twice the memory of
+ * the textures in use.
+ *
+ * All functions must be called from the main thread, with an OpenGL context
+ * current that shares its textures with the main context.
+ * These interfaces are only used internally and never exposed to applications. */
+
+class QVRTexturePool
+{
+private:
+    struct Texture {
+        unsigned int name;
+        unsigned int target;
+        unsigned int format;
+        int width, height, layers;
+        qint64 bytes;
+    };
+    QHash<unsigned int, Texture> _inUse;
+    QList<Texture> _idle; // least recently released first
+    qint64 _inUseBytes;
+    qint64 _idleBytes;
+    int _allocations;
+    int _reuses;
+    int _haveTexStorage; // -1 until the first allocation checks it
+
+    void trim();
+
+public:
+    QVRTexturePool();
+    ~QVRTexturePool();
+
+    // Return a texture with the given target (GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY),
+    // sized internal format, and size. Texture parameters are not reset; the
+    // caller must set them.
+    unsigned int acquire(unsigned int target, unsigned int format, int width, int height, int layers = 1);
+    // Give a texture back to the pool. Returns false if the texture was not
+    // acquired from this pool; such textures are left untouched.
+    bool release(unsigned int name);
+    // Delete all textures, including those in use.
+    void clear();
+
+    // Statistics
+    qint64 inUseBytes() const { return _inUseBytes; }
+    qint64 idleBytes() const { return _idleBytes; }
+    int allocations() const { return _allocations; }
+    int reuses() const { return _reuses; }
+};
+
+#endif
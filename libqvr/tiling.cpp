@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <QtGlobal>
+#include <QFile>
+#include <QTextStream>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+
+#include "tiling.hpp"
+#include "internalglobals.hpp"
+#include "texturepool.hpp"
+#include "logging.hpp"
+
+
+// Smoothing factor for new shares, and the minimum share of each tile so
+// that a process never runs out of work and can still be measured.
+static const float QVRTileBalancerSmoothing = 0.5f;
+static const float QVRTileBalancerMinShare = 0.02f;
+
+QVRTileBalancer::QVRTileBalancer(int tiles) :
+    _shares(tiles, 1.0f / tiles)
+{
+    Q_ASSERT(tiles >= 1);
+}
+
+void QVRTileBalancer::update(const QVector<float>& renderTimes)
+{
+    Q_ASSERT(renderTimes.size() == tiles());
+
+    QVector<float> speeds(tiles());
+    float speedSum = 0.0f;
+    for (int i = 0; i < tiles(); i++) {
+        if (renderTimes[i] <= 0.0f)
+            return;
+        speeds[i] = _shares[i] / renderTimes[i];
+        speedSum += speeds[i];
+    }
+    float shareSum = 0.0f;
+    for (int i = 0; i < tiles(); i++) {
+        float share = (1.0f - QVRTileBalancerSmoothing) * _shares[i]
+            + QVRTileBalancerSmoothing * speeds[i] / speedSum;
+        _shares[i] = qMax(share, QVRTileBalancerMinShare);
+        shareSum += _shares[i];
+    }
+    for (int i = 0; i < tiles(); i++)
+        _shares[i] /= shareSum;
+}
+
+void QVRTileBalancer::getBounds(int width, QVector<int>& bounds) const
+{
+    int n = tiles();
+    bounds.resize(n + 1);
+    bounds[0] = 0;
+    bounds[n] = width;
+    if (width < n) {
+        for (int i = 1; i < n; i++)
+            bounds[i] = width;
+        return;
+    }
+    float cumulatedShare = 0.0f;
+    for (int i = 1; i < n; i++) {
+        cumulatedShare += _shares[i - 1];
+        bounds[i] = qBound(bounds[i - 1] + 1, qRound(cumulatedShare * width), width - (n - i));
+    }
+}
+
+
+// Helper function: read a complete file into a QString (without error checking)
+static QString readFile(const char* fileName)
+{
+    QFile f(fileName);
+    f.open(QIODevice::ReadOnly);
+    QTextStream in(&f);
+    return in.readAll();
+}
+
+QVRDepthCompositor::QVRDepthCompositor() :
+    _prg(NULL),
+    _fbo(0),
+    _vao(0)
+{
+}
+
+QVRDepthCompositor::~QVRDepthCompositor()
+{
+    // GL resources must be freed with exitGL() while the context is current
+}
+
+bool QVRDepthCompositor::initGL()
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+
+    if (QOpenGLContext::currentContext()->isOpenGLES()) {
+        QVR_FATAL("Sort-last compositing requires desktop OpenGL");
+        return false;
+    }
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    gl->glGenFramebuffers(1, &_fbo);
+    // The quad is generated from gl_VertexID, but core profiles need a VAO
+    gl->glGenVertexArrays(1, &_vao);
+    _prg = new QOpenGLShaderProgram;
+    QString vertexShaderSource = readFile(":/libqvr/composite-vs.glsl");
+    QString fragmentShaderSource = readFile(":/libqvr/composite-fs.glsl");
+    vertexShaderSource.prepend("#version 330\n");
+    fragmentShaderSource.prepend("#version 330\n");
+    if (!_prg->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource)) {
+        QVR_FATAL("Cannot add compositing vertex shader");
+        return false;
+    }
+    if (!_prg->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource)) {
+        QVR_FATAL("Cannot add compositing fragment shader");
+        return false;
+    }
+    if (!_prg->link()) {
+        QVR_FATAL("Cannot link compositing program");
+        return false;
+    }
+    return true;
+}
+
+void QVRDepthCompositor::exitGL()
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    if (_fbo != 0)
+        gl->glDeleteFramebuffers(1, &_fbo);
+    if (_vao != 0)
+        gl->glDeleteVertexArrays(1, &_vao);
+    delete _prg;
+    _prg = NULL;
+    _fbo = 0;
+    _vao = 0;
+}
+
+void QVRDepthCompositor::composite(unsigned int colorTex, unsigned int depthTex, const QRect& rect,
+        const unsigned char* colorData, const float* depthData)
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+
+    if (!_prg)
+        return;
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    // Save the state that we change
+    GLint framebufferBak, programBak, vaoBak, activeTextureBak;
+    GLint textureBinding0Bak, textureBinding1Bak, viewportBak[4];
+    GLboolean depthTestBak, depthMaskBak, blendBak, scissorTestBak, cullFaceBak;
+    GLint depthFuncBak;
+    gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferBak);
+    gl->glGetIntegerv(GL_CURRENT_PROGRAM, &programBak);
+    gl->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vaoBak);
+    gl->glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTextureBak);
+    gl->glActiveTexture(GL_TEXTURE0);
+    gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding0Bak);
+    gl->glActiveTexture(GL_TEXTURE1);
+    gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding1Bak);
+    gl->glGetIntegerv(GL_VIEWPORT, viewportBak);
+    gl->glGetIntegerv(GL_DEPTH_FUNC, &depthFuncBak);
+    gl->glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMaskBak);
+    depthTestBak = gl->glIsEnabled(GL_DEPTH_TEST);
+    blendBak = gl->glIsEnabled(GL_BLEND);
+    scissorTestBak = gl->glIsEnabled(GL_SCISSOR_TEST);
+    cullFaceBak = gl->glIsEnabled(GL_CULL_FACE);
+#ifdef GL_FRAMEBUFFER_SRGB
+    GLboolean framebufferSrgbBak = gl->glIsEnabled(GL_FRAMEBUFFER_SRGB);
+#endif
+
+    // Upload the rectangle into temporary textures
+    unsigned int srcTex[2];
+    srcTex[0] = QVRViewTexturePool->acquire(GL_TEXTURE_2D, GL_SRGB8_ALPHA8, rect.width(), rect.height());
+    srcTex[1] = QVRViewTexturePool->acquire(GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F, rect.width(), rect.height());
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int i = 0; i < 2; i++) {
+        gl->glActiveTexture(GL_TEXTURE0 + i);
+        gl->glBindTexture(GL_TEXTURE_2D, srcTex[i]);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (i == 0)
+            gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rect.width(), rect.height(),
+                    GL_RGBA, GL_UNSIGNED_BYTE, colorData);
+        else
+            gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rect.width(), rect.height(),
+                    GL_DEPTH_COMPONENT, GL_FLOAT, depthData);
+    }
+
+    // Draw them with depth test into the target textures
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+    gl->glViewport(rect.x(), rect.y(), rect.width(), rect.height());
+    gl->glEnable(GL_DEPTH_TEST);
+    gl->glDepthFunc(GL_LESS);
+    gl->glDepthMask(GL_TRUE);
+    gl->glDisable(GL_BLEND);
+    gl->glDisable(GL_SCISSOR_TEST);
+    gl->glDisable(GL_CULL_FACE);
+#ifdef GL_FRAMEBUFFER_SRGB
+    // The color texture is decoded when sampled and must be encoded when written
+    gl->glEnable(GL_FRAMEBUFFER_SRGB);
+#endif
+    gl->glUseProgram(_prg->programId());
+    _prg->setUniformValue("color_tex", 0);
+    _prg->setUniformValue("depth_tex", 1);
+    gl->glBindVertexArray(_vao);
+    gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Restore the state
+    QVRViewTexturePool->release(srcTex[0]);
+    QVRViewTexturePool->release(srcTex[1]);
+    gl->glBindVertexArray(vaoBak);
+    gl->glUseProgram(programBak);
+    gl->glDepthFunc(depthFuncBak);
+    gl->glDepthMask(depthMaskBak);
+    if (!depthTestBak)
+        gl->glDisable(GL_DEPTH_TEST);
+    if (blendBak)
+        gl->glEnable(GL_BLEND);
+    if (scissorTestBak)
+        gl->glEnable(GL_SCISSOR_TEST);
+    if (cullFaceBak)
+        gl->glEnable(GL_CULL_FACE);
+#ifdef GL_FRAMEBUFFER_SRGB
+    if (!framebufferSrgbBak)
+        gl->glDisable(GL_FRAMEBUFFER_SRGB);
+#endif
+    gl->glViewport(viewportBak[0], viewportBak[1], viewportBak[2], viewportBak[3]);
+    gl->glBindTexture(GL_TEXTURE_2D, textureBinding1Bak);
+    gl->glActiveTexture(GL_TEXTURE0);
+    gl->glBindTexture(GL_TEXTURE_2D, textureBinding0Bak);
+    gl->glActiveTexture(activeTextureBak);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebufferBak);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef QVR_TILING_HPP
+#define QVR_TILING_HPP
+
+#include <QVector>
+#include <QRect>
+
+class QOpenGLShaderProgram;
+
+
+/* Load balancing for sort-first tiling of a window (see
+ * QVRWindowConfig::tileProcessIds()).
+ *
+ * The window is split into vertical tiles, one per participating process.
+ * Each tile has a share of the window width. After each frame, the share of
+ * each tile is adjusted to the rendering speed of its process in that frame
+ * (share per second), so that all tiles would have taken the same time. The
+ * new shares are blended with the old ones to avoid oscillation.
+ * These interfaces are only used internally and never exposed to applications. */
+
+class QVRTileBalancer
+{
+private:
+    QVector<float> _shares;
+
+public:
+    QVRTileBalancer(int tiles);
+
+    int tiles() const { return _shares.size(); }
+
+    // Adjust the shares to the given render times (in seconds) of the tiles.
+    // Invalid measurements (zero or negative times) are ignored.
+    void update(const QVector<float>& renderTimes);
+    // Compute the tile boundaries for the given width: tile i covers the pixel
+    // columns bounds[i] to bounds[i+1]-1. Each tile is at least one pixel wide
+    // if the width allows it; otherwise the first tile covers the whole width.
+    void getBounds(int width, QVector<int>& bounds) const;
+};
+
+/* Depth compositing for sort-last tiling of a window (see
+ * QVRWindowConfig::tileCompositing()).
+ *
+ * The color and depth values of a rectangle rendered by another process are
+ * uploaded into temporary textures and drawn into the color and depth textures
+ * of the window with depth test, so that the nearest fragment wins.
+ * All functions must be called with the main context current.
+ * These interfaces are only used internally and never exposed to applications. */
+
+class QVRDepthCompositor
+{
+private:
+    QOpenGLShaderProgram* _prg;
+    unsigned int _fbo;
+    unsigned int _vao;
+
+public:
+    QVRDepthCompositor();
+    ~QVRDepthCompositor();
+
+    bool initGL();
+    void exitGL();
+
+    // Composite the given RGBA (sRGB-encoded) and depth values, which cover the
+    // given rectangle, into the color and depth textures. Both textures must
+    // have the same size, and the rectangle must lie inside.
+    void composite(unsigned int colorTex, unsigned int depthTex, const QRect& rect,
+            const unsigned char* colorData, const float* depthData);
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2016, 2017 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+uniform sampler2D view_tex;
+uniform highp sampler2D depth_tex;
+uniform sampler2D history_tex;
+uniform bool have_history;
+uniform bool have_depth;
+uniform highp vec2 view_size;   // size of the view texture
+uniform highp vec2 output_size; // size of the history texture
+uniform highp vec2 jitter;      // sub-pixel offset of the view, in view texels
+uniform highp mat4 reprojection; // current to previous NDC, both without jitter
+
+smooth in vec2 vtexcoord;
+
+layout(location = 0) out vec4 fcolor;
+
+// Weight of a new sample that lies exactly on the output pixel center
+const float alpha = 0.1;
+
+void main(void)
+{
+    // Find the view texel whose sample is closest to this output pixel.
+    // Texel k was sampled at position k + 0.5 + jitter.
+    highp vec2 p = vtexcoord * view_size - jitter;
+    ivec2 k = clamp(ivec2(floor(p)), ivec2(0), ivec2(view_size) - 1);
+    highp vec2 d = (p - (vec2(k) + 0.5)) * output_size / view_size;
+    lowp vec3 current = texelFetch(view_tex, k, 0).rgb;
+    if (!have_history) {
+        fcolor = vec4(current, 1.0);
+        return;
+    }
+
+    // Find this point in the history
+    highp vec2 ndc = 2.0 * vtexcoord - 1.0;
+    highp float depth = (have_depth ? texelFetch(depth_tex, k, 0).r : 1.0);
+    highp vec4 q = reprojection * vec4(ndc, 2.0 * depth - 1.0, 1.0);
+    highp vec2 htc = 0.5 * q.xy / q.w + 0.5;
+    if (q.w <= 0.0 || any(lessThan(htc, vec2(0.0))) || any(greaterThan(htc, vec2(1.0)))) {
+        fcolor = vec4(current, 1.0);
+        return;
+    }
+
+    // Clamp the history to the current neighborhood to reject stale colors
+    lowp vec3 cmin = current;
+    lowp vec3 cmax = current;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lowp vec3 c = texelFetch(view_tex, clamp(k + ivec2(x, y), ivec2(0), ivec2(view_size) - 1), 0).rgb;
+            cmin = min(cmin, c);
+            cmax = max(cmax, c);
+        }
+    }
+    lowp vec3 history = clamp(texture(history_tex, htc).rgb, cmin, cmax);
+
+    // Blend, with more weight for samples close to the output pixel center
+    float w = alpha * exp(-2.0 * dot(d, d));
+    fcolor = vec4(mix(history, current, w), 1.0);
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtGlobal>
+#include <QFile>
+#include <QTextStream>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+
+#include "upscaler.hpp"
+#include "rendercontext.hpp"
+#include "logging.hpp"
+
+
+// Helper function: read a complete file into a QString (without error checking)
+static QString readFile(const char* fileName)
+{
+    QFile f(fileName);
+    f.open(QIODevice::ReadOnly);
+    QTextStream in(&f);
+    return in.readAll();
+}
+
+QVRTemporalUpscaler::QVRTemporalUpscaler() :
+    _prg(NULL),
+    _fbo(0),
+    _vao(0),
+    _history { { 0, 0 }, { 0, 0 } },
+    _current(0),
+    _width(-1),
+    _height(-1),
+    _viewCount(0),
+    _haveHistory(false)
+{
+}
+
+QVRTemporalUpscaler::~QVRTemporalUpscaler()
+{
+    // GL resources must be freed with exitGL() while the context is current
+}
+
+bool QVRTemporalUpscaler::initGL()
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    gl->glGenFramebuffers(1, &_fbo);
+    // The quad is generated from gl_VertexID, but core profiles need a VAO
+    gl->glGenVertexArrays(1, &_vao);
+    _prg = new QOpenGLShaderProgram;
+    QString vertexShaderSource = readFile(":/libqvr/composite-vs.glsl");
+    QString fragmentShaderSource = readFile(":/libqvr/upscale-fs.glsl");
+    if (QOpenGLContext::currentContext()->isOpenGLES()) {
+        vertexShaderSource.prepend("#version 300 es\n");
+        fragmentShaderSource.prepend("#version 300 es\n"
+                "precision mediump float;\n");
+    } else {
+        vertexShaderSource.prepend("#version 330\n");
+        fragmentShaderSource.prepend("#version 330\n");
+    }
+    if (!_prg->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource)) {
+        QVR_FATAL("Cannot add upscaling vertex shader");
+        return false;
+    }
+    if (!_prg->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource)) {
+        QVR_FATAL("Cannot add upscaling fragment shader");
+        return false;
+    }
+    if (!_prg->link()) {
+        QVR_FATAL("Cannot link upscaling program");
+        return false;
+    }
+    return true;
+}
+
+void QVRTemporalUpscaler::exitGL()
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    for (int h = 0; h < 2; h++) {
+        for (int i = 0; i < 2; i++) {
+            if (_history[h][i] != 0)
+                gl->glDeleteTextures(1, &(_history[h][i]));
+            _history[h][i] = 0;
+        }
+    }
+    if (_fbo != 0)
+        gl->glDeleteFramebuffers(1, &_fbo);
+    if (_vao != 0)
+        gl->glDeleteVertexArrays(1, &_vao);
+    delete _prg;
+    _prg = NULL;
+    _fbo = 0;
+    _vao = 0;
+    _haveHistory = false;
+}
+
+void QVRTemporalUpscaler::accumulate(const QVRRenderContext& context, const unsigned int* viewTextures,
+        const unsigned int* depthTextures, int width, int height)
+{
+    Q_ASSERT(QOpenGLContext::currentContext());
+
+    if (!_prg)
+        return;
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+
+    // Get the matrices of this frame, both as rendered and without the jitter
+    bool isNewFrame = !_haveHistory;
+    QMatrix4x4 jitteredViewProjection[2], viewProjection[2];
+    for (int i = 0; i < context.viewCount(); i++) {
+        QVRFrustum frustum = context.frustum(i);
+        jitteredViewProjection[i] = frustum.toMatrix4x4() * context.viewMatrix(i);
+        QSize size = context.textureSize(i);
+        float dx = context.jitter(i).x() * (frustum.rightPlane() - frustum.leftPlane()) / size.width();
+        float dy = context.jitter(i).y() * (frustum.topPlane() - frustum.bottomPlane()) / size.height();
+        frustum.setLeftPlane(frustum.leftPlane() - dx);
+        frustum.setRightPlane(frustum.rightPlane() - dx);
+        frustum.setBottomPlane(frustum.bottomPlane() - dy);
+        frustum.setTopPlane(frustum.topPlane() - dy);
+        viewProjection[i] = frustum.toMatrix4x4() * context.viewMatrix(i);
+        if (jitteredViewProjection[i] != _jitteredViewProjection[i])
+            isNewFrame = true;
+    }
+
+    // (Re)create the history textures if necessary
+    if (_width != width || _height != height || _viewCount != context.viewCount()) {
+        GLint textureBinding2dBak;
+        gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding2dBak);
+        for (int h = 0; h < 2; h++) {
+            for (int i = 0; i < 2; i++) {
+                if (_history[h][i] != 0)
+                    gl->glDeleteTextures(1, &(_history[h][i]));
+                _history[h][i] = 0;
+                if (i >= context.viewCount())
+                    continue;
+                gl->glGenTextures(1, &(_history[h][i]));
+                gl->glBindTexture(GL_TEXTURE_2D, _history[h][i]);
+                gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0,
+                        GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            }
+        }
+        gl->glBindTexture(GL_TEXTURE_2D, textureBinding2dBak);
+        _width = width;
+        _height = height;
+        _viewCount = context.viewCount();
+        _haveHistory = false;
+        isNewFrame = true;
+    }
+    if (!isNewFrame)
+        return;
+
+    // Save the state that we change
+    GLint framebufferBak, programBak, vaoBak, activeTextureBak, viewportBak[4];
+    GLint textureBindingBak[3];
+    gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferBak);
+    gl->glGetIntegerv(GL_CURRENT_PROGRAM, &programBak);
+    gl->glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vaoBak);
+    gl->glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTextureBak);
+    for (int u = 0; u < 3; u++) {
+        gl->glActiveTexture(GL_TEXTURE0 + u);
+        gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &(textureBindingBak[u]));
+    }
+    gl->glGetIntegerv(GL_VIEWPORT, viewportBak);
+    GLboolean depthTestBak = gl->glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blendBak = gl->glIsEnabled(GL_BLEND);
+#ifdef GL_FRAMEBUFFER_SRGB
+    GLboolean framebufferSrgbBak = gl->glIsEnabled(GL_FRAMEBUFFER_SRGB);
+#endif
+
+    // Blend each view into the older history, writing the newer one
+    int src = _current;
+    int dst = 1 - _current;
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+    gl->glViewport(0, 0, width, height);
+    gl->glDisable(GL_DEPTH_TEST);
+    gl->glDisable(GL_BLEND);
+#ifdef GL_FRAMEBUFFER_SRGB
+    // The history is decoded when sampled and must be encoded when written
+    gl->glEnable(GL_FRAMEBUFFER_SRGB);
+#endif
+    gl->glUseProgram(_prg->programId());
+    _prg->setUniformValue("view_tex", 0);
+    _prg->setUniformValue("depth_tex", 1);
+    _prg->setUniformValue("history_tex", 2);
+    gl->glBindVertexArray(_vao);
+    for (int i = 0; i < context.viewCount(); i++) {
+        QSize size = context.textureSize(i);
+        gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _history[dst][i], 0);
+        gl->glActiveTexture(GL_TEXTURE0);
+        gl->glBindTexture(GL_TEXTURE_2D, viewTextures[i]);
+        gl->glActiveTexture(GL_TEXTURE1);
+        gl->glBindTexture(GL_TEXTURE_2D, depthTextures[i]);
+        gl->glActiveTexture(GL_TEXTURE2);
+        gl->glBindTexture(GL_TEXTURE_2D, _history[src][i]);
+        _prg->setUniformValue("have_history", _haveHistory);
+        _prg->setUniformValue("have_depth", depthTextures[i] != 0);
+        _prg->setUniformValue("view_size", QVector2D(size.width(), size.height()));
+        _prg->setUniformValue("output_size", QVector2D(width, height));
+        _prg->setUniformValue("jitter", context.jitter(i));
+        _prg->setUniformValue("reprojection", _viewProjection[i] * viewProjection[i].inverted());
+        gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        _jitteredViewProjection[i] = jitteredViewProjection[i];
+        _viewProjection[i] = viewProjection[i];
+    }
+    _current = dst;
+    _haveHistory = true;
+
+    // Restore the state
+    gl->glBindVertexArray(vaoBak);
+    gl->glUseProgram(programBak);
+    if (depthTestBak)
+        gl->glEnable(GL_DEPTH_TEST);
+    if (blendBak)
+        gl->glEnable(GL_BLEND);
+#ifdef GL_FRAMEBUFFER_SRGB
+    if (!framebufferSrgbBak)
+        gl->glDisable(GL_FRAMEBUFFER_SRGB);
+#endif
+    gl->glViewport(viewportBak[0], viewportBak[1], viewportBak[2], viewportBak[3]);
+    for (int u = 2; u >= 0; u--) {
+        gl->glActiveTexture(GL_TEXTURE0 + u);
+        gl->glBindTexture(GL_TEXTURE_2D, textureBindingBak[u]);
+    }
+    gl->glActiveTexture(activeTextureBak);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebufferBak);
+}
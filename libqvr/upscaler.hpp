@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QVR_UPSCALER_HPP
+#define QVR_UPSCALER_HPP
+
+#include <QMatrix4x4>
+
+class QOpenGLShaderProgram;
+class QVRRenderContext;
+
+
+/* Temporal upscaling of the view textures of a window (see
+ * QVRWindowConfig::temporalUpscaling()).
+ *
+ * The application renders each frame at the render resolution, with a frustum
+ * that is shifted by a sub-pixel jitter (see QVRRenderContext::jitter()). The
+ * samples of successive frames are accumulated in history textures at the
+ * output resolution. The history is reprojected to the current pose based on
+ * the depth of each view and clamped to the colors of the current neighborhood
+ * to limit ghosting.
+ * All functions must be called with the window context current.
+ * These interfaces are only used internally and never exposed to applications. */
+
+class QVRTemporalUpscaler
+{
+private:
+    QOpenGLShaderProgram* _prg;
+    unsigned int _fbo;
+    unsigned int _vao;
+    unsigned int _history[2][2];    // two history textures per view, used alternately
+    int _current;                   // index of the history textures that hold the newest result
+    int _width, _height;            // size of the history textures
+    int _viewCount;
+    bool _haveHistory;
+    QMatrix4x4 _jitteredViewProjection[2]; // matrices of the newest accumulated frame
+    QMatrix4x4 _viewProjection[2];
+
+public:
+    QVRTemporalUpscaler();
+    ~QVRTemporalUpscaler();
+
+    bool initGL();
+    void exitGL();
+
+    // Accumulate the views of a frame into history textures of the given size.
+    // The depth textures may be 0. A frame that was already accumulated (e.g.
+    // because it is presented again) is ignored.
+    void accumulate(const QVRRenderContext& context, const unsigned int* viewTextures,
+            const unsigned int* depthTextures, int width, int height);
+    // The upscaled result for the given view of the newest frame, and its size.
+    unsigned int texture(int view) const { return _history[_current][view]; }
+    int width() const { return _width; }
+    int height() const { return _height; }
+};
+
+#endif
@@ -27,13 +27,19 @@
 #include <cmath>
 
 #include <QThread>
+#include <QSemaphore>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QPair>
+#include <QAtomicInt>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLContext>
 #include <QOpenGLExtraFunctions>
 #include <QQuaternion>
 #include <QGuiApplication>
 #include <QScreen>
+#include <QOffscreenSurface>
 #include <QKeyEvent>
 #include <QLibrary>
 #include <QFile>
@@ -43,6 +49,11 @@
 #include "manager.hpp"
 #include "logging.hpp"
 #include "observer.hpp"
+#include "texturepool.hpp"
+#include "capture.hpp"
+#include "tiling.hpp"
+#include "upscaler.hpp"
+#include "posetracker.hpp"
 #include "internalglobals.hpp"
 
 #ifdef HAVE_OCULUS
@@ -60,82 +71,183 @@ class QVRWindowThread : public QThread
 private:
     QVRWindow* _window;
 
+    void swapBuffers(QVRWindow* window);
+
 public:
-    bool exitWanted;
-    QMutex renderingMutex;
-    bool renderingFinished;
-    QMutex swapbuffersMutex;
-    bool swapbuffersFinished;
+    // Handshakes with the main thread: the main thread releases renderingWanted
+    // and swapbuffersWanted, and this thread answers with renderingFinished and
+    // swapbuffersFinished. Waiting threads block instead of spinning.
+    QAtomicInt exitWanted;
+    QSemaphore renderingWanted;
+    QSemaphore renderingFinished;
+    QSemaphore swapbuffersWanted;
+    QSemaphore swapbuffersFinished;
+    // With more than one view texture set, the main thread publishes the set
+    // it just completed in newestSet, and this thread presents the newest set
+    // whenever there is one. The main thread never renders into presentSet.
+    QMutex ringMutex;
+    QWaitCondition ringCondition;
+    int newestSet;
+    int presentSet;
+    // With a single presentation thread, this thread presents several windows
+    // with the context of the first one. The main thread queues jobs for them:
+    // present a window, swap its buffers, or release its output resources.
+    // The semaphore swapbuffersFinished answers swap jobs, and renderingFinished
+    // answers the other jobs.
+    typedef enum { JobPresent, JobSwap, JobExit } JobType;
+    bool isShared;
+    QList<QVRWindow*> windows;
+    QMutex jobMutex;
+    QWaitCondition jobCondition;
+    QQueue<QPair<QVRWindow*, JobType>> jobs;
 
 #if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION < 1)
     ovrGLTexture oculusEyeTextures[2];
 #endif
 
-    QVRWindowThread(QVRWindow* window);
+    QVRWindowThread(QVRWindow* window, bool isShared);
+
+    QVRWindow* owner() const { return _window; }
+    void addJob(QVRWindow* window, JobType type);
 
 protected:
     void run() override;
 };
 
-QVRWindowThread::QVRWindowThread(QVRWindow* window) :
-    _window(window), exitWanted(false)
+QVRWindowThread::QVRWindowThread(QVRWindow* window, bool isShared) :
+    _window(window), exitWanted(0), newestSet(-1), presentSet(-1), isShared(isShared)
 {
+    windows.append(window);
 }
 
-void QVRWindowThread::run()
+void QVRWindowThread::addJob(QVRWindow* window, JobType type)
 {
-    for (;;) {
-        _window->winContext()->makeCurrent(_window);
-        // Start rendering
-        renderingMutex.lock();
-        if (!exitWanted) {
-            _window->renderOutput();
-        }
-        renderingMutex.unlock();
-        renderingFinished = true;
-        if (exitWanted)
-            break;
-        // Swap buffers
-        swapbuffersMutex.lock();
-        if (!exitWanted) {
-            if (_window->config().outputMode() == QVR_Output_Oculus) {
+    jobMutex.lock();
+    jobs.enqueue(qMakePair(window, type));
+    jobCondition.wakeOne();
+    jobMutex.unlock();
+}
+
+void QVRWindowThread::swapBuffers(QVRWindow* window)
+{
+    if (window->config().outputMode() == QVR_Output_Oculus) {
 #ifdef HAVE_OCULUS
 # if (OVR_PRODUCT_VERSION >= 1)
-                ovr_CommitTextureSwapChain(QVROculus, QVROculusTextureSwapChainL);
-                ovr_CommitTextureSwapChain(QVROculus, QVROculusTextureSwapChainR);
-                QVROculusLayer.RenderPose[0] = QVROculusRenderPoses[0];
-                QVROculusLayer.RenderPose[1] = QVROculusRenderPoses[1];
-                ovrLayerHeader* layers = &QVROculusLayer.Header;
-                ovr_SubmitFrame(QVROculus, QVROculusFrameIndex, NULL, &layers, 1);
+        ovr_CommitTextureSwapChain(QVROculus, QVROculusTextureSwapChainL);
+        ovr_CommitTextureSwapChain(QVROculus, QVROculusTextureSwapChainR);
+        QVROculusLayer.RenderPose[0] = QVROculusRenderPoses[0];
+        QVROculusLayer.RenderPose[1] = QVROculusRenderPoses[1];
+        ovrLayerHeader* layers = &QVROculusLayer.Header;
+        ovr_SubmitFrame(QVROculus, QVROculusFrameIndex, NULL, &layers, 1);
 # else
-                ovrHmd_EndFrame(QVROculus, QVROculusRenderPoses,
-                        reinterpret_cast<ovrTexture*>(oculusEyeTextures));
+        ovrHmd_EndFrame(QVROculus, QVROculusRenderPoses,
+                reinterpret_cast<ovrTexture*>(oculusEyeTextures));
 # endif
 #endif
-            } else if (_window->config().outputMode() == QVR_Output_OpenVR) {
+    } else if (window->config().outputMode() == QVR_Output_OpenVR) {
 #ifdef HAVE_OPENVR
-                QVRUpdateOpenVR();
+        QVRUpdateOpenVR();
 #endif
-            } else if (_window->config().outputMode() == QVR_Output_GoogleVR) {
-                // no buffer swap wanted (?)
+    } else if (window->config().outputMode() == QVR_Output_GoogleVR) {
+        // no buffer swap wanted (?)
+    } else if (window->config().outputMode() == QVR_Output_Offscreen) {
+        // nothing to swap, the output stays in the FBO
+    } else {
+        // We check if the window is exposed here because swapBuffers()
+        // behaviour on an unexposed window is undefined. There seems to
+        // be no way to know for sure when a window is exposed after
+        // being shown...
+        if (window->isExposed())
+            window->winContext()->swapBuffers(window);
+    }
+}
+
+void QVRWindowThread::run()
+{
+    for (;;) {
+        if (isShared) {
+            // Work through the jobs of the windows that share this thread
+            jobMutex.lock();
+            while (jobs.isEmpty() && !exitWanted.loadAcquire())
+                jobCondition.wait(&jobMutex);
+            if (exitWanted.loadAcquire()) {
+                jobMutex.unlock();
+                break;
+            }
+            QPair<QVRWindow*, JobType> job = jobs.dequeue();
+            jobMutex.unlock();
+            _window->winContext()->makeCurrent(job.first->surface());
+            if (job.second == JobSwap) {
+                swapBuffers(job.first);
+                swapbuffersFinished.release();
+            } else if (job.second == JobExit) {
+                job.first->exitOutputGL();
+                renderingFinished.release();
             } else {
-                // We check if the window is exposed here because swapBuffers()
-                // behaviour on an unexposed window is undefined. There seems to
-                // be no way to know for sure when a window is exposed after
-                // being shown...
-                if (_window->isExposed())
-                    _window->winContext()->swapBuffers(_window);
+                job.first->renderOutput();
+                renderingFinished.release();
             }
+            continue;
         }
-        swapbuffersMutex.unlock();
-        swapbuffersFinished = true;
-        if (exitWanted)
+        _window->winContext()->makeCurrent(_window->surface());
+        if (_window->_textureSets > 1) {
+            // Wait for a newly completed set and present it. In present
+            // latest mode, present the current set again if there is no newer
+            // one, so that the display rate of this window is independent of
+            // the rendering rate.
+            bool presentLatest = _window->config().presentLatest()
+                && _window->config().outputMode() != QVR_Output_Offscreen;
+            ringMutex.lock();
+            while (newestSet < 0 && !(presentLatest && presentSet >= 0) && !exitWanted.loadAcquire())
+                ringCondition.wait(&ringMutex);
+            if (exitWanted.loadAcquire()) {
+                ringMutex.unlock();
+                break;
+            }
+            if (newestSet >= 0) {
+                presentSet = newestSet;
+                newestSet = -1;
+            }
+            ringMutex.unlock();
+            if (presentLatest && !_window->isExposed()) {
+                // swapBuffers() would not throttle us; avoid spinning
+                QThread::msleep(10);
+                continue;
+            }
+            _window->renderOutput();
+            swapBuffers(_window);
+            continue;
+        }
+        // Start rendering
+        renderingWanted.acquire();
+        if (exitWanted.loadAcquire())
+            break;
+        _window->renderOutput();
+        renderingFinished.release();
+        // Swap buffers
+        swapbuffersWanted.acquire();
+        if (exitWanted.loadAcquire())
             break;
+        swapBuffers(_window);
+        swapbuffersFinished.release();
     }
     _window->winContext()->doneCurrent();
     _window->winContext()->moveToThread(QCoreApplication::instance()->thread());
 }
 
+// Helper function: element of the Halton low-discrepancy sequence, in [0,1)
+static float halton(unsigned int index, unsigned int base)
+{
+    float f = 1.0f;
+    float r = 0.0f;
+    while (index > 0) {
+        f /= base;
+        r += f * (index % base);
+        index /= base;
+    }
+    return r;
+}
+
 // Helper function: read a complete file into a QString (without error checking)
 static QString readFile(const char* fileName)
 {
@@ -158,18 +270,65 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
     _thread(NULL),
     _observer(observer),
     _windowIndex(windowIndex),
-    _textures { 0, 0 },
-    _textureWidths { -1, -1 },
-    _textureHeights { -1, -1 },
+    _textureSets(1),
+    _renderSet(0),
+    _textures { { 0, 0 }, { 0, 0 }, { 0, 0 } },
+    _textureWidths { { -1, -1 }, { -1, -1 }, { -1, -1 } },
+    _textureHeights { { -1, -1 }, { -1, -1 }, { -1, -1 } },
+    _layeredViews(false),
+    _renderFences { NULL, NULL, NULL },
+    _reprojection(QVR_Reprojection_None),
+    _depthTextures { { 0, 0 }, { 0, 0 }, { 0, 0 } },
+    _poseTracker(NULL),
+    _isRendered(false),
+    _sharedPresenter(NULL),
+    _offscreenSurface(NULL),
+    _offscreenFbo(0),
+    _offscreenTex(0),
+    _offscreenWidth(-1),
+    _offscreenHeight(-1),
+    _capture(NULL),
+    _captureFbo(0),
+    _upscaler(NULL),
+    _tileBalancer(NULL),
+    _tileX0(0),
+    _tileX1(0),
+    _tileTextures { 0, 0 },
+    _tileTextureWidths { -1, -1 },
+    _tileTextureHeights { -1, -1 },
+    _tileDepthTextures { 0, 0 },
+    _tileRect(),
+    _tileCompositor(NULL),
+    _tileFbo(0),
+    _tilePbo(0),
+    _tilePboSize(0),
+    _tileFence(NULL),
+    _tileRenderStart(0),
+    _tileRenderTime(0.0f),
     _outputQuadVao(0),
     _outputPrg(NULL),
     _renderContext()
 {
     setSurfaceType(OpenGLSurface);
     create();
-    _winContext = new QOpenGLContext;
-    if (!isMain()) {
-        _winContext->setShareContext(mainWindow->winContext());
+    // With a single presentation thread, all windows of the process that
+    // can share it use the context of the first one.
+    bool wantSharedThread = (!isMain()
+            && processConfig().singlePresentationThread()
+            && config().outputMode() != QVR_Output_Stereo
+            && config().outputMode() != QVR_Output_Oculus
+            && config().outputMode() != QVR_Output_OpenVR
+            && config().outputMode() != QVR_Output_GoogleVR
+            && config().outputMode() != QVR_Output_Offscreen
+            && !isProxy());
+    QVRWindow* sharedPresenter = (wantSharedThread ? mainWindow->_sharedPresenter : NULL);
+    if (sharedPresenter) {
+        _winContext = sharedPresenter->winContext();
+    } else {
+        _winContext = new QOpenGLContext;
+        if (!isMain()) {
+            _winContext->setShareContext(mainWindow->winContext());
+        }
     }
     QSurfaceFormat format = QSurfaceFormat::defaultFormat();
     bool wantDoubleBuffer = true;
@@ -178,19 +337,34 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
     // - Oculus or OpenVR control / mirror window: double-buffering this
     //   would cause libqvr to sync to the window's swap rate instead of
     //   the faster HMD swap rate
+    // - offscreen window, tile proxy, or stream source: never shown
     // Note that OpenGL ES does not seem to support single buffering.
     if (format.renderableType() != QSurfaceFormat::OpenGLES
             && (isMain()
                 || config().outputMode() == QVR_Output_Oculus
-                || config().outputMode() == QVR_Output_OpenVR)) {
+                || config().outputMode() == QVR_Output_OpenVR
+                || config().outputMode() == QVR_Output_Offscreen
+                || isProxy())) {
         wantDoubleBuffer = false;
     }
     format.setSwapBehavior(wantDoubleBuffer ? QSurfaceFormat::DoubleBuffer : QSurfaceFormat::SingleBuffer);
-    bool wantStereo = (!isMain() && config().outputMode() == QVR_Output_Stereo);
+    bool wantStereo = (!isMain() && config().outputMode() == QVR_Output_Stereo && !isProxy());
     format.setStereo(wantStereo);
+    if (sharedPresenter) {
+        // Only the first window on the shared thread waits for vblank
+        format.setSwapInterval(0);
+    }
     setFormat(format);
-    _winContext->setFormat(format);
-    _winContext->create();
+    if (!isMain() && (config().outputMode() == QVR_Output_Offscreen || isProxy())) {
+        // Surfaces must be created in the main thread
+        _offscreenSurface = new QOffscreenSurface;
+        _offscreenSurface->setFormat(format);
+        _offscreenSurface->create();
+    }
+    if (!sharedPresenter) {
+        _winContext->setFormat(format);
+        _winContext->create();
+    }
     if (!_winContext->isValid()) {
         QVR_FATAL("Cannot get a valid OpenGL context");
         _isValid = false;
@@ -206,6 +380,12 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
                 _winContext->format().minorVersion(),
                 _winContext->format().profile() == QSurfaceFormat::CompatibilityProfile ? "compatibility" : "core");
     }
+    if (isSortLast() && _winContext->isOpenGLES()) {
+        // OpenGL ES cannot read back depth values
+        QVR_FATAL("window %s: sort-last compositing requires desktop OpenGL", qPrintable(config().id()));
+        _isValid = false;
+        return;
+    }
     if (!isMain() && !QOpenGLContext::areSharing(_winContext, mainWindow->winContext())) {
         QVR_FATAL("Cannot get a sharing OpenGL context");
         _isValid = false;
@@ -216,7 +396,7 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
         _isValid = false;
         return;
     }
-    _winContext->makeCurrent(this);
+    _winContext->makeCurrent(surface());
     _gl = new QOpenGLExtraFunctions(_winContext);
     QVR_DEBUG("    OpenGL version:    %s", getGLString(_gl, GL_VERSION));
     QVR_DEBUG("    OpenGL SL version: %s", getGLString(_gl, GL_SHADING_LANGUAGE_VERSION));
@@ -243,6 +423,72 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
         if (_screen < 0)
             _screen = QVRPrimaryScreen;
         QVR_DEBUG("      screen: %d", _screen);
+        _textureSets = config().textureBuffers();
+        if (config().presentLatest() && _textureSets < 2)
+            _textureSets = 2;
+        if (_textureSets > 1
+                && (config().outputMode() == QVR_Output_Oculus
+                    || config().outputMode() == QVR_Output_OpenVR
+                    || config().outputMode() == QVR_Output_GoogleVR)) {
+            QVR_WARNING("window %s: multiple texture buffers are not supported for this output mode",
+                    qPrintable(config().id()));
+            _textureSets = 1;
+        }
+        if (_textureSets > 1 && wantSharedThread) {
+            QVR_WARNING("window %s: multiple texture buffers are not supported with a single presentation thread",
+                    qPrintable(config().id()));
+            _textureSets = 1;
+        }
+        QVR_DEBUG("      texture sets: %d", _textureSets);
+        if (config().reprojection() != QVR_Reprojection_None) {
+            if (_textureSets < 2) {
+                QVR_WARNING("window %s: reprojection requires multiple texture buffers",
+                        qPrintable(config().id()));
+            } else if (config().reprojection() == QVR_Reprojection_Depth && (isTiled() || isStreamTarget())) {
+                // the views arrive without depth
+                QVR_WARNING("window %s: falling back to rotational reprojection",
+                        qPrintable(config().id()));
+                _reprojection = QVR_Reprojection_Rotation;
+            } else {
+                _reprojection = config().reprojection();
+            }
+            QVR_DEBUG("      reprojection: %s", _reprojection == QVR_Reprojection_Depth ? "depth"
+                    : _reprojection == QVR_Reprojection_Rotation ? "rotation" : "none");
+        }
+        if (!config().tileProcessIds().isEmpty()) {
+            _tileBalancer = new QVRTileBalancer(config().tileProcessIds().size() + 1);
+            QVR_DEBUG("      tiles: %d", _tileBalancer->tiles());
+        } else if (isTileProxy()) {
+            QVR_DEBUG("      tile %d of window %s", config().tileIndex(), qPrintable(config().tileOwnerId()));
+        } else if (isStreamSource()) {
+            QVR_DEBUG("      stream source for window %s of process %d",
+                    qPrintable(config().streamTargetId()), config().streamProcessIndex());
+        }
+        if (config().temporalUpscaling()) {
+            _upscaler = new QVRTemporalUpscaler;
+            QVR_DEBUG("      temporal upscaling");
+        }
+        if (config().captureMode() == QVR_Capture_Output
+                && (config().outputMode() == QVR_Output_Oculus
+                    || config().outputMode() == QVR_Output_GoogleVR)) {
+            QVR_WARNING("window %s: capturing the output is not supported for this output mode",
+                    qPrintable(config().id()));
+        } else if (config().captureMode() != QVR_Capture_None
+                && config().outputMode() != QVR_Output_GoogleVR) {
+            QString prefix = config().capturePrefix();
+            if (prefix.isEmpty())
+                prefix = "qvr-capture-" + config().id();
+            // Frames are captured at the presentation rate
+            float fps = 60.0f;
+            QScreen* screen = QGuiApplication::screens().value(_screen);
+            if (screen && config().outputMode() != QVR_Output_Offscreen)
+                fps = screen->refreshRate();
+            if (!config().presentLatest())
+                fps /= config().renderDivisor();
+            _capture = new QVRCapture(config().id(), config().captureMode(), config().captureFormat(),
+                    prefix, config().captureMode() == QVR_Capture_Views ? 2 : 1, fps);
+            QVR_DEBUG("      capture: %s", qPrintable(prefix));
+        }
         if (false) {
 #if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION < 1)
         } else if (config().outputMode() == QVR_Output_Oculus) {
@@ -283,6 +529,13 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
             show(); // Apparently this must be called before showFullScreen()
             showFullScreen();
 #endif
+        } else if (isProxy()) {
+            // Never shown; the tiled or display-only window determines the size
+            resize(config().initialSize());
+        } else if (config().outputMode() == QVR_Output_Offscreen) {
+            // Never shown; the size determines the output resolution
+            QVR_DEBUG("      offscreen size %dx%d", config().initialSize().width(), config().initialSize().height());
+            resize(config().initialSize());
         } else {
             setScreen(QGuiApplication::screens().at(_screen));
             QRect screenGeom = QVRScreenGeometries[_screen];
@@ -308,7 +561,8 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
                 show();
             }
         }
-        raise();
+        if (config().outputMode() != QVR_Output_Offscreen && !isProxy())
+            raise();
         if (config().outputMode() == QVR_Output_GoogleVR) {
 #ifdef ANDROID
             QVRGoogleVRResolutionFactor = config().renderResolutionFactor();
@@ -323,13 +577,23 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
                     activity.callMethod<void>("initializeVR");});
             QVR_DEBUG("    Google VR: initialized VR");
 #endif
+        } else if (sharedPresenter) {
+            QVR_DEBUG("      presented by the thread of window %s", qPrintable(sharedPresenter->id()));
+            _thread = sharedPresenter->_thread;
+            _thread->windows.append(this);
+            _winContext->doneCurrent();
         } else {
-            _thread = new QVRWindowThread(this);
+            _thread = new QVRWindowThread(this, wantSharedThread);
             _winContext->doneCurrent();
-            _winContext->moveToThread(_thread);
-            _thread->renderingMutex.lock();
-            _thread->swapbuffersMutex.lock();
-            _thread->start();
+            if (wantSharedThread) {
+                // The shared thread is started when it presents for the first
+                // time, so that the following windows can still initialize
+                // their resources with its context.
+                mainWindow->_sharedPresenter = this;
+            } else {
+                _winContext->moveToThread(_thread);
+                _thread->start();
+            }
         }
 
         _renderContext.setProcessIndex(QVRManager::processIndex());
@@ -342,10 +606,19 @@ QVRWindow::QVRWindow(QVRWindow* mainWindow, QVRObserver* observer, int windowInd
 QVRWindow::~QVRWindow()
 {
     if (_thread) {
+        bool isThreadOwner = (_thread->owner() == this);
         exitGL();
+        if (_thread)
+            _thread->windows.removeOne(this);
         delete _gl;
-        winContext()->deleteLater();
+        if (isThreadOwner)
+            winContext()->deleteLater();
     }
+    delete _poseTracker;
+    delete _capture;
+    delete _tileBalancer;
+    delete _tileCompositor;
+    delete _offscreenSurface;
 }
 
 void QVRWindow::renderToScreen()
@@ -357,17 +630,28 @@ void QVRWindow::renderToScreen()
 
     if (config().outputMode() == QVR_Output_GoogleVR) {
 #ifdef ANDROID
-        QVRGoogleVRTextures[0] = _textures[0];
-        QVRGoogleVRTextures[1] = _textures[1];
+        QVRGoogleVRTextures[0] = _textures[0][0];
+        QVRGoogleVRTextures[1] = _textures[0][1];
         while (!QVRGoogleVRSync.testAndSetRelaxed(0, 1))
             QThread::yieldCurrentThread();
 #endif
+    } else if (_textureSets > 1) {
+        // Publish the completed set without waiting for the window thread
+        _setContexts[_renderSet] = _renderContext;
+        _thread->ringMutex.lock();
+        _thread->newestSet = _renderSet;
+        _thread->ringCondition.wakeOne();
+        _thread->ringMutex.unlock();
+    } else if (_thread->isShared) {
+        if (!_thread->isRunning()) {
+            _winContext->moveToThread(_thread);
+            _thread->start();
+        }
+        _thread->addJob(this, QVRWindowThread::JobPresent);
+        _thread->renderingFinished.acquire();
     } else {
-        _thread->renderingFinished = false;
-        _thread->renderingMutex.unlock();
-        while (!_thread->renderingFinished)
-            QThread::yieldCurrentThread();
-        _thread->renderingMutex.lock();
+        _thread->renderingWanted.release();
+        _thread->renderingFinished.acquire();
     }
 }
 
@@ -378,11 +662,12 @@ void QVRWindow::asyncSwapBuffers()
     Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
     Q_ASSERT(config().outputMode() == QVR_Output_GoogleVR || _thread);
 
-    if (config().outputMode() == QVR_Output_GoogleVR) {
+    if (config().outputMode() == QVR_Output_GoogleVR || _textureSets > 1) {
         // do nothing
+    } else if (_thread->isShared) {
+        _thread->addJob(this, QVRWindowThread::JobSwap);
     } else {
-        _thread->swapbuffersFinished = false;
-        _thread->swapbuffersMutex.unlock();
+        _thread->swapbuffersWanted.release();
     }
 }
 
@@ -398,11 +683,153 @@ void QVRWindow::waitForSwapBuffers()
         while (!QVRGoogleVRSync.testAndSetRelaxed(2, 0))
             QThread::usleep(1);
 #endif
+    } else if (_textureSets > 1) {
+        // do nothing: the window thread presents on its own
     } else {
-        while (!_thread->swapbuffersFinished)
-            QThread::usleep(1);
-        _thread->swapbuffersMutex.lock();
+        _thread->swapbuffersFinished.acquire();
+    }
+}
+
+bool QVRWindow::isRenderFrame() const
+{
+    Q_ASSERT(!isMain());
+
+    return (config().renderDivisor() <= 1 || QVRFrameCounter % config().renderDivisor() == 0);
+}
+
+bool QVRWindow::wantsRendering() const
+{
+    Q_ASSERT(!isMain());
+
+    if (!isRenderFrame())
+        return false;
+    // Tile proxies render whenever their tile is not empty; the tiled window
+    // then still needs the tile even if it is not exposed itself.
+    if (isTileProxy())
+        return (isSortLast() ? !_tileRect.isEmpty() : _tileX1 > _tileX0);
+    // Stream sources render once the display-only process told us the size of
+    // its window, and stream targets must always accept the streamed frame.
+    if (isStreamSource())
+        return (_tileX1 > _tileX0);
+    if (isStreamTarget())
+        return true;
+    // Only skip unexposed windows when we know that their output goes to the
+    // window itself; HMD runtimes and output plugins may put it elsewhere.
+    if (config().outputPlugin().isEmpty()
+            && config().outputMode() != QVR_Output_Oculus
+            && config().outputMode() != QVR_Output_OpenVR
+            && config().outputMode() != QVR_Output_GoogleVR
+            && config().outputMode() != QVR_Output_Offscreen
+            && !isExposed())
+        return false;
+    return true;
+}
+
+bool QVRWindow::supportsLayeredViews() const
+{
+    Q_ASSERT(!isMain());
+
+    // Layered views only work where libqvr itself consumes the view textures;
+    // HMD runtimes and output plugins expect one 2D texture per view, and tiles
+    // and streamed frames are transferred into separate 2D textures.
+    return (config().outputPlugin().isEmpty()
+            && !isTiled()
+            && !isStreamTarget()
+            && !config().temporalUpscaling()
+            && (config().outputMode() == QVR_Output_Center
+                || config().outputMode() == QVR_Output_Offscreen
+                || config().outputMode() == QVR_Output_Left
+                || config().outputMode() == QVR_Output_Right
+                || config().outputMode() == QVR_Output_Stereo
+                || config().outputMode() == QVR_Output_Red_Cyan
+                || config().outputMode() == QVR_Output_Green_Magenta
+                || config().outputMode() == QVR_Output_Amber_Blue));
+}
+
+bool QVRWindow::isTiled() const
+{
+    return (!config().tileProcessIds().isEmpty() || isProxy());
+}
+
+bool QVRWindow::isTileProxy() const
+{
+    return (!isMain() && !config().tileOwnerId().isEmpty());
+}
+
+bool QVRWindow::isStreamSource() const
+{
+    return (!isMain() && !config().streamTargetId().isEmpty());
+}
+
+bool QVRWindow::isStreamTarget() const
+{
+    return (!isMain() && processConfig().displayOnly());
+}
+
+bool QVRWindow::isProxy() const
+{
+    return (isTileProxy() || isStreamSource());
+}
+
+bool QVRWindow::isSortLast() const
+{
+    return (isTiled() && config().tileCompositing() == QVR_Tile_Depth);
+}
+
+void QVRWindow::updateTileRect(bool haveBounds, const QVector3D& minCorner, const QVector3D& maxCorner)
+{
+    Q_ASSERT(isSortLast());
+
+    // Only tile proxies crop their transfers; see readTile()
+    QRect fullRect(QPoint(0, 0), _tileFullSize);
+    if (!isTileProxy() || !haveBounds) {
+        _tileRect = fullRect;
+        return;
+    }
+    // Project the corners of the bounding box into each view and unite the
+    // resulting pixel rectangles. If the box reaches behind the viewer, its
+    // projection is unbounded, so we use the whole window then.
+    float x0 = 1.0f, y0 = 1.0f, x1 = -1.0f, y1 = -1.0f;
+    for (int i = 0; i < _renderContext.viewCount(); i++) {
+        QMatrix4x4 m = _renderContext.frustum(i).toMatrix4x4() * _renderContext.viewMatrix(i);
+        int behind = 0;
+        for (int c = 0; c < 8; c++) {
+            QVector4D p = m * QVector4D(
+                    c & 1 ? maxCorner.x() : minCorner.x(),
+                    c & 2 ? maxCorner.y() : minCorner.y(),
+                    c & 4 ? maxCorner.z() : minCorner.z(), 1.0f);
+            if (p.w() <= 0.0f) {
+                behind++;
+                continue;
+            }
+            x0 = qMin(x0, p.x() / p.w());
+            x1 = qMax(x1, p.x() / p.w());
+            y0 = qMin(y0, p.y() / p.w());
+            y1 = qMax(y1, p.y() / p.w());
+        }
+        if (behind == 8) {
+            continue;
+        } else if (behind > 0) {
+            _tileRect = fullRect;
+            return;
+        }
     }
+    if (x0 > x1 || y0 > y1) {
+        _tileRect = QRect();
+        return;
+    }
+    int px0 = std::floor((0.5f * x0 + 0.5f) * _tileFullSize.width());
+    int px1 = std::ceil((0.5f * x1 + 0.5f) * _tileFullSize.width());
+    int py0 = std::floor((0.5f * y0 + 0.5f) * _tileFullSize.height());
+    int py1 = std::ceil((0.5f * y1 + 0.5f) * _tileFullSize.height());
+    _tileRect = QRect(QPoint(px0, py0), QPoint(px1 - 1, py1 - 1)).intersected(fullRect);
+}
+
+QSurface* QVRWindow::surface()
+{
+    if (_offscreenSurface)
+        return _offscreenSurface;
+    return this;
 }
 
 bool QVRWindow::isMain() const
@@ -455,11 +882,22 @@ const QVRObserverConfig& QVRWindow::observerConfig() const
     return _observer->config();
 }
 
+bool QVRWindow::layeredViews() const
+{
+    return _layeredViews;
+}
+
+unsigned int QVRWindow::depthTexture(int view) const
+{
+    Q_ASSERT(view >= 0 && view <= 1);
+    return (isSortLast() ? _tileDepthTextures[view] : _depthTextures[_renderSet][view]);
+}
+
 bool QVRWindow::initGL()
 {
     Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
 
-    _winContext->makeCurrent(this);
+    _winContext->makeCurrent(surface());
     _gl->initializeOpenGLFunctions();
 
     if (!isMain()) {
@@ -524,6 +962,8 @@ bool QVRWindow::initGL()
                 QVR_FATAL("Cannot link output program");
                 return false;
             }
+            if (_upscaler && !_upscaler->initGL())
+                return false;
         } else {
             // Initialize output plugin
             QStringList pluginSpec = config().outputPlugin().split(' ', Qt::SkipEmptyParts);
@@ -560,28 +1000,128 @@ void QVRWindow::exitGL()
     Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
     Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
 
+    if (isTiled()) {
+        // Tile resources belong to the main context, which is current here
+        for (int i = 0; i < 2; i++) {
+            if (_tileTextures[i] != 0)
+                QVRViewTexturePool->release(_tileTextures[i]);
+            if (_tileDepthTextures[i] != 0)
+                QVRViewTexturePool->release(_tileDepthTextures[i]);
+            _tileTextures[i] = 0;
+            _tileDepthTextures[i] = 0;
+        }
+        if (_tileCompositor)
+            _tileCompositor->exitGL();
+        if (_tileFbo != 0) {
+            _gl->glDeleteFramebuffers(1, &_tileFbo);
+            _tileFbo = 0;
+        }
+        if (_tileFence) {
+            _gl->glDeleteSync(static_cast<GLsync>(_tileFence));
+            _tileFence = NULL;
+        }
+        if (_tilePbo != 0) {
+            _gl->glDeleteBuffers(1, &_tilePbo);
+            _tilePbo = 0;
+            _tilePboSize = 0;
+        }
+    }
+
     if (!isMain() && _thread) {
+        if (_thread->owner() != this) {
+            // This window uses the context of the owner of its shared
+            // presentation thread, so it must release its output resources
+            // with that context current, in the thread that owns it.
+            if (_thread->isRunning()) {
+                _thread->addJob(this, QVRWindowThread::JobExit);
+                _thread->renderingFinished.acquire();
+            } else {
+                _winContext->makeCurrent(surface());
+                exitOutputGL();
+                _winContext->doneCurrent();
+            }
+            _thread->windows.removeOne(this);
+            _thread = NULL;
+            return;
+        }
         if (_thread->isRunning()) {
-            _thread->exitWanted = 1;
-            _thread->renderingMutex.unlock();
-            _thread->swapbuffersMutex.unlock();
+            _thread->exitWanted.storeRelease(1);
+            _thread->ringMutex.lock();
+            _thread->ringCondition.wakeAll();
+            _thread->ringMutex.unlock();
+            _thread->jobMutex.lock();
+            _thread->jobCondition.wakeAll();
+            _thread->jobMutex.unlock();
+            _thread->renderingWanted.release();
+            _thread->swapbuffersWanted.release();
             _thread->wait();
         }
+        // The owner of a shared presentation thread cleans up for all
+        // windows that are still on that thread, since they use its context.
+        QList<QVRWindow*> windows = _thread->windows;
         delete _thread;
-        _thread = NULL;
-        _winContext->makeCurrent(this);
-        if (config().outputPlugin().isEmpty()) {
-            _gl->glDeleteTextures(2, _textures);
-            _gl->glDeleteVertexArrays(1, &_outputQuadVao);
-            delete _outputPrg;
-        } else {
-            _outputPluginExitFunc(this);
+        for (int i = 0; i < windows.size(); i++) {
+            QVRWindow* window = windows[i];
+            window->_thread = NULL;
+            _winContext->makeCurrent(window->surface());
+            window->exitOutputGL();
         }
         _winContext->doneCurrent();
     }
 }
 
-void QVRWindow::screenWall(QVector3D& cornerBottomLeft, QVector3D& cornerBottomRight, QVector3D& cornerTopLeft)
+void QVRWindow::exitOutputGL()
+{
+    // The presentation context must be current
+    for (int s = 0; s < 3; s++) {
+        if (_renderFences[s]) {
+            _gl->glDeleteSync(static_cast<GLsync>(_renderFences[s]));
+            _renderFences[s] = NULL;
+        }
+    }
+    if (_capture) {
+        _capture->exitGL();
+        delete _capture;
+        _capture = NULL;
+    }
+    if (_captureFbo != 0) {
+        _gl->glDeleteFramebuffers(1, &(_captureFbo));
+        _captureFbo = 0;
+    }
+    if (_upscaler) {
+        _upscaler->exitGL();
+        delete _upscaler;
+        _upscaler = NULL;
+    }
+    if (_offscreenFbo != 0) {
+        _gl->glDeleteFramebuffers(1, &(_offscreenFbo));
+        _gl->glDeleteTextures(1, &(_offscreenTex));
+        _offscreenFbo = 0;
+        _offscreenTex = 0;
+    }
+    if (config().outputPlugin().isEmpty()) {
+        for (int s = 0; s < 3; s++) {
+            for (int i = 0; i < 2; i++) {
+                if (_textures[s][i] != 0
+                        && !QVRViewTexturePool->release(_textures[s][i])) {
+                    // not from the pool, e.g. from an HMD runtime
+                    _gl->glDeleteTextures(1, &(_textures[s][i]));
+                }
+                _textures[s][i] = 0;
+                if (_depthTextures[s][i] != 0)
+                    QVRViewTexturePool->release(_depthTextures[s][i]);
+                _depthTextures[s][i] = 0;
+            }
+        }
+        _gl->glDeleteVertexArrays(1, &(_outputQuadVao));
+        delete _outputPrg;
+    } else {
+        _outputPluginExitFunc(this);
+    }
+}
+
+void QVRWindow::screenWall(QVector3D& cornerBottomLeft, QVector3D& cornerBottomRight, QVector3D& cornerTopLeft,
+        bool applyObserver)
 {
     Q_ASSERT(!isMain());
     Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
@@ -629,7 +1169,7 @@ void QVRWindow::screenWall(QVector3D& cornerBottomLeft, QVector3D& cornerBottomR
         cornerBottomRight = config().screenCornerBottomRight();
         cornerTopLeft = config().screenCornerTopLeft();
     }
-    if (config().screenIsFixedToObserver()) {
+    if (applyObserver && config().screenIsFixedToObserver()) {
         QMatrix4x4 o = _observer->trackingMatrix();
         cornerBottomLeft = o.map(cornerBottomLeft);
         cornerBottomRight = o.map(cornerBottomRight);
@@ -637,6 +1177,25 @@ void QVRWindow::screenWall(QVector3D& cornerBottomLeft, QVector3D& cornerBottomR
     }
 }
 
+static QMatrix4x4 QVRViewMatrix(const QQuaternion& viewRot, const QVector3D& viewPos,
+        const QVRRenderContext& context, bool screenIsFixedToObserver)
+{
+    QMatrix4x4 viewMatrix;
+    if (screenIsFixedToObserver) {
+        // XXX why is this special case necessary?? the code below should always work!
+        viewMatrix.rotate(viewRot.inverted());
+        viewMatrix.rotate(context.navigationOrientation().inverted());
+        viewMatrix.translate(-viewPos);
+        viewMatrix.translate(-context.navigationPosition());
+    } else {
+        viewMatrix.rotate(viewRot.inverted());
+        viewMatrix.translate(-viewPos);
+        viewMatrix.rotate(context.navigationOrientation().inverted());
+        viewMatrix.translate(-context.navigationPosition());
+    }
+    return viewMatrix;
+}
+
 void QVRWindow::computeRenderContext(float n, float f)
 {
     Q_ASSERT(!isMain());
@@ -650,7 +1209,24 @@ void QVRWindow::computeRenderContext(float n, float f)
     _renderContext.setNavigation(_observer->navigationPosition(), _observer->navigationOrientation());
     _renderContext.setOutputConf(config().outputMode());
     QVector3D wallBl, wallBr, wallTl;
-    if (config().outputMode() != QVR_Output_Oculus
+    if (isTileProxy()) {
+        // The main process sends the screen wall of the tiled window
+        wallBl = _tileWall[0];
+        wallBr = _tileWall[1];
+        wallTl = _tileWall[2];
+    } else if (isStreamSource()) {
+        // The display-only process sends the screen wall of its window, but
+        // without the observer transformation, which is only known here
+        wallBl = _tileWall[0];
+        wallBr = _tileWall[1];
+        wallTl = _tileWall[2];
+        if (config().screenIsFixedToObserver()) {
+            QMatrix4x4 o = _observer->trackingMatrix();
+            wallBl = o.map(wallBl);
+            wallBr = o.map(wallBr);
+            wallTl = o.map(wallTl);
+        }
+    } else if (config().outputMode() != QVR_Output_Oculus
             && config().outputMode() != QVR_Output_OpenVR
             && config().outputMode() != QVR_Output_GoogleVR) {
         screenWall(wallBl, wallBr, wallTl);
@@ -707,12 +1283,33 @@ void QVRWindow::computeRenderContext(float n, float f)
             QVector3D planeNormal = QVector3D::crossProduct(planeUp, planeRight);
             float planeDistance = QVector3D::dotProduct(planeNormal, bl);
             // Compute the frustum
-            float width = (br - bl).length();
-            float height = (tl - bl).length();
+            float wallWidth = (br - bl).length();
+            float wallHeight = (tl - bl).length();
             float l = -QVector3D::dotProduct(-bl, planeRight);
-            float r = width + l;
+            float r = wallWidth + l;
             float b = -QVector3D::dotProduct(-bl, planeUp);
-            float t = height + b;
+            float t = wallHeight + b;
+            if (isTiled() && _tileFullSize.width() > 0) {
+                // Restrict the frustum to the columns of our tile
+                float tileL = l + (r - l) * _tileX0 / _tileFullSize.width();
+                float tileR = l + (r - l) * _tileX1 / _tileFullSize.width();
+                l = tileL;
+                r = tileR;
+            }
+            if (_upscaler) {
+                // Shift the frustum by a sub-pixel offset that differs in each rendered frame
+                int texWidth = qMax(1, int(width() * devicePixelRatio() * config().renderResolutionFactor()));
+                int texHeight = qMax(1, int(height() * devicePixelRatio() * config().renderResolutionFactor()));
+                unsigned int jitterIndex = (QVRFrameCounter / config().renderDivisor()) % 8 + 1;
+                QVector2D jitter(halton(jitterIndex, 2) - 0.5f, halton(jitterIndex, 3) - 0.5f);
+                float dx = jitter.x() * (r - l) / texWidth;
+                float dy = jitter.y() * (t - b) / texHeight;
+                l += dx;
+                r += dx;
+                b += dy;
+                t += dy;
+                _renderContext.setJitter(i, jitter);
+            }
             float q = n / planeDistance;
             _renderContext.setFrustum(i, QVRFrustum(l * q, r * q, b * q, t * q, n, f));
             // Compute the view matrix
@@ -724,20 +1321,68 @@ void QVRWindow::computeRenderContext(float n, float f)
         viewMatrixPure.rotate(viewRot.inverted());
         viewMatrixPure.translate(-viewPos);
         _renderContext.setViewMatrixPure(i, viewMatrixPure);
-        QMatrix4x4 viewMatrix;
-        if (config().screenIsFixedToObserver()) {
-            // XXX why is this special case necessary?? the code below should always work!
-            viewMatrix.rotate(viewRot.inverted());
-            viewMatrix.rotate(_renderContext.navigationOrientation().inverted());
-            viewMatrix.translate(-viewPos);
-            viewMatrix.translate(-_renderContext.navigationPosition());
-        } else {
-            viewMatrix.rotate(viewRot.inverted());
-            viewMatrix.translate(-viewPos);
-            viewMatrix.rotate(_renderContext.navigationOrientation().inverted());
-            viewMatrix.translate(-_renderContext.navigationPosition());
-        }
-        _renderContext.setViewMatrix(i, viewMatrix);
+        _renderContext.setViewMatrix(i, QVRViewMatrix(viewRot, viewPos, _renderContext,
+                    config().screenIsFixedToObserver()));
+    }
+
+    if (_reprojection != QVR_Reprojection_None) {
+        // The window thread reprojects the set that it presents to this pose,
+        // moved to the pose of the observer at present time
+        _thread->ringMutex.lock();
+        _latestContext = _renderContext;
+        if (_poseTracker)
+            _poseTracker->updateFrameSample();
+        _thread->ringMutex.unlock();
+    }
+}
+
+void QVRWindow::applyPoseChange(QVRRenderContext& context,
+        const QVector3D& oldPos, const QQuaternion& oldRot,
+        const QVector3D& newPos, const QQuaternion& newRot) const
+{
+    // The eyes move rigidly with the observer, and so does the screen wall if
+    // it is fixed to the observer. The frustum of each view is shifted by the
+    // movement of the eye in screen coordinates, which keeps the adjustments
+    // for tiles and jitter that computeRenderContext() applied.
+    QQuaternion deltaRot = newRot * oldRot.inverted();
+    QVector3D oldWall[3] = { context.screenWallBottomLeft(), context.screenWallBottomRight(), context.screenWallTopLeft() };
+    QVector3D newWall[3];
+    for (int j = 0; j < 3; j++)
+        newWall[j] = (config().screenIsFixedToObserver() ? newPos + deltaRot * (oldWall[j] - oldPos) : oldWall[j]);
+    context.setScreenWall(newWall[0], newWall[1], newWall[2]);
+    QVector3D oldRight = (oldWall[1] - oldWall[0]).normalized();
+    QVector3D oldUp = (oldWall[2] - oldWall[0]).normalized();
+    QVector3D oldNormal = QVector3D::crossProduct(oldUp, oldRight);
+    QVector3D newRight = (newWall[1] - newWall[0]).normalized();
+    QVector3D newUp = (newWall[2] - newWall[0]).normalized();
+    QVector3D newNormal = QVector3D::crossProduct(newUp, newRight);
+    for (int i = 0; i < context.viewCount(); i++) {
+        QVector3D oldEye = context.trackingPosition(i);
+        QVector3D newEye = newPos + deltaRot * (oldEye - oldPos);
+        float oldL = QVector3D::dotProduct(oldWall[0] - oldEye, oldRight);
+        float oldB = QVector3D::dotProduct(oldWall[0] - oldEye, oldUp);
+        float oldD = QVector3D::dotProduct(oldWall[0] - oldEye, oldNormal);
+        float newL = QVector3D::dotProduct(newWall[0] - newEye, newRight);
+        float newB = QVector3D::dotProduct(newWall[0] - newEye, newUp);
+        float newD = QVector3D::dotProduct(newWall[0] - newEye, newNormal);
+        if (oldD == 0.0f || newD == 0.0f)
+            continue;
+        const QVRFrustum& f = context.frustum(i);
+        float oldQ = f.nearPlane() / oldD;
+        float newQ = f.nearPlane() / newD;
+        context.setFrustum(i, QVRFrustum(
+                    (f.leftPlane() / oldQ + newL - oldL) * newQ,
+                    (f.rightPlane() / oldQ + newL - oldL) * newQ,
+                    (f.bottomPlane() / oldQ + newB - oldB) * newQ,
+                    (f.topPlane() / oldQ + newB - oldB) * newQ,
+                    f.nearPlane(), f.farPlane()));
+        context.setTracking(i, newEye, deltaRot * context.trackingOrientation(i));
+        QQuaternion viewRot = QQuaternion::fromDirection(-newD * newNormal, newUp);
+        QMatrix4x4 viewMatrixPure;
+        viewMatrixPure.rotate(viewRot.inverted());
+        viewMatrixPure.translate(-newEye);
+        context.setViewMatrixPure(i, viewMatrixPure);
+        context.setViewMatrix(i, QVRViewMatrix(viewRot, newEye, context, config().screenIsFixedToObserver()));
     }
 }
 
@@ -749,11 +1394,46 @@ void QVRWindow::getTextures(unsigned int textures[2])
 
     /* Get the textures that the application needs to render into */
 
-    GLint textureBinding2dBak;
+    if (isProxy()) {
+        // The tile is all we need
+        getTileTextures(textures);
+        return;
+    }
+
+    if (_textureSets > 1) {
+        // Choose a set that the window thread neither presents nor is about
+        // to present. With only two sets, both may be busy; in that case take
+        // back the published set that was not picked up yet.
+        _thread->ringMutex.lock();
+        int set = -1;
+        for (int s = 0; s < _textureSets; s++) {
+            if (s != _thread->presentSet && s != _thread->newestSet) {
+                set = s;
+                break;
+            }
+        }
+        if (set < 0) {
+            set = _thread->newestSet;
+            _thread->newestSet = -1;
+        }
+        _thread->ringMutex.unlock();
+        _renderSet = set;
+        // A set that was never presented may still have its fence
+        if (_renderFences[_renderSet]) {
+            _gl->glDeleteSync(static_cast<GLsync>(_renderFences[_renderSet]));
+            _renderFences[_renderSet] = NULL;
+        }
+    }
+    unsigned int* tex = _textures[_renderSet];
+    int* texWidths = _textureWidths[_renderSet];
+    int* texHeights = _textureHeights[_renderSet];
+
+    GLint textureBinding2dBak, textureBinding2dArrayBak;
     _gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding2dBak);
+    _gl->glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &textureBinding2dArrayBak);
 
 #if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION >= 1)
-    if (config().outputMode() == QVR_Output_Oculus && _textures[0] == 0) {
+    if (config().outputMode() == QVR_Output_Oculus && tex[0] == 0) {
         ovrHmdDesc hmdDesc = ovr_GetHmdDesc(QVROculus);
         ovrTextureSwapChainDesc tscDesc = {};
         tscDesc.Type = ovrTexture_2D;
@@ -780,8 +1460,8 @@ void QVRWindow::getTextures(unsigned int textures[2])
         vpR.Size.w = tscDesc.Width;
         vpR.Size.h = tscDesc.Height;
         ovr_CreateTextureSwapChainGL(QVROculus, &tscDesc, &QVROculusTextureSwapChainR);
-        ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainL, 0, &(_textures[0]));
-        ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainR, 0, &(_textures[1]));
+        ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainL, 0, &(tex[0]));
+        ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainR, 0, &(tex[1]));
         QVROculusLayer.Header.Type = ovrLayerType_EyeFov;
         QVROculusLayer.Header.Flags = ovrLayerFlag_TextureOriginAtBottomLeft;
         QVROculusLayer.ColorTexture[0] = QVROculusTextureSwapChainL;
@@ -790,101 +1470,144 @@ void QVRWindow::getTextures(unsigned int textures[2])
         QVROculusLayer.Fov[1] = QVROculusEyeRenderDesc[1].Fov;
         QVROculusLayer.Viewport[0] = vpL;
         QVROculusLayer.Viewport[1] = vpR;
-        _textureWidths[0] = vpL.Size.w;
-        _textureHeights[0] = vpL.Size.h;
-        _textureWidths[1] = vpR.Size.w;
-        _textureHeights[1] = vpR.Size.h;
+        texWidths[0] = vpL.Size.w;
+        texHeights[0] = vpL.Size.h;
+        texWidths[1] = vpR.Size.w;
+        texHeights[1] = vpR.Size.h;
     }
 #endif
-    for (int i = 0; i < _renderContext.viewCount(); i++) {
-        if (_textures[i] == 0) {
-            _textureWidths[i] = -1;
-            _textureHeights[i] = -1;
-            _gl->glGenTextures(1, &(_textures[i]));
-            _gl->glBindTexture(GL_TEXTURE_2D, _textures[i]);
-            bool wantBilinearInterpolation = true;
-            if (std::abs(config().renderResolutionFactor() - 1.0f) <= 0.0f
-                    && (config().outputMode() == QVR_Output_Center
-                        || config().outputMode() == QVR_Output_Left
-                        || config().outputMode() == QVR_Output_Right
-                        || config().outputMode() == QVR_Output_Stereo
-                        || config().outputMode() == QVR_Output_Red_Cyan
-                        || config().outputMode() == QVR_Output_Green_Magenta
-                        || config().outputMode() == QVR_Output_Amber_Blue
-                        || config().outputMode() == QVR_Output_GoogleVR)) {
-                wantBilinearInterpolation = false;
-            }
-            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, wantBilinearInterpolation ? GL_LINEAR : GL_NEAREST);
-            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, wantBilinearInterpolation ? GL_LINEAR : GL_NEAREST);
-            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // View textures come from the process-wide pool. When the required size
+    // changes, the old texture goes back to the pool for later reuse, e.g. when
+    // the window returns to its previous size.
+    bool wantBilinearInterpolation = true;
+    if (std::abs(config().renderResolutionFactor() - 1.0f) <= 0.0f
+            && (config().outputMode() == QVR_Output_Center
+                || config().outputMode() == QVR_Output_Offscreen
+                || config().outputMode() == QVR_Output_Left
+                || config().outputMode() == QVR_Output_Right
+                || config().outputMode() == QVR_Output_Stereo
+                || config().outputMode() == QVR_Output_Red_Cyan
+                || config().outputMode() == QVR_Output_Green_Magenta
+                || config().outputMode() == QVR_Output_Amber_Blue
+                || config().outputMode() == QVR_Output_GoogleVR)) {
+        wantBilinearInterpolation = false;
+    }
+    if (_layeredViews) {
+        // All views are layers of a single 2D array texture. Layered views
+        // are restricted to output modes in which all views have the window size.
+        int w = width() * devicePixelRatio() * config().renderResolutionFactor();
+        int h = height() * devicePixelRatio() * config().renderResolutionFactor();
+        if (tex[0] == 0 || texWidths[0] != w || texHeights[0] != h) {
+            unsigned int oldTex = tex[0];
+            tex[0] = QVRViewTexturePool->acquire(GL_TEXTURE_2D_ARRAY, GL_SRGB8_ALPHA8,
+                    w, h, _renderContext.viewCount());
+            if (oldTex != 0)
+                QVRViewTexturePool->release(oldTex);
+            _gl->glBindTexture(GL_TEXTURE_2D_ARRAY, tex[0]);
+            _gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, wantBilinearInterpolation ? GL_LINEAR : GL_NEAREST);
+            _gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, wantBilinearInterpolation ? GL_LINEAR : GL_NEAREST);
+            _gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            _gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            texWidths[0] = w;
+            texHeights[0] = h;
         }
-        int w = 0, h = 0;
-        if (config().outputMode() == QVR_Output_Oculus) {
+        for (int i = 0; i < _renderContext.viewCount(); i++)
+            _renderContext.setTextureSize(i, QSize(texWidths[0], texHeights[0]));
+    } else {
+        for (int i = 0; i < _renderContext.viewCount(); i++) {
+            int w = 0, h = 0;
+            if (config().outputMode() == QVR_Output_Oculus) {
 #ifdef HAVE_OCULUS
 # if (OVR_PRODUCT_VERSION >= 1)
-            // we already created the textures before this loop, make sure that we don't do
-            // anything inside this loop.
-            w = _textureWidths[i];
-            h = _textureHeights[i];
+                // we already created the textures before this loop, make sure that we don't do
+                // anything inside this loop.
+                w = texWidths[i];
+                h = texHeights[i];
 # else
-            ovrSizei tex_size = ovrHmd_GetFovTextureSize(QVROculus,
-                    i == 0 ? ovrEye_Left : ovrEye_Right,
-                    QVROculus->DefaultEyeFov[i], 1.0f);
-            w = tex_size.w * config().renderResolutionFactor();
-            h = tex_size.h * config().renderResolutionFactor();
-            _thread->oculusEyeTextures[i].OGL.Header.API = ovrRenderAPI_OpenGL;
-            _thread->oculusEyeTextures[i].OGL.Header.TextureSize.w = w;
-            _thread->oculusEyeTextures[i].OGL.Header.TextureSize.h = h;
-            _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Pos.x = 0;
-            _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Pos.y = 0;
-            _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Size.w = w;
-            _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Size.h = h;
-            _thread->oculusEyeTextures[i].OGL.TexId = _textures[i];
+                ovrSizei tex_size = ovrHmd_GetFovTextureSize(QVROculus,
+                        i == 0 ? ovrEye_Left : ovrEye_Right,
+                        QVROculus->DefaultEyeFov[i], 1.0f);
+                w = tex_size.w * config().renderResolutionFactor();
+                h = tex_size.h * config().renderResolutionFactor();
 # endif
 #endif
-        } else if (config().outputMode() == QVR_Output_OpenVR) {
+            } else if (config().outputMode() == QVR_Output_OpenVR) {
 #ifdef HAVE_OPENVR
-            uint32_t openVrW, openVrH;
-            QVROpenVRSystem->GetRecommendedRenderTargetSize(&openVrW, &openVrH);
-            w = openVrW * config().renderResolutionFactor();
-            h = openVrH * config().renderResolutionFactor();
+                uint32_t openVrW, openVrH;
+                QVROpenVRSystem->GetRecommendedRenderTargetSize(&openVrW, &openVrH);
+                w = openVrW * config().renderResolutionFactor();
+                h = openVrH * config().renderResolutionFactor();
 #endif
-        } else if (config().outputMode() == QVR_Output_GoogleVR) {
+            } else if (config().outputMode() == QVR_Output_GoogleVR) {
 #ifdef ANDROID
-            w = QVRGoogleVRTexSize.width();
-            h = QVRGoogleVRTexSize.height();
+                w = QVRGoogleVRTexSize.width();
+                h = QVRGoogleVRTexSize.height();
 #endif
-        } else {
-            w = width() * devicePixelRatio() * config().renderResolutionFactor();
-            h = height() * devicePixelRatio() * config().renderResolutionFactor();
-        }
-        if (_textureWidths[i] != w || _textureHeights[i] != h) {
-            bool wantSRGB = true;
-            if (config().outputMode() == QVR_Output_OpenVR) {
-                // 2016-11-03: OpenVR cannot seem to handle SRGB textures; neither
-                // ColorSpace_Linear nor ColorSpace_Gamma give correct rendering
-                // results. So fall back to linear textures.
-                wantSRGB = false;
-            }
-            _gl->glBindTexture(GL_TEXTURE_2D, _textures[i]);
-            _gl->glTexImage2D(GL_TEXTURE_2D, 0,
-                    wantSRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8,
-                    w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-            _textureWidths[i] = w;
-            _textureHeights[i] = h;
+            } else {
+                w = width() * devicePixelRatio() * config().renderResolutionFactor();
+                h = height() * devicePixelRatio() * config().renderResolutionFactor();
+            }
+            if (tex[i] == 0 || texWidths[i] != w || texHeights[i] != h) {
+                bool wantSRGB = true;
+                if (config().outputMode() == QVR_Output_OpenVR) {
+                    // 2016-11-03: OpenVR cannot seem to handle SRGB textures; neither
+                    // ColorSpace_Linear nor ColorSpace_Gamma give correct rendering
+                    // results. So fall back to linear textures.
+                    wantSRGB = false;
+                }
+                unsigned int oldTex = tex[i];
+                tex[i] = QVRViewTexturePool->acquire(GL_TEXTURE_2D,
+                        wantSRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8, w, h);
+                if (oldTex != 0)
+                    QVRViewTexturePool->release(oldTex);
+                _gl->glBindTexture(GL_TEXTURE_2D, tex[i]);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, wantBilinearInterpolation ? GL_LINEAR : GL_NEAREST);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, wantBilinearInterpolation ? GL_LINEAR : GL_NEAREST);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                texWidths[i] = w;
+                texHeights[i] = h;
+#if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION < 1)
+                if (config().outputMode() == QVR_Output_Oculus) {
+                    _thread->oculusEyeTextures[i].OGL.Header.API = ovrRenderAPI_OpenGL;
+                    _thread->oculusEyeTextures[i].OGL.Header.TextureSize.w = w;
+                    _thread->oculusEyeTextures[i].OGL.Header.TextureSize.h = h;
+                    _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Pos.x = 0;
+                    _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Pos.y = 0;
+                    _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Size.w = w;
+                    _thread->oculusEyeTextures[i].OGL.Header.RenderViewport.Size.h = h;
+                    _thread->oculusEyeTextures[i].OGL.TexId = tex[i];
+                }
+#endif
+                if (_reprojection == QVR_Reprojection_Depth || _upscaler) {
+                    unsigned int oldDepthTex = _depthTextures[_renderSet][i];
+                    _depthTextures[_renderSet][i] = QVRViewTexturePool->acquire(GL_TEXTURE_2D,
+                            GL_DEPTH_COMPONENT32F, w, h);
+                    if (oldDepthTex != 0)
+                        QVRViewTexturePool->release(oldDepthTex);
+                    _gl->glBindTexture(GL_TEXTURE_2D, _depthTextures[_renderSet][i]);
+                    _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                    _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                    _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                }
+            }
+            _renderContext.setTextureSize(i, QSize(texWidths[i], texHeights[i]));
         }
-        _renderContext.setTextureSize(i, QSize(_textureWidths[i], _textureHeights[i]));
     }
-    if (_renderContext.viewCount() == 1 && _textures[1] != 0) {
-        _gl->glDeleteTextures(1, &(_textures[1]));
-        _textures[1] = 0;
-        _textureWidths[1] = -1;
-        _textureHeights[1] = -1;
+    if (_renderContext.viewCount() == 1 && tex[1] != 0) {
+        QVRViewTexturePool->release(tex[1]);
+        tex[1] = 0;
+        texWidths[1] = -1;
+        texHeights[1] = -1;
         _renderContext.setTextureSize(1, QSize(-1, -1));
+        if (_depthTextures[_renderSet][1] != 0) {
+            QVRViewTexturePool->release(_depthTextures[_renderSet][1]);
+            _depthTextures[_renderSet][1] = 0;
+        }
     }
-    textures[0] = _textures[0];
-    textures[1] = _textures[1];
+    textures[0] = tex[0];
+    textures[1] = tex[1];
 #if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION >= 1)
     if (config().outputMode() == QVR_Output_Oculus) {
         ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainL, -1, &(textures[0]));
@@ -893,6 +1616,321 @@ void QVRWindow::getTextures(unsigned int textures[2])
 #endif
 
     _gl->glBindTexture(GL_TEXTURE_2D, textureBinding2dBak);
+    _gl->glBindTexture(GL_TEXTURE_2D_ARRAY, textureBinding2dArrayBak);
+
+    if (isTiled()) {
+        // The application renders our tile only; see compositeTiles()
+        getTileTextures(textures);
+    }
+}
+
+void QVRWindow::getTileTextures(unsigned int textures[2])
+{
+    Q_ASSERT(isTiled());
+    Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
+    Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
+
+    GLint textureBinding2dBak;
+    _gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding2dBak);
+    int w = qMax(_tileX1 - _tileX0, 1);
+    int h = qMax(_tileFullSize.height(), 1);
+    for (int i = 0; i < _renderContext.viewCount(); i++) {
+        if (_tileTextures[i] == 0 || _tileTextureWidths[i] != w || _tileTextureHeights[i] != h) {
+            unsigned int oldTex = _tileTextures[i];
+            _tileTextures[i] = QVRViewTexturePool->acquire(GL_TEXTURE_2D, GL_SRGB8_ALPHA8, w, h);
+            if (oldTex != 0)
+                QVRViewTexturePool->release(oldTex);
+            _gl->glBindTexture(GL_TEXTURE_2D, _tileTextures[i]);
+            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            if (isSortLast()) {
+                unsigned int oldDepthTex = _tileDepthTextures[i];
+                _tileDepthTextures[i] = QVRViewTexturePool->acquire(GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F, w, h);
+                if (oldDepthTex != 0)
+                    QVRViewTexturePool->release(oldDepthTex);
+                _gl->glBindTexture(GL_TEXTURE_2D, _tileDepthTextures[i]);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            }
+            _tileTextureWidths[i] = w;
+            _tileTextureHeights[i] = h;
+        }
+        _renderContext.setTextureSize(i, QSize(w, h));
+        textures[i] = _tileTextures[i];
+    }
+    if (_renderContext.viewCount() == 1) {
+        if (_tileTextures[1] != 0) {
+            QVRViewTexturePool->release(_tileTextures[1]);
+            if (_tileDepthTextures[1] != 0)
+                QVRViewTexturePool->release(_tileDepthTextures[1]);
+            _tileTextures[1] = 0;
+            _tileDepthTextures[1] = 0;
+            _tileTextureWidths[1] = -1;
+            _tileTextureHeights[1] = -1;
+            _renderContext.setTextureSize(1, QSize(-1, -1));
+        }
+        textures[1] = 0;
+    }
+    _gl->glBindTexture(GL_TEXTURE_2D, textureBinding2dBak);
+}
+
+/* Tiles and streamed frames are transferred as a header (render time in
+ * seconds, frame number, number of views, and the rectangle x, y, width,
+ * height within the window) followed by the RGBA pixels of each view, bottom
+ * row first, and for sort-last compositing the float depth values of each
+ * view. The pixels are the raw sRGB-encoded texture values, so sRGB conversion
+ * is disabled during the transfers. */
+
+static const int QVRTileHeaderSize = sizeof(float) + 6 * sizeof(int);
+
+QRect QVRWindow::tileTransferRect() const
+{
+    Q_ASSERT(isProxy());
+
+    if (!_isRendered)
+        return QRect();
+    return (isSortLast() ? _tileRect : QRect(_tileX0, 0, _tileX1 - _tileX0, _tileFullSize.height()));
+}
+
+/* The tile of a proxy is read back into a pixel pack buffer right after it
+ * was rendered, and only readTile() waits for the readback to complete, so
+ * that the CPU does not stall while the GPU is still rendering. */
+
+void QVRWindow::startTileReadback()
+{
+    Q_ASSERT(isProxy());
+    Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
+    Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
+    Q_ASSERT(!_tileFence);
+
+    QRect rect = tileTransferRect();
+    int viewCount = _renderContext.viewCount();
+    int colorSize = rect.width() * rect.height() * 4;
+    int depthSize = (isSortLast() ? rect.width() * rect.height() * int(sizeof(float)) : 0);
+    int viewSize = colorSize + depthSize;
+    if (viewCount * viewSize == 0)
+        return;
+
+    GLint framebufferBak;
+    _gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferBak);
+#ifdef GL_FRAMEBUFFER_SRGB
+    _gl->glDisable(GL_FRAMEBUFFER_SRGB);
+#endif
+    if (_tileFbo == 0)
+        _gl->glGenFramebuffers(1, &_tileFbo);
+    _gl->glBindFramebuffer(GL_FRAMEBUFFER, _tileFbo);
+    _gl->glReadBuffer(GL_COLOR_ATTACHMENT0);
+    if (_tilePbo == 0)
+        _gl->glGenBuffers(1, &_tilePbo);
+    _gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, _tilePbo);
+    if (_tilePboSize < viewCount * viewSize) {
+        _tilePboSize = viewCount * viewSize;
+        _gl->glBufferData(GL_PIXEL_PACK_BUFFER, _tilePboSize, NULL, GL_STREAM_READ);
+    }
+    _gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // The buffer has the layout of the view data in the tile transfer.
+    // The tile textures begin at column _tileX0 of the tiled window.
+    int x = rect.x() - _tileX0;
+    for (int i = 0; i < viewCount; i++) {
+        _gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _tileTextures[i], 0);
+        _gl->glReadPixels(x, rect.y(), rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                reinterpret_cast<void*>(quintptr(i * viewSize)));
+        if (depthSize > 0) {
+            _gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _tileDepthTextures[i], 0);
+            _gl->glReadPixels(x, rect.y(), rect.width(), rect.height(), GL_DEPTH_COMPONENT, GL_FLOAT,
+                    reinterpret_cast<void*>(quintptr(i * viewSize + colorSize)));
+        }
+    }
+    if (depthSize > 0)
+        _gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    _gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#ifdef GL_FRAMEBUFFER_SRGB
+    _gl->glEnable(GL_FRAMEBUFFER_SRGB);
+#endif
+    _gl->glBindFramebuffer(GL_FRAMEBUFFER, framebufferBak);
+    _tileFence = _gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void QVRWindow::readTile(QByteArray* tileData)
+{
+    Q_ASSERT(isProxy());
+    Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
+    Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
+
+    QRect rect = tileTransferRect();
+    int header[6] = { int(QVRFrameCounter), _renderContext.viewCount(),
+        rect.x(), rect.y(), rect.width(), rect.height() };
+    int colorSize = rect.width() * rect.height() * 4;
+    int depthSize = (isSortLast() ? rect.width() * rect.height() * int(sizeof(float)) : 0);
+    int viewSize = colorSize + depthSize;
+    bool haveData = false;
+    if (_tileFence) {
+        // The render time ends when the readback is complete
+        GLsync fence = static_cast<GLsync>(_tileFence);
+        GLenum r;
+        while ((r = _gl->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000)) == GL_TIMEOUT_EXPIRED)
+            ;
+        _tileRenderTime = (QVRTimer.nsecsElapsed() - _tileRenderStart) / 1e9f;
+        _gl->glDeleteSync(fence);
+        _tileFence = NULL;
+        haveData = (r != GL_WAIT_FAILED);
+    }
+    if (!haveData && viewSize > 0) {
+        // the readback failed; the main process ignores this tile
+        header[1] = 0;
+    }
+    tileData->resize(QVRTileHeaderSize + header[1] * viewSize);
+    std::memcpy(tileData->data(), &_tileRenderTime, sizeof(float));
+    std::memcpy(tileData->data() + sizeof(float), header, sizeof(header));
+    if (!haveData)
+        return;
+
+    _gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, _tilePbo);
+    const char* pboData = static_cast<const char*>(_gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                0, header[1] * viewSize, GL_MAP_READ_BIT));
+    if (pboData) {
+        std::memcpy(tileData->data() + QVRTileHeaderSize, pboData, header[1] * viewSize);
+        _gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        QVR_WARNING("window %s: cannot map tile readback buffer", qPrintable(id()));
+    }
+    _gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void QVRWindow::compositeTiles(const QVector<QByteArray>& tileData)
+{
+    Q_ASSERT(_tileBalancer);
+    Q_ASSERT(tileData.size() == _tileBalancer->tiles() - 1);
+    Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
+    Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
+
+    const unsigned int* tex = _textures[_renderSet];
+    int viewCount = _renderContext.viewCount();
+    int h = _tileFullSize.height();
+    QRect fullRect(QPoint(0, 0), _tileFullSize);
+    QVector<float> renderTimes(_tileBalancer->tiles());
+    renderTimes[0] = _tileRenderTime;
+
+    if (isSortLast() && !_tileCompositor) {
+        _tileCompositor = new QVRDepthCompositor;
+        if (!_tileCompositor->initGL()) {
+            QVR_WARNING("window %s: cannot initialize depth compositing", qPrintable(id()));
+            _tileCompositor->exitGL();
+        }
+    }
+
+    GLint framebufferBak, textureBinding2dBak;
+    _gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferBak);
+    _gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding2dBak);
+#ifdef GL_FRAMEBUFFER_SRGB
+    _gl->glDisable(GL_FRAMEBUFFER_SRGB);
+#endif
+    // Our own tile
+    if (_tileFbo == 0)
+        _gl->glGenFramebuffers(1, &_tileFbo);
+    _gl->glBindFramebuffer(GL_FRAMEBUFFER, _tileFbo);
+    _gl->glReadBuffer(GL_COLOR_ATTACHMENT0);
+    for (int i = 0; i < viewCount; i++) {
+        _gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _tileTextures[i], 0);
+        _gl->glBindTexture(GL_TEXTURE_2D, tex[i]);
+        _gl->glCopyTexSubImage2D(GL_TEXTURE_2D, 0, _tileX0, 0, 0, 0, _tileX1 - _tileX0, h);
+    }
+    _gl->glBindTexture(GL_TEXTURE_2D, textureBinding2dBak);
+    _gl->glBindFramebuffer(GL_FRAMEBUFFER, framebufferBak);
+    // The tiles of the helper processes
+    _gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int k = 1; k < _tileBalancer->tiles(); k++) {
+        const QByteArray& data = tileData[k - 1];
+        int header[6] = { 0, 0, 0, 0, 0, 0 };
+        if (data.size() >= QVRTileHeaderSize) {
+            std::memcpy(&(renderTimes[k]), data.constData(), sizeof(float));
+            std::memcpy(header, data.constData() + sizeof(float), sizeof(header));
+        }
+        QRect rect(header[2], header[3], header[4], header[5]);
+        QRect expectedRect = rect;
+        if (!isSortLast())
+            expectedRect = QRect(_tileBounds[k], 0, _tileBounds[k + 1] - _tileBounds[k], h);
+        if (expectedRect.isEmpty() && rect.isEmpty())
+            continue;
+        int colorSize = rect.width() * rect.height() * 4;
+        int depthSize = (isSortLast() ? rect.width() * rect.height() * int(sizeof(float)) : 0);
+        int viewSize = colorSize + depthSize;
+        if (header[0] != int(QVRFrameCounter) || header[1] != viewCount
+                || rect != expectedRect || !fullRect.contains(rect)
+                || data.size() != QVRTileHeaderSize + viewCount * viewSize) {
+            QVR_WARNING("window %s: ignoring invalid tile %d", qPrintable(id()), k);
+            renderTimes[k] = 0.0f;
+            continue;
+        }
+        for (int i = 0; i < viewCount; i++) {
+            const char* viewData = data.constData() + QVRTileHeaderSize + i * viewSize;
+            if (isSortLast()) {
+                _tileCompositor->composite(tex[i], _tileDepthTextures[i], rect,
+                        reinterpret_cast<const unsigned char*>(viewData),
+                        reinterpret_cast<const float*>(viewData + colorSize));
+            } else {
+                _gl->glBindTexture(GL_TEXTURE_2D, tex[i]);
+                _gl->glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                        GL_RGBA, GL_UNSIGNED_BYTE, viewData);
+            }
+        }
+    }
+#ifdef GL_FRAMEBUFFER_SRGB
+    _gl->glEnable(GL_FRAMEBUFFER_SRGB);
+#endif
+    _gl->glBindTexture(GL_TEXTURE_2D, textureBinding2dBak);
+
+    // In sort-last mode, all processes render the whole window
+    if (!isSortLast())
+        _tileBalancer->update(renderTimes);
+}
+
+bool QVRWindow::setStreamFrame(const QByteArray& frameData)
+{
+    Q_ASSERT(isStreamTarget());
+    Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
+    Q_ASSERT(QOpenGLContext::currentContext() != _winContext);
+
+    const unsigned int* tex = _textures[_renderSet];
+    int viewCount = _renderContext.viewCount();
+    int header[6] = { 0, 0, 0, 0, 0, 0 };
+    if (frameData.size() >= QVRTileHeaderSize)
+        std::memcpy(header, frameData.constData() + sizeof(float), sizeof(header));
+    QRect rect(header[2], header[3], header[4], header[5]);
+    if (rect.isEmpty()) {
+        // The main process does not know the size of this window yet
+        return false;
+    }
+    int viewSize = rect.width() * rect.height() * 4;
+    if (header[0] != int(QVRFrameCounter) || header[1] != viewCount
+            || frameData.size() != QVRTileHeaderSize + viewCount * viewSize) {
+        QVR_WARNING("window %s: ignoring invalid streamed frame %d in frame %u",
+                qPrintable(id()), header[0], QVRFrameCounter);
+        return false;
+    }
+    for (int i = 0; i < viewCount; i++) {
+        if (rect != QRect(0, 0, _textureWidths[_renderSet][i], _textureHeights[_renderSet][i])) {
+            // This happens for one frame after the window was resized
+            QVR_DEBUG("window %s: ignoring streamed frame of outdated size %dx%d",
+                    qPrintable(id()), rect.width(), rect.height());
+            return false;
+        }
+    }
+
+    GLint textureBinding2dBak;
+    _gl->glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureBinding2dBak);
+    _gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int i = 0; i < viewCount; i++) {
+        _gl->glBindTexture(GL_TEXTURE_2D, tex[i]);
+        _gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                frameData.constData() + QVRTileHeaderSize + i * viewSize);
+    }
+    _gl->glBindTexture(GL_TEXTURE_2D, textureBinding2dBak);
+    return true;
 }
 
 void QVRWindow::renderOutput()
@@ -902,30 +1940,139 @@ void QVRWindow::renderOutput()
     Q_ASSERT(QThread::currentThread() == _thread);
     Q_ASSERT(QOpenGLContext::currentContext() == _winContext);
 
-    unsigned int tex0 = _textures[0];
-    unsigned int tex1 = _textures[1];
+    int set = (_textureSets > 1 ? _thread->presentSet : 0);
+    const QVRRenderContext& context = (_textureSets > 1 ? _setContexts[set] : _renderContext);
+
+    if (_renderFences[set]) {
+        // Wait until the main thread's rendering into our textures is complete.
+        // Normally the GPU can do that on its own, but the Oculus and OpenVR
+        // runtimes consume the textures outside of our OpenGL command stream.
+        GLsync fence = static_cast<GLsync>(_renderFences[set]);
+        if (config().outputMode() == QVR_Output_Oculus || config().outputMode() == QVR_Output_OpenVR) {
+            while (_gl->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                ;
+        } else {
+            _gl->glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+        }
+        _gl->glDeleteSync(fence);
+        _renderFences[set] = NULL;
+    }
+
+    if (config().outputMode() == QVR_Output_Offscreen) {
+        // There is no window surface; keep the output in an FBO instead
+        int w = width() * devicePixelRatio();
+        int h = height() * devicePixelRatio();
+        if (_offscreenFbo == 0) {
+            _gl->glGenFramebuffers(1, &_offscreenFbo);
+            _gl->glGenTextures(1, &_offscreenTex);
+        }
+        if (_offscreenWidth != w || _offscreenHeight != h) {
+            _gl->glBindTexture(GL_TEXTURE_2D, _offscreenTex);
+            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            _gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            // same values that an on-screen window would show
+            _gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8,
+                    w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            _gl->glBindFramebuffer(GL_FRAMEBUFFER, _offscreenFbo);
+            _gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                    GL_TEXTURE_2D, _offscreenTex, 0);
+            _offscreenWidth = w;
+            _offscreenHeight = h;
+        }
+        _gl->glBindFramebuffer(GL_FRAMEBUFFER, _offscreenFbo);
+    }
+
+    unsigned int tex0 = _textures[set][0];
+    unsigned int tex1 = _textures[set][1];
 #if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION >= 1)
     if (config().outputMode() == QVR_Output_Oculus) {
         ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainL, -1, &tex0);
         ovr_GetTextureSwapChainBufferGL(QVROculus, QVROculusTextureSwapChainR, -1, &tex1);
     }
 #endif
+    if (_upscaler) {
+        // Present the accumulated views at the output resolution instead
+        unsigned int views[2] = { tex0, tex1 };
+        _upscaler->accumulate(context, views, _depthTextures[set],
+                width() * devicePixelRatio(), height() * devicePixelRatio());
+        tex0 = _upscaler->texture(0);
+        tex1 = _upscaler->texture(1);
+    }
     if (!config().outputPlugin().isEmpty()) {
         unsigned int texs[2] = { tex0, tex1 };
-        _outputPluginFunc(this, _renderContext, texs);
+        _outputPluginFunc(this, context, texs);
 #if defined(HAVE_OCULUS) && (OVR_PRODUCT_VERSION < 1)
     } else if (config().outputMode() == QVR_Output_Oculus) {
         // do nothing here, the output is done by ovrHmd_EndFrame()
 #endif
     } else {
+        // Reproject the views if the presented set is older than the newest pose
+        int reprojection = QVR_Reprojection_None;
+        QMatrix4x4 reprojRot[2], reprojFull[2];
+        if (_reprojection != QVR_Reprojection_None) {
+            _thread->ringMutex.lock();
+            QVRRenderContext latestContext = _latestContext;
+            QVRPoseSample frameSample;
+            if (_poseTracker)
+                frameSample = _poseTracker->frameSample();
+            _thread->ringMutex.unlock();
+            if (frameSample.valid) {
+                // The main thread does not update the pose while the application
+                // renders, so get the pose at present time here
+                QVector3D pos;
+                QQuaternion rot;
+                _poseTracker->currentPose(frameSample, &pos, &rot);
+                applyPoseChange(latestContext, frameSample.position, frameSample.orientation, pos, rot);
+            }
+            for (int i = 0; i < context.viewCount() && latestContext.viewCount() == context.viewCount(); i++) {
+                QMatrix4x4 oldP = context.frustum(i).toMatrix4x4();
+                QMatrix4x4 newP = latestContext.frustum(i).toMatrix4x4();
+                QMatrix4x4 oldV = context.viewMatrix(i);
+                QMatrix4x4 newV = latestContext.viewMatrix(i);
+                if (newP * newV != oldP * oldV) {
+                    reprojection = (_reprojection == QVR_Reprojection_Depth && _depthTextures[set][0] != 0
+                            ? QVR_Reprojection_Depth : QVR_Reprojection_Rotation);
+                }
+                // Points at infinity only depend on the orientation
+                QMatrix4x4 oldR = oldV;
+                QMatrix4x4 newR = newV;
+                oldR.setColumn(3, QVector4D(0.0f, 0.0f, 0.0f, 1.0f));
+                newR.setColumn(3, QVector4D(0.0f, 0.0f, 0.0f, 1.0f));
+                reprojRot[i] = oldP * oldR * newR.inverted() * newP.inverted();
+                reprojFull[i] = newP * newV * (oldP * oldV).inverted();
+            }
+        }
         _gl->glDisable(GL_DEPTH_TEST);
         _gl->glUseProgram(_outputPrg->programId());
-        _gl->glActiveTexture(GL_TEXTURE0);
-        _gl->glBindTexture(GL_TEXTURE_2D, tex0);
         _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "tex_l"), 0);
         _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "tex_r"), 0);
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "tex_layers"), 2);
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "layered"), _layeredViews ? 1 : 0);
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "layer_l"), 0);
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "layer_r"), 1);
         _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "output_mode"), config().outputMode());
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "reprojection"), reprojection);
+        _gl->glUniformMatrix4fv(_gl->glGetUniformLocation(_outputPrg->programId(), "reproj_rot_l"), 1, GL_FALSE, reprojRot[0].constData());
+        _gl->glUniformMatrix4fv(_gl->glGetUniformLocation(_outputPrg->programId(), "reproj_rot_r"), 1, GL_FALSE, reprojRot[1].constData());
+        _gl->glUniformMatrix4fv(_gl->glGetUniformLocation(_outputPrg->programId(), "reproj_full_l"), 1, GL_FALSE, reprojFull[0].constData());
+        _gl->glUniformMatrix4fv(_gl->glGetUniformLocation(_outputPrg->programId(), "reproj_full_r"), 1, GL_FALSE, reprojFull[1].constData());
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "depth_l"), 3);
+        _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "depth_r"), 4);
         _gl->glBindVertexArray(_outputQuadVao);
+        if (reprojection == QVR_Reprojection_Depth) {
+            _gl->glActiveTexture(GL_TEXTURE3);
+            _gl->glBindTexture(GL_TEXTURE_2D, _depthTextures[set][0]);
+            _gl->glActiveTexture(GL_TEXTURE4);
+            _gl->glBindTexture(GL_TEXTURE_2D, _depthTextures[set][1]);
+        }
+        if (_layeredViews) {
+            // the 2D samplers and the array sampler must use different units
+            _gl->glActiveTexture(GL_TEXTURE2);
+            _gl->glBindTexture(GL_TEXTURE_2D_ARRAY, tex0);
+        } else {
+            _gl->glActiveTexture(GL_TEXTURE0);
+            _gl->glBindTexture(GL_TEXTURE_2D, tex0);
+        }
         if (tex1 != 0) {
             _gl->glActiveTexture(GL_TEXTURE1);
             _gl->glBindTexture(GL_TEXTURE_2D, tex1);
@@ -941,8 +2088,15 @@ void QVRWindow::renderOutput()
         _gl->glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         if (config().outputMode() == QVR_Output_Stereo) {
 #ifdef GL_BACK_RIGHT
-            _gl->glActiveTexture(GL_TEXTURE0);
-            _gl->glBindTexture(GL_TEXTURE_2D, tex1);
+            if (_layeredViews) {
+                _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "layer_l"), 1);
+            } else {
+                _gl->glActiveTexture(GL_TEXTURE0);
+                _gl->glBindTexture(GL_TEXTURE_2D, tex1);
+            }
+            _gl->glUniformMatrix4fv(_gl->glGetUniformLocation(_outputPrg->programId(), "reproj_rot_l"), 1, GL_FALSE, reprojRot[1].constData());
+            _gl->glUniformMatrix4fv(_gl->glGetUniformLocation(_outputPrg->programId(), "reproj_full_l"), 1, GL_FALSE, reprojFull[1].constData());
+            _gl->glUniform1i(_gl->glGetUniformLocation(_outputPrg->programId(), "depth_l"), 4);
             GLenum buf = GL_BACK_RIGHT;
             _gl->glDrawBuffers(1, &buf);
             _gl->glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -957,6 +2111,47 @@ void QVRWindow::renderOutput()
 #endif
         }
     }
+
+    if (_capture) {
+        GLuint outputFbo = (config().outputMode() == QVR_Output_Offscreen
+                ? _offscreenFbo : _winContext->defaultFramebufferObject());
+        if (config().captureMode() == QVR_Capture_Output) {
+            // Read back what the window shows (the left buffer in stereo mode)
+            _gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, outputFbo);
+            if (config().outputMode() == QVR_Output_Offscreen) {
+                _gl->glReadBuffer(GL_COLOR_ATTACHMENT0);
+#ifdef GL_BACK_LEFT
+            } else if (config().outputMode() == QVR_Output_Stereo) {
+                _gl->glReadBuffer(GL_BACK_LEFT);
+#endif
+            } else {
+                _gl->glReadBuffer(GL_BACK);
+            }
+            _capture->capture(0, width() * devicePixelRatio(), height() * devicePixelRatio());
+        } else {
+            if (_captureFbo == 0)
+                _gl->glGenFramebuffers(1, &_captureFbo);
+            _gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, _captureFbo);
+            _gl->glReadBuffer(GL_COLOR_ATTACHMENT0);
+            for (int v = 0; v < context.viewCount(); v++) {
+                if (_layeredViews) {
+                    _gl->glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex0, 0, v);
+                } else {
+                    _gl->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_TEXTURE_2D, v == 0 ? tex0 : tex1, 0);
+                }
+                // The render context has the tile size for tiled windows, so use the texture size;
+                // upscaled views have the size of the upscaler output instead
+                if (_upscaler) {
+                    _capture->capture(v, _upscaler->width(), _upscaler->height());
+                } else {
+                    int t = (_layeredViews ? 0 : v);
+                    _capture->capture(v, _textureWidths[set][t], _textureHeights[set][t]);
+                }
+            }
+        }
+        _gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, outputFbo);
+    }
 }
 
 void QVRWindow::keyPressEvent(QKeyEvent* event)
@@ -33,9 +33,15 @@
 
 class QVRObserver;
 class QVRWindowThread;
+class QVRCapture;
+class QVRTileBalancer;
+class QVRDepthCompositor;
+class QVRTemporalUpscaler;
+class QVRPoseTracker;
 class QOpenGLShaderProgram;
 class QOpenGLContext;
 class QOpenGLExtraFunctions;
+class QOffscreenSurface;
 
 /*!
  * \brief A Qt window on a screen and a window into the virtual world
@@ -71,8 +77,42 @@ private:
     QVRWindowThread* _thread;
     QVRObserver* _observer;
     int _windowIndex;
-    unsigned int _textures[2];
-    int _textureWidths[2], _textureHeights[2];
+    int _textureSets;   // number of view texture sets in use (1 to 3)
+    int _renderSet;     // the set that the application currently renders into
+    unsigned int _textures[3][2];
+    int _textureWidths[3][2], _textureHeights[3][2];
+    bool _layeredViews; // whether _textures[s][0] is a 2D array texture with one layer per view
+    void* _renderFences[3]; // GLsyncs that signal when rendering into a set is complete
+    QVRRenderContext _setContexts[3]; // render contexts of published sets (only with more than one set)
+    QVRReprojection _reprojection; // reprojection of re-presented sets (only with more than one set)
+    unsigned int _depthTextures[3][2]; // only for depth-based reprojection and upscaling: depth textures of all sets
+    QVRRenderContext _latestContext; // newest render context, protected by the ring mutex (only with reprojection)
+    QVRPoseTracker* _poseTracker; // only with reprojection for device-tracked observers: poses at present time
+    bool _isRendered;   // whether the application renders into this window in the current frame
+    QVRWindow* _sharedPresenter; // main window only: the window that owns the single presentation thread
+    QOffscreenSurface* _offscreenSurface; // only for offscreen output
+    unsigned int _offscreenFbo, _offscreenTex; // output target for offscreen output
+    int _offscreenWidth, _offscreenHeight;
+    QVRCapture* _capture; // only if capturing is enabled
+    unsigned int _captureFbo; // read framebuffer for capturing views
+    QVRTemporalUpscaler* _upscaler; // only if temporal upscaling is enabled
+    // Sort-first and sort-last tiling, see QVRWindowConfig::tileProcessIds()
+    QVRTileBalancer* _tileBalancer; // only for tiled windows
+    QVector<int> _tileBounds;       // only for tiled windows: pixel columns of all tiles
+    int _tileX0, _tileX1;           // pixel columns of the tile that this process renders
+    QSize _tileFullSize;            // size of the view textures of the tiled window
+    QVector3D _tileWall[3];         // only for proxies: screen wall of the tiled or display-only window
+    unsigned int _tileTextures[2];  // tile-sized textures that the application renders into
+    int _tileTextureWidths[2], _tileTextureHeights[2];
+    unsigned int _tileDepthTextures[2]; // only for sort-last: depth textures for the tile textures
+    QRect _tileRect;                // only for sort-last tile proxies: screen area covered by the partition
+    QVRDepthCompositor* _tileCompositor; // only for sort-last tiled windows
+    unsigned int _tileFbo;          // main context framebuffer for tile transfers
+    unsigned int _tilePbo;          // only for tile proxies: pixel pack buffer for the tile readback
+    int _tilePboSize;
+    void* _tileFence;               // only for tile proxies: GLsync of the tile readback, NULL if none
+    qint64 _tileRenderStart;        // QVRTimer timestamp at which rendering of the tile started
+    float _tileRenderTime;          // render time of the tile in the current frame
     unsigned int _outputQuadVao;
     QOpenGLShaderProgram* _outputPrg;
     bool (*_outputPluginInitFunc)(QVRWindow*, const QStringList&);
@@ -83,23 +123,45 @@ private:
     QVRRenderContext _renderContext;
 
     bool isMain() const;
-    void screenWall(QVector3D& cornerBottomLeft, QVector3D& cornerBottomRight, QVector3D& cornerTopLeft);
+    void screenWall(QVector3D& cornerBottomLeft, QVector3D& cornerBottomRight, QVector3D& cornerTopLeft,
+            bool applyObserver = true);
 
     // to be called from _thread:
     void renderOutput();
+    void applyPoseChange(QVRRenderContext& context,
+            const QVector3D& oldPos, const QQuaternion& oldRot,
+            const QVector3D& newPos, const QQuaternion& newRot) const;
 
     // to be called by QVRManager from the main thread:
     bool isValid() const { return _isValid; }
+    bool isRenderFrame() const;
+    bool wantsRendering() const;
+    bool supportsLayeredViews() const;
+    bool isTiled() const;
+    bool isTileProxy() const;
+    bool isStreamSource() const;
+    bool isStreamTarget() const;
+    bool isProxy() const;
+    bool isSortLast() const;
+    void updateTileRect(bool haveBounds, const QVector3D& minCorner, const QVector3D& maxCorner);
     void computeRenderContext(float n, float f);
     QVRRenderContext& renderContext() { return _renderContext; }
     void getTextures(unsigned int textures[2]);
+    void getTileTextures(unsigned int textures[2]);
+    QRect tileTransferRect() const;
+    void startTileReadback();
+    void readTile(QByteArray* tileData);
+    void compositeTiles(const QVector<QByteArray>& tileData);
+    bool setStreamFrame(const QByteArray& frameData);
     void exitGL();
+    void exitOutputGL();
     void renderToScreen();
     void asyncSwapBuffers();
     void waitForSwapBuffers();
 
     // to be called from _thread and QVRManager:
     QOpenGLContext* winContext() { return _winContext; }
+    QSurface* surface();
 
     // to be called from the constructor:
     bool initGL();
@@ -107,6 +169,7 @@ private:
     /*! \cond
      * This is internal information. */
     friend class QVRWindowThread;
+    friend class QVRRenderWorker;
     friend class QVRManager;
     /*! \endcond */
 
@@ -156,6 +219,26 @@ public:
     const QString& observerId() const;
     /*! \brief Returns the configuration of the window observer in the QVR configuration. */
     const QVRObserverConfig& observerConfig() const;
+
+    /*! \brief Returns whether the views of this window are layers of a single 2D array texture.
+     *
+     * This is the case if the application requested it via \a QVRApp::wantLayeredViews()
+     * and the output mode of the window allows it. See \a QVRApp::render().
+     */
+    bool layeredViews() const;
+
+    /*! \brief Returns the depth texture for the given view, or 0.
+     *
+     * Windows with sort-last compositing (see \a QVRWindowConfig::tileCompositing())
+     * and windows with depth-based reprojection (see \a QVRWindowConfig::reprojection())
+     * or temporal upscaling (see \a QVRWindowConfig::temporalUpscaling()) provide a depth texture of the same size as the view texture for each view.
+     * \a QVRApp::render() must attach it as the depth buffer of its framebuffer object,
+     * so that libqvr can composite the results of all participating processes,
+     * reproject the views to a newer pose, or accumulate them over frames. For all other windows, this function returns 0.
+     *
+     * Only valid during \a QVRApp::render().
+     */
+    unsigned int depthTexture(int view) const;
 };
 
 #endif
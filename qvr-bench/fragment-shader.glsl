@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#version 330
+
+uniform int layer;
+uniform int iterations;
+
+layout(location = 0) out vec4 fcolor;
+
+void main(void)
+{
+    // Deliberately expensive per-fragment work for the fill-rate workload.
+    vec2 p = gl_FragCoord.xy * 0.01 + float(layer);
+    float v = 0.0;
+    for (int i = 0; i < iterations; i++) {
+        v += sin(p.x + float(i)) * cos(p.y - float(i));
+        p = p.yx * 1.01 + v * 0.001;
+    }
+    fcolor = vec4(fract(v), fract(v * 0.5), fract(v * 0.25), 1.0 / 16.0);
+}
@@ -0,0 +1,929 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QProcess>
+#include <QTemporaryFile>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QRandomGenerator>
+
+#include <qvr/manager.hpp>
+#include <qvr/window.hpp>
+#include <qvr/frustum.hpp>
+
+#include "qvr-bench.hpp"
+
+// See QVRBenchCullReference()
+#if defined(__clang__)
+# pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+# pragma fp_contract(off)
+#endif
+
+
+static const int QVRBenchFillLayers = 16;           // full-screen layers per view in the fill workload
+static const int QVRBenchFillIterations = 32;       // fragment shader loop iterations per layer
+static const int QVRBenchEventDevices = 64;         // synthetic devices in the events workload
+static const int QVRBenchEventsPerWindow = 8;       // mouse moves and key press/release pairs per window and frame
+
+static const char* QVRBenchWorkloadNames[] = { "null", "fill", "data", "events" };
+static const char* QVRBenchPhaseNames[] = { "prepare", "serialize", "render", "events", "sync" };
+
+/* Heap allocation counting for --bench-allocations. Only the main thread is
+ * counted, since render and presentation threads are not part of the main
+ * loop. Qt containers allocate with malloc(), so with glibc the malloc family
+ * is wrapped; elsewhere only operator new can be seen. */
+static bool QVRBenchCountAllocations = false;
+static thread_local bool QVRBenchIsMainThread = false;
+static qint64 QVRBenchAllocations = 0;
+
+static inline void QVRBenchCountAllocation()
+{
+    if (QVRBenchCountAllocations && QVRBenchIsMainThread)
+        QVRBenchAllocations++;
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* malloc(size_t size) __THROW
+{
+    QVRBenchCountAllocation();
+    return __libc_malloc(size);
+}
+void* calloc(size_t n, size_t size) __THROW
+{
+    QVRBenchCountAllocation();
+    return __libc_calloc(n, size);
+}
+void* realloc(void* ptr, size_t size) __THROW
+{
+    QVRBenchCountAllocation();
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+void* operator new(std::size_t size)
+{
+    QVRBenchCountAllocation();
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+static bool QVRBenchWorkloadFromName(const QString& name, QVRBenchWorkload* workload)
+{
+    for (int i = 0; i < 4; i++) {
+        if (name == QVRBenchWorkloadNames[i]) {
+            *workload = static_cast<QVRBenchWorkload>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static float QVRBenchMsecs(qint64 start, qint64 end)
+{
+    return (end - start) / 1e6f;
+}
+
+static QJsonObject QVRBenchStatistics(QVector<float> values)
+{
+    QJsonObject stats;
+    if (values.isEmpty())
+        return stats;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (int i = 0; i < values.size(); i++)
+        sum += values[i];
+    auto percentile = [&values](double q) -> double {
+        return values[qMin(int(values.size()) - 1, int(q * (values.size() - 1) + 0.5))];
+    };
+    stats["mean"] = sum / values.size();
+    stats["min"] = values.first();
+    stats["p50"] = percentile(0.50);
+    stats["p90"] = percentile(0.90);
+    stats["p95"] = percentile(0.95);
+    stats["p99"] = percentile(0.99);
+    stats["max"] = values.last();
+    return stats;
+}
+
+static bool QVRBenchWriteFile(const QString& filename, const QByteArray& data)
+{
+    if (filename.isEmpty()) {
+        return (std::fwrite(data.constData(), data.size(), 1, stdout) == 1 && std::fflush(stdout) == 0);
+    } else {
+        QFile f(filename);
+        return (f.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                && f.write(data) == data.size()
+                && f.flush());
+    }
+}
+
+QVRBench::QVRBench(QVRBenchWorkload workload, int warmupFrames, int frames, int dataSize,
+        const QString& reportFilename, const QJsonObject& configuration,
+        bool countAllocations) :
+    _workload(workload),
+    _warmupFrames(warmupFrames),
+    _frames(frames),
+    _reportFilename(reportFilename),
+    _configuration(configuration),
+    _countAllocations(countAllocations),
+    _frameIndex(0),
+    _frameStart(0),
+    _serializeStart(-1),
+    _serializeEnd(-1),
+    _renderStart(0),
+    _renderEnd(0),
+    _updateStart(0),
+    _updateEnd(0),
+    _measureStart(0),
+    _frameStartAllocations(0),
+    _serializeStartAllocations(0),
+    _serializeEndAllocations(0),
+    _renderStartAllocations(0),
+    _renderEndAllocations(0),
+    _updateStartAllocations(0),
+    _updateEndAllocations(0),
+    _visibleSetAllocations(0),
+    _failed(false),
+    _eventCount(0),
+    _frameCounter(0)
+{
+    if (_workload == QVRBenchData)
+        _data.fill(0, dataSize);
+    // recording the measurements must not allocate by itself
+    _frameTimes.reserve(_frames);
+    for (int i = 0; i < QVRBenchPhaseCount; i++)
+        _phaseTimes[i].reserve(_frames);
+    if (_countAllocations) {
+        _frameAllocations.reserve(_frames);
+        for (int i = 0; i < QVRBenchPhaseCount; i++)
+            _phaseAllocations[i].reserve(_frames);
+        _trackingAllocations.reserve(_frames);
+        QVRBenchIsMainThread = true;
+        QVRBenchCountAllocations = true;
+    }
+    _timer.start();
+}
+
+bool QVRBench::initProcess(QVRProcess* /* p */)
+{
+    initializeOpenGLFunctions();
+
+    glGenFramebuffers(1, &_fbo);
+    // The fill workload generates its full-screen triangle from gl_VertexID,
+    // but a core profile still requires a vertex array object to be bound.
+    glGenVertexArrays(1, &_vao);
+
+    if (_workload == QVRBenchFill) {
+        if (!_prg.addShaderFromSourceFile(QOpenGLShader::Vertex, ":vertex-shader.glsl")
+                || !_prg.addShaderFromSourceFile(QOpenGLShader::Fragment, ":fragment-shader.glsl")
+                || !_prg.link()) {
+            return false;
+        }
+    }
+
+    if (QVRManager::processIndex() == 0)
+        _glRenderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    return true;
+}
+
+void QVRBench::preRenderProcess(QVRProcess* /* p */)
+{
+    _renderStart = _timer.nsecsElapsed();
+    _renderStartAllocations = QVRBenchAllocations;
+}
+
+void QVRBench::updateProcessVisibleSet(QVRProcess* /* p */,
+        const QVector4D* /* cullingPlanes */, int /* cullingPlaneCount */)
+{
+    _visibleSetAllocations = QVRBenchAllocations;
+}
+
+void QVRBench::postRenderProcess(QVRProcess* /* p */)
+{
+    _renderEnd = _timer.nsecsElapsed();
+    _renderEndAllocations = QVRBenchAllocations;
+}
+
+void QVRBench::preRenderWindow(QVRWindow* w)
+{
+    if (_workload == QVRBenchEvents) {
+        // Feed the window the same way the windowing system would; the events
+        // travel through the QVR event queue (and from child processes to the
+        // main process) before they reach the handlers below.
+        int width = qMax(1, w->width());
+        int height = qMax(1, w->height());
+        for (int i = 0; i < QVRBenchEventsPerWindow; i++) {
+            QPointF pos((_frameCounter * QVRBenchEventsPerWindow + i) % width, (_frameCounter + i) % height);
+            QCoreApplication::postEvent(w, new QMouseEvent(QEvent::MouseMove, pos, pos,
+                        Qt::NoButton, Qt::NoButton, Qt::NoModifier));
+            QCoreApplication::postEvent(w, new QKeyEvent(QEvent::KeyPress, Qt::Key_Space, Qt::NoModifier));
+            QCoreApplication::postEvent(w, new QKeyEvent(QEvent::KeyRelease, Qt::Key_Space, Qt::NoModifier));
+        }
+    }
+}
+
+void QVRBench::render(QVRWindow* /* w */,
+        const QVRRenderContext& context, const unsigned int* textures)
+{
+    for (int view = 0; view < context.viewCount(); view++) {
+        int width = context.textureSize(view).width();
+        int height = context.textureSize(view).height();
+        glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[view], 0);
+        glViewport(0, 0, width, height);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (_workload == QVRBenchFill) {
+            glUseProgram(_prg.programId());
+            _prg.setUniformValue("iterations", QVRBenchFillIterations);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glBindVertexArray(_vao);
+            for (int layer = 0; layer < QVRBenchFillLayers; layer++) {
+                _prg.setUniformValue("layer", layer);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+            glDisable(GL_BLEND);
+        }
+    }
+}
+
+void QVRBench::update(const QList<QVRObserver*>&)
+{
+    _updateStart = _timer.nsecsElapsed();
+    _updateStartAllocations = QVRBenchAllocations;
+    _frameCounter++;
+    if (_workload == QVRBenchData && _data.size() > 0) {
+        // change the data every frame so that nothing can skip the transfer
+        _data[_frameCounter % _data.size()] = static_cast<char>(_frameCounter);
+    }
+    _updateEnd = _timer.nsecsElapsed();
+    _updateEndAllocations = QVRBenchAllocations;
+}
+
+void QVRBench::recordFrame(qint64 frameEnd)
+{
+    bool haveSerialization = (_serializeStart >= _frameStart);
+    qint64 prepareEnd = (haveSerialization ? _serializeStart : _renderStart);
+    _frameTimes.append(QVRBenchMsecs(_frameStart, frameEnd));
+    _phaseTimes[QVRBenchPhasePrepare].append(QVRBenchMsecs(_frameStart, prepareEnd));
+    _phaseTimes[QVRBenchPhaseSerialize].append(haveSerialization ? QVRBenchMsecs(_serializeStart, _serializeEnd) : 0.0f);
+    _phaseTimes[QVRBenchPhaseRender].append(QVRBenchMsecs(_renderStart, _renderEnd));
+    _phaseTimes[QVRBenchPhaseEvents].append(QVRBenchMsecs(_renderEnd, _updateStart));
+    _phaseTimes[QVRBenchPhaseSync].append(QVRBenchMsecs(_updateEnd, frameEnd));
+    if (_countAllocations) {
+        qint64 frameEndAllocations = QVRBenchAllocations;
+        qint64 prepareEndAllocations = (haveSerialization ? _serializeStartAllocations : _renderStartAllocations);
+        _frameAllocations.append(frameEndAllocations - _frameStartAllocations);
+        _phaseAllocations[QVRBenchPhasePrepare].append(prepareEndAllocations - _frameStartAllocations);
+        _phaseAllocations[QVRBenchPhaseSerialize].append(haveSerialization ? _serializeEndAllocations - _serializeStartAllocations : 0);
+        _phaseAllocations[QVRBenchPhaseRender].append(_renderEndAllocations - _renderStartAllocations);
+        _phaseAllocations[QVRBenchPhaseEvents].append(_updateStartAllocations - _renderEndAllocations);
+        _phaseAllocations[QVRBenchPhaseSync].append(frameEndAllocations - _updateEndAllocations);
+        _trackingAllocations.append(haveSerialization ? -1 : _visibleSetAllocations - _frameStartAllocations);
+    }
+}
+
+bool QVRBench::writeReport(qint64 measureEnd) const
+{
+    double seconds = (measureEnd - _measureStart) / 1e9;
+    QJsonObject report;
+    report["benchmark"] = "qvr-bench";
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["host"] = QSysInfo::machineHostName();
+    report["qt_version"] = qVersion();
+    report["gl_renderer"] = _glRenderer;
+    report["configuration"] = _configuration;
+    report["frames"] = _frameTimes.size();
+    report["seconds"] = seconds;
+    report["frames_per_second"] = (seconds > 0.0 ? _frameTimes.size() / seconds : 0.0);
+    report["events_per_frame"] = (_frameTimes.size() > 0 ? double(_eventCount) / _frameTimes.size() : 0.0);
+    report["frame_time_ms"] = QVRBenchStatistics(_frameTimes);
+    QJsonObject phases;
+    for (int i = 0; i < QVRBenchPhaseCount; i++)
+        phases[QVRBenchPhaseNames[i]] = QVRBenchStatistics(_phaseTimes[i]);
+    report["phase_time_ms"] = phases;
+    QJsonObject textures;
+    textures["bytes"] = double(QVRManager::viewTextureMemory());
+    textures["idle_bytes"] = double(QVRManager::idleViewTextureMemory());
+    textures["allocations"] = QVRManager::viewTextureAllocations();
+    textures["reuses"] = QVRManager::viewTextureReuses();
+    report["view_textures"] = textures;
+    if (_countAllocations) {
+        QJsonObject allocations;
+        allocations["frame"] = QVRBenchStatistics(_frameAllocations);
+        QJsonObject phaseAllocations;
+        for (int i = 0; i < QVRBenchPhaseCount; i++)
+            phaseAllocations[QVRBenchPhaseNames[i]] = QVRBenchStatistics(_phaseAllocations[i]);
+        allocations["phases"] = phaseAllocations;
+        if (QVRManager::processCount() == 1)
+            allocations["tracking"] = QVRBenchStatistics(_trackingAllocations);
+        report["allocations"] = allocations;
+    }
+    return QVRBenchWriteFile(_reportFilename, QJsonDocument(report).toJson());
+}
+
+bool QVRBench::checkAllocations() const
+{
+    // Without child processes, nothing from the start of a frame up to the
+    // determination of the process visible set may allocate: device and
+    // observer updates, late latching, render contexts, and culling planes.
+    // With child processes, the transfer to them allocates in QDataStream
+    // and the sockets, so there is nothing to check.
+    if (!_countAllocations || QVRManager::processCount() > 1)
+        return true;
+    for (int i = 0; i < _trackingAllocations.size(); i++) {
+        if (_trackingAllocations[i] > 0.0f) {
+            qCritical("Frame %d allocated %d times before updateProcessVisibleSet()",
+                    _warmupFrames + 1 + i, int(_trackingAllocations[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QVRBench::wantExit()
+{
+    // This is called at the start of each frame of the main process.
+    qint64 now = _timer.nsecsElapsed();
+    if (_frameIndex > _warmupFrames && _frameIndex <= _warmupFrames + _frames)
+        recordFrame(now);
+    else if (_frameIndex == _warmupFrames)
+        _measureStart = now;
+    if (_frameIndex >= _warmupFrames + _frames) {
+        if (_frameIndex == _warmupFrames + _frames) {
+            QVRBenchCountAllocations = false;
+            if (!writeReport(now)) {
+                qCritical("Cannot write benchmark report");
+                _failed = true;
+            }
+            if (!checkAllocations())
+                _failed = true;
+            _frameIndex++;
+        }
+        return true;
+    }
+    _frameIndex++;
+    _frameStart = now;
+    _frameStartAllocations = QVRBenchAllocations;
+    return false;
+}
+
+void QVRBench::serializeDynamicData(QDataStream& ds) const
+{
+    _serializeStart = _timer.nsecsElapsed();
+    _serializeStartAllocations = QVRBenchAllocations;
+    ds << _frameCounter;
+    if (_workload == QVRBenchData)
+        ds << _data;
+    _serializeEnd = _timer.nsecsElapsed();
+    _serializeEndAllocations = QVRBenchAllocations;
+}
+
+void QVRBench::deserializeDynamicData(QDataStream& ds)
+{
+    ds >> _frameCounter;
+    if (_workload == QVRBenchData)
+        ds >> _data;
+}
+
+void QVRBench::keyPressEvent(const QVRRenderContext& /* context */, QKeyEvent* /* event */)
+{
+    if (_frameIndex > _warmupFrames)
+        _eventCount++;
+}
+
+void QVRBench::keyReleaseEvent(const QVRRenderContext& /* context */, QKeyEvent* /* event */)
+{
+    if (_frameIndex > _warmupFrames)
+        _eventCount++;
+}
+
+void QVRBench::mouseMoveEvent(const QVRRenderContext& /* context */, QMouseEvent* /* event */)
+{
+    if (_frameIndex > _warmupFrames)
+        _eventCount++;
+}
+
+void QVRBench::deviceButtonPressEvent(QVRDeviceEvent* /* event */)
+{
+    if (_frameIndex > _warmupFrames)
+        _eventCount++;
+}
+
+void QVRBench::deviceButtonReleaseEvent(QVRDeviceEvent* /* event */)
+{
+    if (_frameIndex > _warmupFrames)
+        _eventCount++;
+}
+
+void QVRBench::deviceAnalogChangeEvent(QVRDeviceEvent* /* event */)
+{
+    if (_frameIndex > _warmupFrames)
+        _eventCount++;
+}
+
+/* Generate a QVR configuration: one observer, all windows offscreen. */
+static QString QVRBenchConfigText(int processes, int windows, const QString& ipc,
+        QVRBenchWorkload workload, int width, int height)
+{
+    QString s;
+    QTextStream ts(&s);
+    if (workload == QVRBenchEvents) {
+        for (int d = 0; d < QVRBenchEventDevices; d++) {
+            ts << "device synthetic" << d << "\n";
+            ts << "    tracking synthetic orbit\n";
+            ts << "    buttons synthetic 20\n";
+            ts << "    analogs synthetic 2\n";
+        }
+    }
+    ts << "observer bench\n";
+    for (int p = 0; p < processes; p++) {
+        ts << "process " << (p == 0 ? QString("main") : QString("child%1").arg(p)) << "\n";
+        if (p == 0 && processes > 1)
+            ts << "    ipc " << ipc << "\n";
+        ts << "    sync_to_vblank false\n";
+        for (int w = 0; w < windows; w++) {
+            ts << "    window p" << p << "w" << w << "\n";
+            ts << "        observer bench\n";
+            ts << "        output offscreen\n";
+            ts << "        size " << width << " " << height << "\n";
+        }
+    }
+    return s;
+}
+
+static QJsonObject QVRBenchConfiguration(int processes, int windows, const QString& ipc,
+        QVRBenchWorkload workload, int width, int height, int warmupFrames, int frames, int dataSize)
+{
+    QJsonObject cfg;
+    if (processes > 0) {
+        cfg["processes"] = processes;
+        cfg["windows_per_process"] = windows;
+        cfg["ipc"] = (processes > 1 ? ipc : QString("none"));
+        cfg["window_size"] = QString("%1x%2").arg(width).arg(height);
+    } else {
+        cfg["processes"] = "custom configuration";
+    }
+    cfg["workload"] = QVRBenchWorkloadNames[workload];
+    cfg["warmup_frames"] = warmupFrames;
+    cfg["frames"] = frames;
+    if (workload == QVRBenchData)
+        cfg["data_size"] = dataSize;
+    return cfg;
+}
+
+/* Microbenchmark for the frustum culling primitives; does not need QVR to be initialized. */
+static int QVRBenchCulling(int objects, const QString& reportFilename)
+{
+    QRandomGenerator rng(1);
+    std::vector<float> x(objects), y(objects), z(objects), r(objects);
+    std::vector<float> minX(objects), minY(objects), minZ(objects), maxX(objects), maxY(objects), maxZ(objects);
+    for (int i = 0; i < objects; i++) {
+        x[i] = rng.bounded(100.0) - 50.0;
+        y[i] = rng.bounded(100.0) - 50.0;
+        z[i] = rng.bounded(100.0) - 50.0;
+        r[i] = 0.1 + rng.bounded(0.9);
+        minX[i] = x[i] - r[i];
+        minY[i] = y[i] - r[i];
+        minZ[i] = z[i] - r[i];
+        maxX[i] = x[i] + r[i];
+        maxY[i] = y[i] + r[i];
+        maxZ[i] = z[i] + r[i];
+    }
+    std::vector<quint32> visibility((objects + 31) / 32);
+    QVRFrustum frustum(-0.1f, +0.1f, -0.075f, +0.075f, 0.1f, 100.0f);
+    QMatrix4x4 viewMatrix;
+    viewMatrix.rotate(30.0f, 0.0f, 1.0f, 0.0f);
+    QVector4D planes[6];
+    frustum.getCullingPlanes(viewMatrix, planes);
+
+    QJsonObject report;
+    report["benchmark"] = "qvr-bench-culling";
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["host"] = QSysInfo::machineHostName();
+    report["implementation"] = QVRFrustum::cullingImplementation();
+    report["objects"] = objects;
+    for (int type = 0; type < 2; type++) {
+        // repeat for at least half a second to get stable numbers
+        QElapsedTimer timer;
+        timer.start();
+        qint64 repetitions = 0;
+        do {
+            if (type == 0)
+                QVRFrustum::cullSpheres(planes, 6, objects, x.data(), y.data(), z.data(), r.data(), visibility.data());
+            else
+                QVRFrustum::cullBoxes(planes, 6, objects, minX.data(), minY.data(), minZ.data(),
+                        maxX.data(), maxY.data(), maxZ.data(), visibility.data());
+            repetitions++;
+        } while (timer.nsecsElapsed() < 500000000);
+        qint64 nsecs = timer.nsecsElapsed();
+        int visible = 0;
+        for (int i = 0; i < objects; i++)
+            visible += (visibility[i / 32] >> (i % 32)) & 1;
+        QJsonObject result;
+        result["nsecs_per_object"] = double(nsecs) / (double(repetitions) * objects);
+        result["visible_fraction"] = double(visible) / objects;
+        report[type == 0 ? "spheres" : "boxes"] = result;
+    }
+    if (!QVRBenchWriteFile(reportFilename, QJsonDocument(report).toJson())) {
+        std::fprintf(stderr, "qvr-bench: cannot write report\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* Scalar reference for the culling check: the same operations in the same order as
+ * in the libqvr kernels. Like libqvr, this file must be compiled without floating
+ * point contraction, otherwise the compiler may fuse them into FMA instructions. */
+static bool QVRBenchCullReference(const QVector4D* planes, int planeCount,
+        const float* x, const float* y, const float* z, float radius)
+{
+    for (int p = 0; p < planeCount; p++) {
+        float d = planes[p].w() + radius;
+        d += planes[p].x() * x[p];
+        d += planes[p].y() * y[p];
+        d += planes[p].z() * z[p];
+        if (!(d >= 0.0f))
+            return false;
+    }
+    return true;
+}
+
+/* Check that the culling primitives give exactly the result of the scalar reference.
+ * The vector kernels process groups of 8 (AVX) or 4 (SSE, NEON) objects and the
+ * scalar code handles the rest, so culling every count and start offset of the
+ * object arrays runs each object through each code path. Many objects touch a
+ * plane, where different rounding would change the result. */
+static int QVRBenchCheckCulling(const QString& reportFilename)
+{
+    const int objects = 256;
+    const int maxOffset = 8;
+    QRandomGenerator rng(2);
+    QVRFrustum frustum(-0.1f, +0.1f, -0.075f, +0.075f, 0.1f, 100.0f);
+    QMatrix4x4 viewMatrix;
+    viewMatrix.rotate(30.0f, 0.0f, 1.0f, 0.0f);
+    viewMatrix.translate(1.0f, -0.5f, 2.0f);
+    QVector4D planes[6];
+    frustum.getCullingPlanes(viewMatrix, planes);
+    std::vector<float> x(objects), y(objects), z(objects), r(objects);
+    std::vector<float> minX(objects), minY(objects), minZ(objects), maxX(objects), maxY(objects), maxZ(objects);
+    for (int i = 0; i < objects; i++) {
+        QVector3D c(rng.bounded(40.0) - 20.0, rng.bounded(40.0) - 20.0, rng.bounded(40.0) - 50.0);
+        QVector3D h(0.1 + rng.bounded(0.9), 0.1 + rng.bounded(0.9), 0.1 + rng.bounded(0.9));
+        float radius = h.length();
+        if (i % 2 == 1) {
+            // move the object onto one of the planes
+            const QVector4D& plane = planes[rng.bounded(6)];
+            QVector3D n = plane.toVector3D();
+            float sphereDist = QVector3D::dotProduct(n, c) + plane.w() + radius;
+            float boxDist = QVector3D::dotProduct(n, c) + plane.w()
+                + qAbs(n.x()) * h.x() + qAbs(n.y()) * h.y() + qAbs(n.z()) * h.z();
+            x[i] = c.x() - sphereDist * n.x();
+            y[i] = c.y() - sphereDist * n.y();
+            z[i] = c.z() - sphereDist * n.z();
+            c -= boxDist * n;
+        } else {
+            x[i] = c.x();
+            y[i] = c.y();
+            z[i] = c.z();
+        }
+        r[i] = radius;
+        minX[i] = c.x() - h.x();
+        minY[i] = c.y() - h.y();
+        minZ[i] = c.z() - h.z();
+        maxX[i] = c.x() + h.x();
+        maxY[i] = c.y() + h.y();
+        maxZ[i] = c.z() + h.z();
+    }
+    // reference results
+    std::vector<bool> sphereVisible(objects), boxVisible(objects);
+    for (int i = 0; i < objects; i++) {
+        float sx[6], sy[6], sz[6], bx[6], by[6], bz[6];
+        for (int p = 0; p < 6; p++) {
+            sx[p] = x[i];
+            sy[p] = y[i];
+            sz[p] = z[i];
+            bx[p] = (planes[p].x() >= 0.0f ? maxX[i] : minX[i]);
+            by[p] = (planes[p].y() >= 0.0f ? maxY[i] : minY[i]);
+            bz[p] = (planes[p].z() >= 0.0f ? maxZ[i] : minZ[i]);
+        }
+        sphereVisible[i] = QVRBenchCullReference(planes, 6, sx, sy, sz, r[i]);
+        boxVisible[i] = QVRBenchCullReference(planes, 6, bx, by, bz, 0.0f);
+    }
+
+    std::vector<quint32> visibility((objects + 31) / 32);
+    qint64 tests = 0;
+    int mismatches = 0;
+    for (int type = 0; type < 2; type++) {
+        for (int offset = 0; offset < maxOffset; offset++) {
+            for (int count = 0; offset + count <= objects; count++) {
+                // fill with garbage to detect bits that are not set or cleared
+                std::fill(visibility.begin(), visibility.end(), 0xdeadbeefu);
+                if (type == 0)
+                    QVRFrustum::cullSpheres(planes, 6, count, x.data() + offset, y.data() + offset, z.data() + offset,
+                            r.data() + offset, visibility.data());
+                else
+                    QVRFrustum::cullBoxes(planes, 6, count, minX.data() + offset, minY.data() + offset, minZ.data() + offset,
+                            maxX.data() + offset, maxY.data() + offset, maxZ.data() + offset, visibility.data());
+                for (int i = 0; i < (count + 31) / 32 * 32; i++) {
+                    bool result = (visibility[i / 32] >> (i % 32)) & 1;
+                    bool expected = (i < count && (type == 0 ? sphereVisible : boxVisible)[offset + i]);
+                    tests++;
+                    if (result != expected) {
+                        if (mismatches < 10) {
+                            std::fprintf(stderr, "qvr-bench: %s %d (count %d, offset %d): got %d, expected %d\n",
+                                    type == 0 ? "sphere" : "box", offset + i, count, offset, int(result), int(expected));
+                        }
+                        mismatches++;
+                    }
+                }
+            }
+        }
+    }
+    int visibleSpheres = std::count(sphereVisible.begin(), sphereVisible.end(), true);
+    int visibleBoxes = std::count(boxVisible.begin(), boxVisible.end(), true);
+
+    QJsonObject report;
+    report["benchmark"] = "qvr-bench-check-culling";
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["host"] = QSysInfo::machineHostName();
+    report["implementation"] = QVRFrustum::cullingImplementation();
+    report["objects"] = objects;
+    report["visible_spheres"] = visibleSpheres;
+    report["visible_boxes"] = visibleBoxes;
+    report["tests"] = double(tests);
+    report["mismatches"] = mismatches;
+    if (!QVRBenchWriteFile(reportFilename, QJsonDocument(report).toJson())) {
+        std::fprintf(stderr, "qvr-bench: cannot write report\n");
+        return 1;
+    }
+    return (mismatches == 0 ? 0 : 1);
+}
+
+int main(int argc, char* argv[])
+{
+    /* Parse the benchmark options. They stay on the command line so that
+     * QVR passes them on to the child processes. */
+    QStringList processesList("1");
+    QStringList windowsList("1");
+    QStringList ipcList("shared-memory");
+    QStringList workloadList("null");
+    int warmupFrames = 60;
+    int frames = 600;
+    int width = 800;
+    int height = 600;
+    int dataSize = 16 * 1024 * 1024;
+    int cullingObjects = 0;
+    bool checkCulling = false;
+    bool countAllocations = false;
+    QString reportFilename;
+    bool haveConfig = false;  // the user or QVR gave a configuration file
+    bool isQVRChild = false;  // we were launched by QVR as a child process
+    QStringList forwardedArgs;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--bench-suite") == 0) {
+            processesList = QStringList({ "1", "2", "4", "8" });
+            windowsList = QStringList({ "1", "4", "16" });
+            ipcList = QStringList({ "shared-memory", "local-socket", "tcp-socket" });
+            workloadList = QStringList({ "null", "fill", "data", "events" });
+        } else if (strncmp(arg, "--bench-processes=", 18) == 0) {
+            processesList = QString(arg + 18).split(',', Qt::SkipEmptyParts);
+        } else if (strncmp(arg, "--bench-windows=", 16) == 0) {
+            windowsList = QString(arg + 16).split(',', Qt::SkipEmptyParts);
+        } else if (strncmp(arg, "--bench-ipc=", 12) == 0) {
+            ipcList = QString(arg + 12).split(',', Qt::SkipEmptyParts);
+        } else if (strncmp(arg, "--bench-workload=", 17) == 0) {
+            workloadList = QString(arg + 17).split(',', Qt::SkipEmptyParts);
+        } else if (strncmp(arg, "--bench-warmup=", 15) == 0) {
+            warmupFrames = ::atoi(arg + 15);
+        } else if (strncmp(arg, "--bench-frames=", 15) == 0) {
+            frames = ::atoi(arg + 15);
+        } else if (strncmp(arg, "--bench-size=", 13) == 0) {
+            if (std::sscanf(arg + 13, "%dx%d", &width, &height) != 2)
+                width = height = 0;
+        } else if (strncmp(arg, "--bench-data-size=", 18) == 0) {
+            dataSize = ::atoi(arg + 18);
+        } else if (strcmp(arg, "--bench-culling") == 0) {
+            cullingObjects = 100000;
+        } else if (strncmp(arg, "--bench-culling=", 16) == 0) {
+            cullingObjects = ::atoi(arg + 16);
+        } else if (strcmp(arg, "--check-culling") == 0) {
+            checkCulling = true;
+        } else if (strcmp(arg, "--bench-allocations") == 0) {
+            countAllocations = true;
+        } else if (strncmp(arg, "--bench-report=", 15) == 0) {
+            reportFilename = arg + 15;
+        } else {
+            if (strncmp(arg, "--qvr-config", 12) == 0)
+                haveConfig = true;
+            else if (strncmp(arg, "--qvr-process=", 14) == 0)
+                isQVRChild = true;
+            forwardedArgs << arg;
+        }
+    }
+    if (checkCulling)
+        return QVRBenchCheckCulling(reportFilename);
+    if (cullingObjects > 0)
+        return QVRBenchCulling(cullingObjects, reportFilename);
+    if (warmupFrames < 0 || frames < 1 || width < 1 || height < 1 || dataSize < 0) {
+        std::fprintf(stderr, "qvr-bench: invalid frame count, window size, or data size\n");
+        return 1;
+    }
+    QList<QVRBenchWorkload> workloads;
+    for (int i = 0; i < workloadList.size(); i++) {
+        QVRBenchWorkload workload;
+        if (!QVRBenchWorkloadFromName(workloadList[i], &workload)) {
+            std::fprintf(stderr, "qvr-bench: invalid workload %s\n", qPrintable(workloadList[i]));
+            return 1;
+        }
+        workloads.append(workload);
+    }
+    QList<int> processCounts, windowCounts;
+    for (int i = 0; i < processesList.size(); i++)
+        processCounts.append(processesList[i].toInt());
+    for (int i = 0; i < windowsList.size(); i++)
+        windowCounts.append(windowsList[i].toInt());
+    if (workloads.isEmpty() || processCounts.isEmpty() || windowCounts.isEmpty() || ipcList.isEmpty()
+            || *std::min_element(processCounts.begin(), processCounts.end()) < 1
+            || *std::min_element(windowCounts.begin(), windowCounts.end()) < 1) {
+        std::fprintf(stderr, "qvr-bench: invalid process count, window count, or ipc list\n");
+        return 1;
+    }
+    for (int i = 0; i < ipcList.size(); i++) {
+        if (ipcList[i] != "shared-memory" && ipcList[i] != "local-socket" && ipcList[i] != "tcp-socket") {
+            std::fprintf(stderr, "qvr-bench: invalid ipc method %s\n", qPrintable(ipcList[i]));
+            return 1;
+        }
+    }
+
+    /* All windows are offscreen; do not require a display unless the user asks for a platform. */
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    bool isSuite = (!haveConfig && !isQVRChild
+            && (workloads.size() > 1 || processCounts.size() > 1
+                || windowCounts.size() > 1 || ipcList.size() > 1));
+    if (isSuite) {
+        /* Run each combination in a fresh instance of ourselves, since there
+         * can only be one QVR manager per process, and collect the reports. */
+        QCoreApplication app(argc, argv);
+        QList<QStringList> runs;
+        for (int wl = 0; wl < workloads.size(); wl++) {
+            for (int p = 0; p < processCounts.size(); p++) {
+                for (int w = 0; w < windowCounts.size(); w++) {
+                    // the ipc method is irrelevant without child processes
+                    int ipcCount = (processCounts[p] > 1 ? ipcList.size() : 1);
+                    for (int i = 0; i < ipcCount; i++) {
+                        runs.append(QStringList({
+                                    QString("--bench-workload=%1").arg(QVRBenchWorkloadNames[workloads[wl]]),
+                                    QString("--bench-processes=%1").arg(processCounts[p]),
+                                    QString("--bench-windows=%1").arg(windowCounts[w]),
+                                    QString("--bench-ipc=%1").arg(ipcList[i]) }));
+                        if (countAllocations)
+                            runs.last() << "--bench-allocations";
+                    }
+                }
+            }
+        }
+        QJsonArray reports;
+        for (int r = 0; r < runs.size(); r++) {
+            QTemporaryFile runReport(QDir::tempPath() + "/qvr-bench-XXXXXX.json");
+            if (!runReport.open()) {
+                std::fprintf(stderr, "qvr-bench: cannot create temporary file\n");
+                return 1;
+            }
+            runReport.close();
+            QStringList args = runs[r];
+            args << QString("--bench-warmup=%1").arg(warmupFrames)
+                << QString("--bench-frames=%1").arg(frames)
+                << QString("--bench-size=%1x%2").arg(width).arg(height)
+                << QString("--bench-data-size=%1").arg(dataSize)
+                << QString("--bench-report=%1").arg(runReport.fileName())
+                << forwardedArgs;
+            std::fprintf(stderr, "qvr-bench: run %d/%d: %s\n", r + 1, int(runs.size()), qPrintable(runs[r].join(' ')));
+            QProcess process;
+            process.setProcessChannelMode(QProcess::ForwardedChannels);
+            process.start(QCoreApplication::applicationFilePath(), args);
+            bool ok = process.waitForFinished(-1)
+                && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+            QJsonDocument doc;
+            if (ok && runReport.open()) {
+                doc = QJsonDocument::fromJson(runReport.readAll());
+                runReport.close();
+            }
+            if (ok && doc.isObject()) {
+                reports.append(doc.object());
+            } else {
+                QJsonObject failure;
+                failure["arguments"] = runs[r].join(' ');
+                failure["error"] = "run failed";
+                reports.append(failure);
+            }
+        }
+        QJsonObject suite;
+        suite["benchmark"] = "qvr-bench";
+        suite["runs"] = reports;
+        if (!QVRBenchWriteFile(reportFilename, QJsonDocument(suite).toJson())) {
+            std::fprintf(stderr, "qvr-bench: cannot write report\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    /* A single run. */
+    QGuiApplication app(argc, argv);
+
+    int processes = processCounts[0];
+    int windows = windowCounts[0];
+    QString ipc = ipcList[0];
+    QVRBenchWorkload workload = workloads[0];
+
+    // Unless a configuration was given, generate one and hand it to QVR.
+    QTemporaryFile configFile(QDir::tempPath() + "/qvr-bench-XXXXXX.qvr");
+    QByteArray configArg;
+    std::vector<char*> qvrArgv(argv, argv + argc);
+    if (!haveConfig) {
+        if (!configFile.open()) {
+            qCritical("Cannot create temporary configuration file");
+            return 1;
+        }
+        configFile.write(QVRBenchConfigText(processes, windows, ipc, workload, width, height).toUtf8());
+        configFile.close();
+        configArg = QByteArray("--qvr-config=") + QFile::encodeName(configFile.fileName());
+        qvrArgv.push_back(configArg.data());
+    }
+    int qvrArgc = qvrArgv.size();
+    qvrArgv.push_back(NULL);
+    QVRManager manager(qvrArgc, qvrArgv.data());
+
+    QSurfaceFormat format;
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setVersion(3, 3);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QVRBench qvrapp(workload, warmupFrames, frames, dataSize, reportFilename,
+            QVRBenchConfiguration(haveConfig ? 0 : processes, windows, ipc, workload,
+                width, height, warmupFrames, frames, dataSize),
+            countAllocations && !isQVRChild);
+    if (!manager.init(&qvrapp)) {
+        qCritical("Cannot initialize QVR manager");
+        return 1;
+    }
+
+    int ret = app.exec();
+    return (ret == 0 && qvrapp.failed() ? 1 : ret);
+}
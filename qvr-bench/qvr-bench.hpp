@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2016 Computer Graphics Group, University of Siegen
+ * Written by Martin Lambers <martin.lambers@uni-siegen.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef QVR_BENCH_HPP
+#define QVR_BENCH_HPP
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QByteArray>
+#include <QVector>
+
+#include <qvr/app.hpp>
+
+/* The built-in workloads */
+typedef enum {
+    QVRBenchNull,       // only clear the view textures: measures pure framework overhead
+    QVRBenchFill,       // blend many full-screen layers with an expensive fragment shader
+    QVRBenchData,       // send a large dynamic data block to all child processes each frame
+    QVRBenchEvents      // many synthetic devices plus a storm of window events each frame
+} QVRBenchWorkload;
+
+/* The phases of a frame of the main process, as observed from the application hooks */
+typedef enum {
+    QVRBenchPhasePrepare,   // device and observer updates and their transfer to child processes
+    QVRBenchPhaseSerialize, // serialization of the dynamic data (only with child processes)
+    QVRBenchPhaseRender,    // preRenderProcess() to the end of postRenderProcess()
+    QVRBenchPhaseEvents,    // start of buffer swaps and event processing, until update()
+    QVRBenchPhaseSync,      // waiting for buffer swaps and child processes
+    QVRBenchPhaseCount
+} QVRBenchPhase;
+
+class QVRBench : public QVRApp, protected QOpenGLExtraFunctions
+{
+private:
+    /* Benchmark parameters */
+    QVRBenchWorkload _workload;
+    int _warmupFrames;
+    int _frames;
+    QString _reportFilename;
+    QJsonObject _configuration; // copied into the report
+    bool _countAllocations;
+
+    /* Measurements; only used in the main process */
+    QElapsedTimer _timer;
+    int _frameIndex;                    // number of frames started so far
+    qint64 _frameStart;                 // timestamps in nanoseconds within the current frame...
+    mutable qint64 _serializeStart;     // ...(serializeDynamicData() is const)
+    mutable qint64 _serializeEnd;
+    qint64 _renderStart;
+    qint64 _renderEnd;
+    qint64 _updateStart;
+    qint64 _updateEnd;
+    qint64 _measureStart;               // start of the first measured frame
+    QVector<float> _frameTimes;         // in milliseconds
+    QVector<float> _phaseTimes[QVRBenchPhaseCount];
+    qint64 _frameStartAllocations;      // heap allocation counts at the timestamps above
+    mutable qint64 _serializeStartAllocations;
+    mutable qint64 _serializeEndAllocations;
+    qint64 _renderStartAllocations;
+    qint64 _renderEndAllocations;
+    qint64 _updateStartAllocations;
+    qint64 _updateEndAllocations;
+    qint64 _visibleSetAllocations;      // at updateProcessVisibleSet()
+    QVector<float> _frameAllocations;
+    QVector<float> _phaseAllocations[QVRBenchPhaseCount];
+    QVector<float> _trackingAllocations; // from frame start to updateProcessVisibleSet()
+    bool _failed;
+    qint64 _eventCount;
+    QString _glRenderer;
+
+    /* Static data for rendering, initialized per process. */
+    unsigned int _fbo;
+    unsigned int _vao;
+    QOpenGLShaderProgram _prg;
+
+    /* Dynamic data. Needs to be serialized. */
+    unsigned int _frameCounter;
+    QByteArray _data;
+
+    void recordFrame(qint64 frameEnd);
+    bool writeReport(qint64 measureEnd) const;
+    bool checkAllocations() const;
+
+public:
+    QVRBench(QVRBenchWorkload workload, int warmupFrames, int frames, int dataSize,
+            const QString& reportFilename, const QJsonObject& configuration,
+            bool countAllocations);
+
+    bool failed() const { return _failed; }
+
+    bool initProcess(QVRProcess* p) override;
+    void preRenderProcess(QVRProcess* p) override;
+    void updateProcessVisibleSet(QVRProcess* p, const QVector4D* cullingPlanes, int cullingPlaneCount) override;
+    void postRenderProcess(QVRProcess* p) override;
+    void preRenderWindow(QVRWindow* w) override;
+
+    void render(QVRWindow* w, const QVRRenderContext& c, const unsigned int* textures) override;
+
+    void update(const QList<QVRObserver*>& observers) override;
+
+    bool wantExit() override;
+
+    void serializeDynamicData(QDataStream& ds) const override;
+    void deserializeDynamicData(QDataStream& ds) override;
+
+    void keyPressEvent(const QVRRenderContext& context, QKeyEvent* event) override;
+    void keyReleaseEvent(const QVRRenderContext& context, QKeyEvent* event) override;
+    void mouseMoveEvent(const QVRRenderContext& context, QMouseEvent* event) override;
+    void deviceButtonPressEvent(QVRDeviceEvent* event) override;
+    void deviceButtonReleaseEvent(QVRDeviceEvent* event) override;
+    void deviceAnalogChangeEvent(QVRDeviceEvent* event) override;
+};
+
+#endif